@@ -20,9 +20,15 @@ class AudioFeatureExtractor:
         self.paths = None       # np.ndarray
         self.latent_mat = None  # np.ndarray
 
-    def encode(self, waveform: torch.tensor) -> torch.tensor:
+    def encode(self, waveform: torch.tensor, sample_rate: int = 44100) -> torch.tensor:
+        return self.encode_mel(self.compute_mel(waveform, sample_rate))
+
+    @staticmethod
+    def compute_mel(waveform: torch.tensor, sample_rate: int = 44100) -> torch.tensor:
+        """ Computes the normalised Bx1x64x64 log-mel spectrograms of B waveforms,
+        the host does the same in MelSpectrogram.cpp. """
         waveform = torchaudio.transforms.Resample(
-            orig_freq=44100,
+            orig_freq=sample_rate,
             new_freq=22050
         )(waveform)
         mel = torchaudio.transforms.MelSpectrogram(
@@ -33,20 +39,25 @@ class AudioFeatureExtractor:
             n_fft=2048,
             hop_length=2048 // 2
         )(waveform)
-        mel = mel[0]
         # chop off the right-most column to make it 64x64
-        mel = mel[:, :-1]
-        mel = torch.reshape(mel, (1, 1, mel.size(0), mel.size(1)))
+        mel = mel[:, :, :-1]
+        mel = torch.reshape(mel, (mel.size(0), 1, mel.size(1), mel.size(2)))
 
-        # normalize
+        # normalize every spectrogram on its own
         mel = torch.log(mel + 1)
         maxes, _ = torch.max(mel.reshape(mel.size(0), -1), dim=1)
-        maxes = maxes.view(maxes.size(0), 1, 1)
-        mel /= maxes
+        maxes = maxes.view(maxes.size(0), 1, 1, 1)
+        # a silent buffer would otherwise be divided by zero
+        mel /= torch.clamp(maxes, min=1e-8)
+        return mel
+
+    def encode_mel(self, mel: torch.tensor) -> torch.tensor:
+        """ Encodes one or more spectrograms in one pass, returns a latent per row. """
+        mel = torch.reshape(mel, (-1, 1, 64, 64))
 
         # encode it into the latent space
         latent = self.model.encode(mel)
-        latent = torch.reshape(latent, (1, -1)).detach().numpy()
+        latent = torch.reshape(latent, (mel.size(0), -1)).detach().numpy()
 
         return latent
 
@@ -0,0 +1,99 @@
+""" Exports the encoder of the auto-encoder for LatentEncoder in the host, e.g.
+
+    python export_encoder.py models/auto-encoder-20201020050003.pt
+
+The file also holds a reference input and the output PyTorch gives for it, the host checks that
+it computes the same output every time it loads the file.
+"""
+import argparse
+import os
+import struct
+import sys
+from pathlib import Path
+
+import torch
+import torch.nn as nn
+
+from model import DivaAutoEncoder
+
+# The layout must match LatentEncoder.cpp in the host, all the values are little-endian.
+# header: magic, version, input channels, input height, input width, number of layers
+HEADER_FMT = '<4siiiii'
+MAGIC = b'IDEN'
+VERSION = 1
+INPUT_SHAPE = (1, 64, 64)
+
+LAYER_CONV2D = 1
+LAYER_RELU = 2
+LAYER_MAX_POOL2D = 3
+
+
+def default_output_path() -> Path:
+    """ The same place as LatentEncoder::getDefaultFile, juce::File::userApplicationDataDirectory/Ideator. """
+    if sys.platform == 'darwin':
+        app_data = Path.home() / 'Library'
+    elif sys.platform == 'win32':
+        app_data = Path(os.environ['APPDATA'])
+    else:
+        app_data = Path.home() / '.config'
+    return app_data / 'Ideator' / 'Encoder.bin'
+
+
+def pack_floats(tensor: torch.tensor) -> bytes:
+    values = tensor.detach().to(torch.float32).flatten().tolist()
+    return struct.pack(f'<{len(values)}f', *values)
+
+
+def pack_layer(layer: nn.Module) -> bytes:
+    if isinstance(layer, nn.Conv2d):
+        kernel_size, stride, padding = layer.kernel_size[0], layer.stride[0], layer.padding[0]
+        if (layer.kernel_size != (kernel_size, kernel_size) or layer.stride != (stride, stride)
+                or layer.padding != (padding, padding) or layer.dilation != (1, 1) or layer.groups != 1
+                or layer.bias is None or layer.padding_mode != 'zeros'):
+            raise ValueError(f'{layer} is not supported by the host')
+        return (struct.pack('<6i', LAYER_CONV2D, layer.in_channels, layer.out_channels,
+                            kernel_size, stride, padding)
+                + pack_floats(layer.weight) + pack_floats(layer.bias))
+
+    if isinstance(layer, nn.ReLU):
+        return struct.pack('<i', LAYER_RELU)
+
+    if isinstance(layer, nn.MaxPool2d):
+        if layer.padding != 0 or layer.dilation != 1 or layer.ceil_mode or not isinstance(layer.kernel_size, int):
+            raise ValueError(f'{layer} is not supported by the host')
+        stride = layer.stride if layer.stride is not None else layer.kernel_size
+        return struct.pack('<3i', LAYER_MAX_POOL2D, layer.kernel_size, stride)
+
+    raise ValueError(f'{layer} is not supported by the host')
+
+
+def export_encoder(model_path: str, output_path: Path) -> None:
+    model = DivaAutoEncoder()
+    model.load_state_dict(torch.load(model_path, map_location=torch.device('cpu')))
+    model.eval()
+
+    # a normalised log-mel spectrogram is between 0 and 1
+    generator = torch.Generator().manual_seed(0)
+    reference_input = torch.rand((1,) + INPUT_SHAPE, generator=generator)
+    with torch.no_grad():
+        reference_output = model.encode(reference_input)
+
+    data = struct.pack(HEADER_FMT, MAGIC, VERSION, *INPUT_SHAPE, len(model.encoder))
+    data += b''.join(pack_layer(layer) for layer in model.encoder)
+    data += struct.pack('<i', reference_input.numel()) + pack_floats(reference_input)
+    data += struct.pack('<i', reference_output.numel()) + pack_floats(reference_output)
+
+    output_path.parent.mkdir(parents=True, exist_ok=True)
+    with open(output_path, 'wb') as f:
+        f.write(data)
+    print(f'Exported {len(model.encoder)} layers to {output_path} ({len(data)} bytes)')
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument('model_path', nargs='?', default='models/auto-encoder-20201020050003.pt',
+                        help='the checkpoint of DivaAutoEncoder')
+    parser.add_argument('--output', type=Path, default=default_output_path(),
+                        help='where the host looks for the encoder by default')
+    args = parser.parse_args()
+    export_encoder(args.model_path, args.output)
@@ -0,0 +1,40 @@
+""" Writes the log-mel spectrogram torchaudio computes for a test signal, which the host compares
+with MelSpectrogram.cpp, e.g.
+
+    python export_mel_reference.py mel_reference.bin
+    Ideator-Cli --self-test --mel-reference mel_reference.bin
+
+The file holds the 64 x 64 values as little-endian float32, band by band.
+"""
+import argparse
+import math
+
+import torch
+
+from audio_feature_extractor import AudioFeatureExtractor
+
+# makeTestSignal in SelfTests.cpp in the host must give the same signal
+SAMPLE_RATE = 44100
+NUM_SAMPLES = 3 * SAMPLE_RATE
+
+
+def make_test_signal() -> torch.Tensor:
+    """ Two sines, the higher one fading in, so the spectrogram changes over time. """
+    n = torch.arange(NUM_SAMPLES, dtype=torch.float64)
+    signal = 0.5 * torch.sin(2 * math.pi * 440 * n / SAMPLE_RATE) \
+        + 0.25 * torch.sin(2 * math.pi * 3000 * n / SAMPLE_RATE) * n / NUM_SAMPLES
+    return signal.float().reshape(1, -1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Writes the reference log-mel spectrogram for Ideator-Cli --self-test')
+    parser.add_argument('output', help='the file to write')
+    args = parser.parse_args()
+
+    mel = AudioFeatureExtractor.compute_mel(make_test_signal(), SAMPLE_RATE)
+    mel.reshape(-1).numpy().astype('<f4').tofile(args.output)
+    print(f'Wrote {mel.numel()} values to {args.output}')
+
+
+if __name__ == '__main__':
+    main()
@@ -1,6 +1,10 @@
 from typing import List, Any
+import argparse
+import atexit
+import os
 import re
 
+import numpy as np
 import torch
 
 from pythonosc import udp_client
@@ -8,25 +12,71 @@ from pythonosc import osc_server
 from pythonosc import dispatcher
 
 from audio_feature_extractor import AudioFeatureExtractor
-from receive_audio_buffer import UdpBufferReceiver
+from receive_audio_buffer import UdpBufferReceiver, BufferLostError
+from receive_audio_stream import StreamBufferReceiver
 from preset_retriever import LibraryReceiver, PresetRetriever
+from shared_memory_ring import SharedMemoryRing
+
+# how long to wait for the audio buffer that belongs to a request, a lost buffer must not block forever
+RECEIVE_TIMEOUT = 10.0
+
+# the messages to the host are kept under this size, see OSC_MAX_MESSAGE_SIZE in Config.h
+MAX_MESSAGE_SIZE = 32768
+
+# what the buffer after an OSC message holds, see BufferContent in Utils.h
+CONTENT_AUDIO = 0
+CONTENT_MEL_SPECTROGRAM = 1
+CONTENT_LATENT = 2
+
+
+def encode_buffer(feature_extractor: AudioFeatureExtractor, buffer: np.array, content: int,
+                  num_presets: int = 1) -> np.array:
+    """ Encodes the concatenated buffers of one or more presets in one pass, returns a latent per row. """
+    buffer = buffer.reshape((num_presets, -1))
+    # the host encodes the presets itself when it has the exported encoder, see export_encoder.py
+    if content == CONTENT_LATENT:
+        return buffer
+    buffer = torch.from_numpy(buffer)
+    if content == CONTENT_MEL_SPECTROGRAM:
+        return feature_extractor.encode_mel(buffer)
+    return feature_extractor.encode(buffer)
 
 
 def analyze_library_callback(address: str,
                              args: List[Any],
                              *osc_args: List[Any]) -> None:
-    client, library_receiver, udp_buffer_receiver, preset_retriever = args
+    client, library_receiver, udp_buffer_receiver, feature_extractor, preset_retriever = args
     value = osc_args[0]
     preset_path = osc_args[1]
     descriptors = osc_args[2]
+    # the sequence number is also the id of the audio buffer, the host keeps several
+    # presets in flight, so the replies are allowed to be out of order
+    sequence_number = osc_args[3]
+    content = osc_args[4] if len(osc_args) > 4 else CONTENT_AUDIO
 
     # receive an audio buffer
     if value == 1:
-        buffer = udp_buffer_receiver.receive()
+        try:
+            buffer = udp_buffer_receiver.receive(sequence_number, timeout=RECEIVE_TIMEOUT)
+        except BufferLostError as e:
+            # reply anyway, so the host moves on to the next preset
+            print(f'Skipped {preset_path}: {e}')
+            client.send_message("/Ideator/cpp/analyze_library", [1, sequence_number])
+            return
+
+        descriptor_list = re.split('[^a-zA-Z]+', descriptors)
+        library_receiver.add_library_info(preset_path, descriptor_list,
+                                          encode_buffer(feature_extractor, buffer, content))
+        client.send_message("/Ideator/cpp/analyze_library", [1, sequence_number])
 
+    # the preset doesn't make any sound, so no audio buffer follows
+    elif value == 3:
         descriptor_list = re.split('[^a-zA-Z]+', descriptors)
-        library_receiver.add_library_info(preset_path, descriptor_list, buffer)
-        client.send_message("/Ideator/cpp/analyze_library", 1)
+        # the render spec of the host, which the silence is built from
+        sample_rate = int(osc_args[4])
+        num_samples = osc_args[5]
+        library_receiver.add_silent_preset(preset_path, descriptor_list, sample_rate, num_samples)
+        client.send_message("/Ideator/cpp/analyze_library", [1, sequence_number])
 
     # data receiving is over, save the library data
     elif value == 2:
@@ -36,17 +86,49 @@ def analyze_library_callback(address: str,
         print('Finished')
 
 
+def analyze_batch_callback(address: str,
+                           args: List[Any],
+                           *osc_args: List[Any]) -> None:
+    client, library_receiver, udp_buffer_receiver, feature_extractor = args
+    # the batch id is also the id of the buffer, which holds the buffers of all the presets
+    batch_id = osc_args[0]
+    content = osc_args[1]
+    preset_paths = list(osc_args[2::2])
+    descriptor_strings = list(osc_args[3::2])
+
+    try:
+        buffer = udp_buffer_receiver.receive(batch_id, timeout=RECEIVE_TIMEOUT)
+        latents = encode_buffer(feature_extractor, buffer, content, len(preset_paths))
+    except (BufferLostError, ValueError) as e:
+        # reply anyway, so the host moves on to the next batch
+        print(f'Skipped the batch of {len(preset_paths)} presets starting at {preset_paths[0]}: {e}')
+        client.send_message("/Ideator/cpp/analyze_batch", [batch_id] + [value for path in preset_paths
+                                                                       for value in (path, 0)])
+        return
+
+    for preset_path, descriptors, latent in zip(preset_paths, descriptor_strings, latents):
+        descriptor_list = re.split('[^a-zA-Z]+', descriptors)
+        library_receiver.add_library_info(preset_path, descriptor_list, latent.reshape((1, -1)))
+    # the results are keyed by the preset path
+    client.send_message("/Ideator/cpp/analyze_batch", [batch_id] + [value for path in preset_paths
+                                                                   for value in (path, 1)])
+
+
 def find_similar_callback(address: str,
                           args: List[Any],
                           *osc_args: List[Any]) -> None:
     client, udp_buffer_receiver, feature_extractor, preset_retriever = args
     value = osc_args[0]
-    # receive a buffer
-    buffer = udp_buffer_receiver.receive()
-    buffer = torch.from_numpy(buffer)
-    buffer = buffer.reshape((1, -1))
+    content = osc_args[1] if len(osc_args) > 1 else CONTENT_AUDIO
+    # the host never reuses an id, so a buffer that comes too late isn't taken for this one
+    buffer_id = osc_args[2] if len(osc_args) > 2 else -1
+    try:
+        buffer = udp_buffer_receiver.receive(buffer_id, timeout=RECEIVE_TIMEOUT)
+    except BufferLostError as e:
+        print(f'Cannot find similar presets: {e}')
+        return
     # extract latent features
-    preset_feature = feature_extractor.encode(buffer)
+    preset_feature = encode_buffer(feature_extractor, buffer, content)
     preset_feature = preset_feature.reshape(preset_feature.shape[1])
     # retrieve presets
     selected_paths = preset_retriever.retrieve_presets_by_features(preset_feature)
@@ -75,13 +157,17 @@ def retrieve_presets_callback(address: str,
 def auto_tag_callback(address: str,
                       args: List[Any],
                       *osc_args: List[Any]) -> None:
-    client, udp_buffer_receiver, preset_retriever = args
+    client, udp_buffer_receiver, feature_extractor, preset_retriever = args
     value = osc_args[0]
-    buffer = udp_buffer_receiver.receive()
-    buffer = torch.from_numpy(buffer)
-    buffer = buffer.reshape((1, -1))
+    content = osc_args[1] if len(osc_args) > 1 else CONTENT_AUDIO
+    buffer_id = osc_args[2] if len(osc_args) > 2 else -1
+    try:
+        buffer = udp_buffer_receiver.receive(buffer_id, timeout=RECEIVE_TIMEOUT)
+    except BufferLostError as e:
+        print(f'Cannot tag the preset: {e}')
+        return
     # extract latent features
-    preset_feature = feature_extractor.encode(buffer)
+    preset_feature = encode_buffer(feature_extractor, buffer, content)
     preset_feature = preset_feature.reshape(preset_feature.shape[1])
     # auto_tag
     tags = preset_retriever.auto_tag(preset_feature)
@@ -89,6 +175,29 @@ def auto_tag_callback(address: str,
     client.send_message('/Ideator/cpp/auto_tag', tags)
 
 
+def stored_presets_callback(address: str,
+                           args: List[Any],
+                           *osc_args: List[Any]) -> None:
+    """ Tells the host which presets of a library are in the cache, the host analyzes the others again. """
+    client, preset_retriever = args
+    library_dir = os.path.join(str(osc_args[0]), '')
+    paths = [path for path in preset_retriever.get_preset_paths() if path.startswith(library_dir)]
+
+    # many paths per message, kept under OSC_MAX_MESSAGE_SIZE of the host
+    client.send_message('/Ideator/cpp/stored_presets/start', 1)
+    message, message_size = [], 0
+    for path in paths:
+        path_size = len(path.encode('utf-8')) + 8
+        if message and message_size + path_size > MAX_MESSAGE_SIZE:
+            client.send_message('/Ideator/cpp/stored_presets/send', message)
+            message, message_size = [], 0
+        message.append(path)
+        message_size += path_size
+    if message:
+        client.send_message('/Ideator/cpp/stored_presets/send', message)
+    client.send_message('/Ideator/cpp/stored_presets/end', 1)
+
+
 def change_descriptors_callback(address: str,
                                 args: List[Any],
                                 *osc_args: List[Any]) -> None:
@@ -102,21 +211,43 @@ def change_descriptors_callback(address: str,
 
 
 if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--transport', choices=['udp', 'stream'], default='udp',
+                        help='also accept the audio buffers over a TCP connection on port 8889 '
+                             '(start the host with IDEATOR_AUDIO_TRANSPORT=stream)')
+    cli_args = parser.parse_args()
+
     dispatcher = dispatcher.Dispatcher()
     client = udp_client.SimpleUDPClient(address="127.0.0.1", port=9001)
     feature_extractor = AudioFeatureExtractor('models/auto-encoder-20201020050003.pt') # NOTE: hard coded here
-    udp_buffer_receiver = UdpBufferReceiver(address="127.0.0.1", port=8888)
+    # the host falls back to sending the audio in UDP messages if the shared memory cannot be created
+    try:
+        ring = SharedMemoryRing('IdeatorAudio')
+        atexit.register(ring.close)
+    except OSError as e:
+        print(f'Shared memory is not available ({e}), receiving audio over UDP')
+        ring = None
+    udp_buffer_receiver = UdpBufferReceiver(address="127.0.0.1", port=8888, ring=ring)
+    if cli_args.transport == 'stream':
+        stream_buffer_receiver = StreamBufferReceiver(address="127.0.0.1", port=8889,
+                                                      buffer_receiver=udp_buffer_receiver)
     library_receiver = LibraryReceiver(feature_extractor)
     preset_retriever = PresetRetriever('./cache/preset_lib.pkl')
 
     dispatcher.map("/Ideator/python/analyze_library", analyze_library_callback,
-                   client, library_receiver, udp_buffer_receiver, preset_retriever)
+                   client, library_receiver, udp_buffer_receiver, feature_extractor, preset_retriever)
+    dispatcher.map("/Ideator/python/analyze_batch", analyze_batch_callback,
+                   client, library_receiver, udp_buffer_receiver, feature_extractor)
     dispatcher.map("/Ideator/python/retrieve_presets", retrieve_presets_callback, client, preset_retriever)
     dispatcher.map("/Ideator/python/find_similar", find_similar_callback, client,
                    udp_buffer_receiver, feature_extractor, preset_retriever)
-    dispatcher.map("/Ideator/python/auto_tag", auto_tag_callback, client, udp_buffer_receiver, preset_retriever)
+    dispatcher.map("/Ideator/python/auto_tag", auto_tag_callback, client,
+                   udp_buffer_receiver, feature_extractor, preset_retriever)
     dispatcher.map("/Ideator/python/change_descriptors", change_descriptors_callback, client, preset_retriever)
+    dispatcher.map("/Ideator/python/stored_presets", stored_presets_callback, client, preset_retriever)
 
     server = osc_server.ThreadingOSCUDPServer(("127.0.0.1", 7777), dispatcher)
+    # the messages of a batch are larger than the default of 8 KB, see OSC_MAX_MESSAGE_SIZE in Config.h
+    server.max_packet_size = 65536
     print("Serving on {}".format(server.server_address))
     server.serve_forever()
@@ -15,23 +15,43 @@ class LibraryReceiver:
         self._num_parameters = 0
         self._library_info = {}
         self._feature_extractor = feature_extractor
+        self._silent_features = {}
 
     # manage the library data construction
-    def add_library_info(self, preset_path: str, descriptors: Tuple[str], buffer: np.array) -> None:
+    def add_library_info(self, preset_path: str, descriptors: Tuple[str], preset_feature: np.array) -> None:
+        """ The feature is the latent of the preset, encoded here or by the host. """
         print(f'preset_path: {preset_path}')
         print(f'descriptor_list: {descriptors}')
-        buffer = torch.from_numpy(buffer)
-        buffer = buffer.reshape((1, -1))
-        preset_feature = self._feature_extractor.encode(buffer)
         self._library_info[preset_path] = {'feature': preset_feature, 'descriptors': descriptors}
 
+    def add_silent_preset(self, preset_path: str, descriptors: Tuple[str],
+                          sample_rate: int, num_samples: int) -> None:
+        """ The silence has the sample rate and the length of the host's render spec. """
+        print(f'preset_path: {preset_path} (silent)')
+        print(f'descriptor_list: {descriptors}')
+        # all silent presets of a render spec share the same feature, so it is only encoded once
+        spec = (sample_rate, num_samples)
+        if spec not in self._silent_features:
+            self._silent_features[spec] = self._feature_extractor.encode(torch.zeros((1, num_samples)),
+                                                                         sample_rate)
+        self._library_info[preset_path] = {'feature': self._silent_features[spec], 'descriptors': descriptors}
+
     def save_library_info(self) -> None:
         # TODO: the cache directory is in backend/ folder, consider move it to user directory in the future
         # this is a relative path, do NOT run this script when you are not in backend/ folder
         Path('./cache').mkdir(parents=True, exist_ok=True)
+        # the host only sends the presets that have changed since the last analysis, so the new
+        # ones are merged into the cache, and the presets whose files have been deleted are dropped
+        library_info = {}
+        if os.path.isfile('./cache/preset_lib.pkl'):
+            with open('./cache/preset_lib.pkl', 'rb') as f:
+                library_info = pickle.load(f)
+        library_info.update(self._library_info)
+        library_info = {path: info for path, info in library_info.items() if os.path.isfile(path)}
         # dump the data
         with open('./cache/preset_lib.pkl', 'wb') as f:
-            pickle.dump(self._library_info, f)
+            pickle.dump(library_info, f)
+        self._library_info = {}
 
 
 class PresetRetriever:
@@ -114,7 +134,15 @@ class PresetRetriever:
         print(f'new descriptors: {descriptors}')
         self.save_cache('./cache/preset_lib.pkl')
 
+    def get_preset_paths(self) -> List[str]:
+        """ The presets in the cache, which is loaded again after every analysis. """
+        return list(self._preset_paths)
+
     def load_cache(self, cache_path: str) -> None:
+        # the cache is loaded again after every analysis
+        self._preset_paths = []
+        self._preset_descriptors = []
+        self._feature_matrix = np.array([])
         if os.path.isfile(cache_path):
             with open(cache_path, 'rb') as f:
                 library_info = pickle.load(f)
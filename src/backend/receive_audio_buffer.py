@@ -1,38 +1,145 @@
 import socket
+import threading
+import time
+from typing import Dict, Optional, Set, Tuple
 import numpy as np
 import struct
 from scipy.io.wavfile import write as wavwrite
 
+from shared_memory_ring import SharedMemoryRing
+
+
+class BufferLostError(IOError):
+    """ The buffer has arrived damaged, or some of its messages have not arrived in time. """
+
 
 class UdpBufferReceiver:
-    def __init__(self, address: str, port: int):
+    def __init__(self, address: str, port: int, ring: Optional[SharedMemoryRing] = None):
         self._address = address
         self._port = port
+        # The host puts the buffers into the shared memory when it's available, and only sends
+        # a descriptor of each one to the socket. Otherwise the buffers come in UDP messages of up
+        # to 64 KB, the last one of a buffer is shorter.
+        self._ring = ring
         self._socket = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        # several buffers can be in flight during the library analysis
+        self._socket.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 8 * 1024 * 1024)
+        # the reader wakes up regularly to check the buffers that arrive in other ways and its deadline
+        self._socket.settimeout(0.2)
         self._socket.bind((self._address, self._port))
 
-    def receive(self) -> np.array:
+        # The OSC callbacks run in their own threads, so only one of them reads the socket at
+        # a time, and the buffers that belong to the other threads are kept here.
+        self._condition = threading.Condition()
+        self._is_reading = False
+        self._partial_msgs = {}  # msg_id -> (msg_buf, num_msgs)
+        # a buffer of None has been lost
+        self._completed_buffers: Dict[int, Optional[np.array]] = {}
+        # the ids whose receivers have given up, their buffers are dropped if they still arrive
+        self._abandoned_ids: Set[int] = set()
+
+    def receive(self, msg_id: Optional[int] = None, timeout: Optional[float] = None) -> np.array:
+        """ Receives the buffer with the given id, or any buffer if the id is None.
+        Raises BufferLostError if the buffer is damaged or has not arrived within the timeout. """
+        deadline = None if timeout is None else time.monotonic() + timeout
+        with self._condition:
+            while True:
+                found, buffer = self._pop_completed_buffer(msg_id)
+                if found:
+                    return self._check_buffer(msg_id, buffer)
+                if not self._is_reading:
+                    self._is_reading = True
+                    break
+                if self._has_expired(deadline):
+                    self._abandon(msg_id)
+                    raise BufferLostError(f'the buffer {msg_id} has not arrived in time')
+                self._condition.wait(0.2)
+
+        try:
+            while True:
+                received = self._receive_next_buffer()
+                with self._condition:
+                    if received is not None:
+                        self._complete(*received)
+                    found, buffer = self._pop_completed_buffer(msg_id)
+                    if found:
+                        return self._check_buffer(msg_id, buffer)
+                    if self._has_expired(deadline):
+                        # the messages of the buffer that did arrive are of no use any more
+                        self._partial_msgs.pop(msg_id, None)
+                        self._abandon(msg_id)
+                        raise BufferLostError(f'the buffer {msg_id} has not arrived in time')
+        finally:
+            with self._condition:
+                self._is_reading = False
+                self._condition.notify_all()
+
+    def put(self, msg_id: int, buffer: Optional[np.array]) -> None:
+        """ Hands over a buffer that has arrived in another way, None means it has been lost. """
+        with self._condition:
+            self._complete(msg_id, buffer)
+
+    def _complete(self, msg_id: int, buffer: Optional[np.array]) -> None:
+        # a buffer that nobody waits for anymore would stay here forever
+        if msg_id in self._abandoned_ids:
+            self._abandoned_ids.discard(msg_id)
+            return
+        self._completed_buffers[msg_id] = buffer
+        self._condition.notify_all()
+
+    def _abandon(self, msg_id: Optional[int]) -> None:
+        if msg_id is not None:
+            self._abandoned_ids.add(msg_id)
+
+    @staticmethod
+    def _has_expired(deadline: Optional[float]) -> bool:
+        return deadline is not None and time.monotonic() > deadline
+
+    @staticmethod
+    def _check_buffer(msg_id: Optional[int], buffer: Optional[np.array]) -> np.array:
+        if buffer is None:
+            raise BufferLostError(f'the buffer {msg_id} has arrived damaged')
+        return buffer
+
+    def _pop_completed_buffer(self, msg_id: Optional[int]) -> Tuple[bool, Optional[np.array]]:
+        if msg_id is None:
+            if self._completed_buffers:
+                return True, self._completed_buffers.pop(next(iter(self._completed_buffers)))
+            return False, None
+        if msg_id in self._completed_buffers:
+            return True, self._completed_buffers.pop(msg_id)
+        return False, None
+
+    def _receive_next_buffer(self) -> Optional[Tuple[int, np.array]]:
+        """ Returns the next completed buffer, or None if nothing has arrived for a while. """
         meta_fmt = 'ii?i'
         meta_size = struct.calcsize(meta_fmt)
 
-        msg_buf = {}
-        num_msgs = 0
-        last_received = False
-
         while True:
-            data, addr = self._socket.recvfrom(512)
+            try:
+                data, addr = self._socket.recvfrom(65536)
+            except socket.timeout:
+                if self._ring:
+                    self._ring.release_lost()
+                return None
+            descriptor = SharedMemoryRing.parse_descriptor(data) if self._ring else None
+            if descriptor is not None:
+                msg_id, position, num_samples, num_skipped_bytes = descriptor
+                return msg_id, self._ring.read(position, num_samples, num_skipped_bytes)
+
             msg_id, idx, is_last, num_samples = struct.unpack(meta_fmt, data[:meta_size])
+            msg_buf, num_msgs = self._partial_msgs.get(msg_id, ({}, 0))
             msg_buf[idx] = (data[meta_size:], num_samples)
 
             # check if the all the messages have been received once
             # the last one has been received
-            if is_last or last_received:
-                if is_last:
-                    last_received = True
-                    num_msgs = idx + 1
-                if len(msg_buf) == num_msgs:
-                    break
+            if is_last:
+                num_msgs = idx + 1
+            self._partial_msgs[msg_id] = (msg_buf, num_msgs)
+            if num_msgs and len(msg_buf) == num_msgs:
+                break
 
+        del self._partial_msgs[msg_id]
         msg_list = [msg_buf[i] for i in range(num_msgs)]
 
         data_list = []
@@ -40,7 +147,7 @@ class UdpBufferReceiver:
             data, num_samples = msg
             data_list.append(np.frombuffer(data, dtype=np.float32)[:num_samples])
 
-        return np.concatenate(data_list)
+        return msg_id, np.concatenate(data_list)
 
     @property
     def address(self) -> str:
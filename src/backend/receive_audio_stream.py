@@ -0,0 +1,81 @@
+import socket
+import struct
+import threading
+import zlib
+from typing import Optional
+
+import numpy as np
+
+from receive_audio_buffer import UdpBufferReceiver
+
+# The layouts must match StreamTransport.cpp in the host.
+# frame header: magic, id, number of bytes, CRC-32 of the samples
+FRAME_HEADER_FMT = '<4siII'
+FRAME_HEADER_SIZE = struct.calcsize(FRAME_HEADER_FMT)
+FRAME_MAGIC = b'IDST'
+# acknowledgement: magic, id, status (0 means the frame is intact)
+ACK_FMT = '<4sii'
+ACK_MAGIC = b'IDSA'
+# a frame can't be larger than a few seconds of audio
+MAX_FRAME_SIZE = 64 * 1024 * 1024
+
+
+class StreamBufferReceiver:
+    """ Receives the audio buffers that the host sends over a TCP connection, and hands them
+    over to the UDP receiver, so the callbacks wait for the buffers in the same way. """
+
+    def __init__(self, address: str, port: int, buffer_receiver: UdpBufferReceiver):
+        self._buffer_receiver = buffer_receiver
+        self._server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self._server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self._server.bind((address, port))
+        self._server.listen(1)
+        self._thread = threading.Thread(target=self._serve, daemon=True)
+        self._thread.start()
+
+    def _serve(self) -> None:
+        # the host reconnects after it has given up on a connection, so serve one after another
+        while True:
+            connection, _ = self._server.accept()
+            with connection:
+                try:
+                    while self._receive_frame(connection):
+                        pass
+                except OSError as e:
+                    print(f'Audio stream closed: {e}')
+
+    def _receive_frame(self, connection: socket.socket) -> bool:
+        header = self._read_exactly(connection, FRAME_HEADER_SIZE)
+        if header is None:
+            return False
+        magic, msg_id, num_bytes, checksum = struct.unpack(FRAME_HEADER_FMT, header)
+        # the stream is out of sync, there is no way to find the next frame
+        if magic != FRAME_MAGIC or num_bytes > MAX_FRAME_SIZE or num_bytes % 4 != 0:
+            print('Audio stream out of sync, closing the connection')
+            return False
+
+        data = self._read_exactly(connection, num_bytes)
+        if data is None:
+            return False
+
+        is_intact = zlib.crc32(data) == checksum
+        if is_intact:
+            self._buffer_receiver.put(msg_id, np.frombuffer(data, dtype=np.float32))
+        else:
+            print(f'The buffer {msg_id} has arrived damaged')
+            self._buffer_receiver.put(msg_id, None)
+
+        # every acknowledgement gives the host a slot for the next buffer
+        connection.sendall(struct.pack(ACK_FMT, ACK_MAGIC, msg_id, 0 if is_intact else 1))
+        return True
+
+    @staticmethod
+    def _read_exactly(connection: socket.socket, num_bytes: int) -> Optional[bytearray]:
+        data = bytearray(num_bytes)
+        view = memoryview(data)
+        while view:
+            num_received = connection.recv_into(view)
+            if num_received == 0:
+                return None
+            view = view[num_received:]
+        return data
@@ -0,0 +1,147 @@
+import heapq
+import os
+import struct
+import threading
+import time
+from multiprocessing import shared_memory
+from typing import Optional
+
+import numpy as np
+
+# The layout must match SharedMemoryTransport.cpp in the host.
+# header: magic, version, capacity, write position, read position, owner pid, is open, reserved
+HEADER_FMT = '<4sIQQQqI20x'
+HEADER_SIZE = struct.calcsize(HEADER_FMT)
+WRITE_POSITION_OFFSET = 16
+READ_POSITION_OFFSET = 24
+IS_OPEN_OFFSET = 40
+MAGIC = b'IDSM'
+VERSION = 2
+# records start on cache line boundaries
+ALIGNMENT = 64
+# A reservation whose descriptor hasn't arrived for this long is given up, its datagram has been
+# dropped or the host has failed to send it. Copying a buffer takes far less than that.
+LOST_RESERVATION_TIMEOUT = 2.0
+
+# the UDP datagram that tells where a buffer is: magic, id, position, number of samples,
+# number of bytes skipped at the end of the ring before the position
+DESCRIPTOR_FMT = '<4siQii'
+DESCRIPTOR_SIZE = struct.calcsize(DESCRIPTOR_FMT)
+
+
+class SharedMemoryRing:
+    """ The ring buffer the host writes the audio buffers into. The backend creates and owns it. """
+
+    def __init__(self, name: str = 'IdeatorAudio', capacity: int = 16 * 1024 * 1024):
+        # a segment left behind by a crashed backend is replaced
+        try:
+            stale = shared_memory.SharedMemory(name=name)
+            stale.close()
+            stale.unlink()
+        except FileNotFoundError:
+            pass
+
+        self._shm = shared_memory.SharedMemory(name=name, create=True, size=HEADER_SIZE + capacity)
+        self._capacity = capacity
+        self._read_position = 0
+        # the reservations that have been read while an earlier one hasn't, as (start, end)
+        self._completed = []
+        # (read position, write position, time) when the read position was last seen behind
+        self._stall = None
+        self._lock = threading.Lock()
+        struct.pack_into(HEADER_FMT, self._shm.buf, 0, MAGIC, VERSION, capacity, 0, 0, os.getpid(), 1)
+
+    @staticmethod
+    def parse_descriptor(data: bytes) -> Optional[tuple]:
+        """ Returns (id, position, num_samples, num_skipped_bytes) if the datagram is a descriptor,
+        otherwise None. """
+        if len(data) != DESCRIPTOR_SIZE or data[:4] != MAGIC:
+            return None
+        _, msg_id, position, num_samples, num_skipped_bytes = struct.unpack(DESCRIPTOR_FMT, data)
+        return msg_id, position, num_samples, num_skipped_bytes
+
+    def read(self, position: int, num_samples: int, num_skipped_bytes: int = 0) -> np.array:
+        offset = HEADER_SIZE + position % self._capacity
+        buffer = np.frombuffer(self._shm.buf, dtype=np.float32, count=num_samples, offset=offset).copy()
+
+        # A reservation starts where the previous one ended, before the end of the ring was
+        # skipped, and ends on the next record boundary. Several writers can have reservations
+        # in flight and their buffers can be read in any order, so the space is only freed up to
+        # the first reservation that hasn't been read, or the host would overwrite it.
+        start = position - num_skipped_bytes
+        end = -(-(position + num_samples * 4) // ALIGNMENT) * ALIGNMENT
+        with self._lock:
+            heapq.heappush(self._completed, (start, end))
+            self._free_completed()
+        self.release_lost()
+        return buffer
+
+    def release_lost(self, now: Optional[float] = None) -> None:
+        """ Frees the reservations whose descriptors have not arrived within LOST_RESERVATION_TIMEOUT,
+        otherwise a single lost descriptor would keep the ring from ever being freed again.
+        Should be called regularly, also when no buffers arrive. """
+        now = time.monotonic() if now is None else now
+        with self._lock:
+            write_position = struct.unpack_from('<Q', self._shm.buf, WRITE_POSITION_OFFSET)[0]
+            if write_position <= self._read_position:
+                self._stall = None
+                return
+            if self._stall is None or self._stall[0] != self._read_position:
+                self._stall = (self._read_position, write_position, now)
+                return
+
+            # everything reserved before the read position stopped moving is older than the timeout,
+            # so it is skipped up to the next buffer that has been read
+            _, stall_write_position, stall_time = self._stall
+            if now - stall_time < LOST_RESERVATION_TIMEOUT:
+                return
+            skipped_position = stall_write_position
+            if self._completed:
+                skipped_position = min(skipped_position, self._completed[0][0])
+            self._read_position = max(self._read_position, skipped_position)
+            self._free_completed()
+            self._stall = None
+
+    def _free_completed(self) -> None:
+        while self._completed and self._completed[0][0] <= self._read_position:
+            _, end = heapq.heappop(self._completed)
+            self._read_position = max(self._read_position, end)
+        struct.pack_into('<Q', self._shm.buf, READ_POSITION_OFFSET, self._read_position)
+
+    def close(self) -> None:
+        # tell the host to stop writing before the segment goes away
+        struct.pack_into('<I', self._shm.buf, IS_OPEN_OFFSET, 0)
+        self._shm.close()
+        self._shm.unlink()
+
+
+if __name__ == '__main__':
+    # The host loses the descriptor of the second of three buffers, the ring must still be freed.
+    ring = SharedMemoryRing('IdeatorAudioTest', capacity=4096)
+    try:
+        def write(samples: np.array) -> tuple:
+            position = struct.unpack_from('<Q', ring._shm.buf, WRITE_POSITION_OFFSET)[0]
+            ring._shm.buf[HEADER_SIZE + position:HEADER_SIZE + position + samples.nbytes] = samples.tobytes()
+            next_position = -(-(position + samples.nbytes) // ALIGNMENT) * ALIGNMENT
+            struct.pack_into('<Q', ring._shm.buf, WRITE_POSITION_OFFSET, next_position)
+            return position, len(samples)
+
+        def read_position() -> int:
+            return struct.unpack_from('<Q', ring._shm.buf, READ_POSITION_OFFSET)[0]
+
+        buffers = [np.full(100, i, dtype=np.float32) for i in range(3)]
+        descriptors = [write(buffer) for buffer in buffers]
+        assert (ring.read(*descriptors[0]) == buffers[0]).all()
+        assert (ring.read(*descriptors[2]) == buffers[2]).all()
+        first_end = -(-(descriptors[0][0] + buffers[0].nbytes) // ALIGNMENT) * ALIGNMENT
+        assert read_position() == first_end, 'the lost buffer must not be freed at once'
+
+        now = time.monotonic()
+        ring.release_lost(now + LOST_RESERVATION_TIMEOUT / 2)
+        assert read_position() == first_end, 'the lost buffer must not be freed before the timeout'
+        ring.release_lost(now + LOST_RESERVATION_TIMEOUT * 2)
+        assert read_position() == struct.unpack_from('<Q', ring._shm.buf, WRITE_POSITION_OFFSET)[0], \
+            'the lost buffer must be freed after the timeout'
+        print('the ring has been freed after a lost descriptor')
+    finally:
+        ring.close()
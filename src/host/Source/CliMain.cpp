@@ -0,0 +1,514 @@
+/*
+  ==============================================================================
+
+    CliMain.cpp
+    Created: 17 Oct 2026 7:30:53pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginManager.h"
+#include "RenderPool.h"
+#include "OfflineRenderer.h"
+#include "Utils.h"
+#include "Config.h"
+#include "SelfTests.h"
+#include "LatentIndex.h"
+#include <algorithm>
+
+// The headless version of Ideator, which scans, renders and analyzes a preset library
+// without a GUI session, for example:
+//     Ideator-Cli --library ~/Presets/Diva --audio-out /tmp/diva-audio --index-out /tmp/diva.xml
+
+static const char *helpText =
+    "Usage: Ideator-Cli --library <dir> [options]\n"
+    "\n"
+    "  --library <dir>        the preset library to analyze\n"
+    "  --audio-out <dir>      also save the rendered audio of every preset as a WAV file\n"
+    "  --index-out <file>     write the list of presets and their states as an XML file\n"
+    "  --no-backend           only render, don't send the presets to the Python back-end\n"
+    "  --sample-rate <hz>     the render sample rate (default 44100)\n"
+    "  --length <seconds>     the length of the rendered audio (default 3)\n"
+    "  --note-length <sec>    how long the note is held (default 2)\n"
+    "  --note <number>        the MIDI note number (default 60)\n"
+    "  --velocity <value>     the MIDI velocity (default 127)\n"
+    "  --block-size <number>  the render block size, lower it for plugins that can't handle large blocks (default 4096)\n"
+    "  --silent-hold <sec>    how long after the note-off a preset that hasn't made any sound is given up on (default 0.5)\n"
+    "  --workers <number>     the number of render threads (default: one per spare core)\n"
+    "  --time-budget <ms>     skip the presets that take longer to render (default 15000, 0 means no limit)\n"
+    "  --window <number>      the number of presets in flight to the back-end (default 8)\n"
+    "  --batch <number>       the number of presets the back-end encodes in one pass (default 16)\n"
+    "  --transport <name>     send the audio over \"stream\" (TCP) or \"udp\" when there is no shared memory\n"
+    "  --encoder <file>       encode the presets with this file from export_encoder.py (default: Encoder.bin\n"
+    "                         in the application data folder if it exists, otherwise the back-end encodes them)\n"
+    "  --timeout <seconds>    give up waiting for the back-end after this time (default: never)\n"
+    "\n"
+    "       Ideator-Cli --bench-parse <dir> [--repeat <number>]\n"
+    "\n"
+    "  --bench-parse <dir>    time the XML document parser against the single-pass preset parser on a library\n"
+    "  --repeat <number>      the number of times every preset is parsed (default 10)\n"
+    "\n"
+    "       Ideator-Cli --bench-similar [--presets <number>] [--dimension <number>] [--queries <number>]\n"
+    "\n"
+    "  --bench-similar        time the LatentIndex against comparing every preset, on made-up latent features\n"
+    "  --presets <number>     the number of presets in the made-up library (default 100000)\n"
+    "  --dimension <number>   the number of latent features per preset (default 64)\n"
+    "  --queries <number>     the number of patches that are looked up (default 1000)\n"
+    "\n"
+    "       Ideator-Cli --self-test [--mel-reference <file>]\n"
+    "\n"
+    "  --self-test            check the parts of the host that need neither a plugin nor the back-end\n"
+    "  --mel-reference <file> also compare the log-mel spectrogram with torchaudio, the file is written\n"
+    "                         by export_mel_reference.py in the back-end\n";
+
+struct LibraryPreset
+{
+    juce::String presetPath;
+    juce::String pluginPath;
+    DescriptorSet descriptors;
+    juce::String status;
+    juce::File audioFile;
+};
+
+static RenderSpec parseRenderSpec(const juce::ArgumentList &args)
+{
+    RenderSpec spec;
+
+    if (args.containsOption("--sample-rate"))
+        spec.sampleRate = args.getValueForOption("--sample-rate").getDoubleValue();
+    if (args.containsOption("--length"))
+        spec.audioLength = args.getValueForOption("--length").getDoubleValue();
+    if (args.containsOption("--note-length"))
+        spec.noteLength = args.getValueForOption("--note-length").getDoubleValue();
+    if (args.containsOption("--note"))
+        spec.midiNote = args.getValueForOption("--note").getIntValue();
+    if (args.containsOption("--velocity"))
+        spec.midiVelocity = static_cast<juce::uint8>(juce::jlimit(1, 127, args.getValueForOption("--velocity").getIntValue()));
+    if (args.containsOption("--block-size"))
+        spec.blockSize = args.getValueForOption("--block-size").getIntValue();
+    if (args.containsOption("--silent-hold"))
+        spec.silentPresetHoldTime = args.getValueForOption("--silent-hold").getDoubleValue();
+
+    if (spec.sampleRate <= 0. || spec.audioLength <= 0. || spec.noteLength < 0. || spec.blockSize <= 0
+        || spec.silentPresetHoldTime < 0.
+        || !juce::isPositiveAndBelow(spec.midiNote, 128))
+        juce::ConsoleApplication::fail("Invalid render spec");
+
+    return spec;
+}
+
+static juce::Array<LibraryPreset> scanLibrary(const juce::File &libraryDir)
+{
+    juce::Array<LibraryPreset> presets;
+
+    auto presetFiles = libraryDir.findChildFiles(juce::File::TypesOfFileToFind::findFiles,
+                                                 true,
+                                                 "*.xml");
+    std::vector<float> parameters;
+    for (auto &file : presetFiles)
+    {
+        LibraryPreset preset;
+        preset.presetPath = file.getFullPathName();
+
+        if (PresetManager::parse(file, parameters, preset.pluginPath, preset.descriptors))
+            preset.status = "scanned";
+        else
+            preset.status = "unparsable";
+
+        presets.add(preset);
+    }
+
+    return presets;
+}
+
+static void renderToFiles(juce::Array<LibraryPreset> &presets,
+                          const juce::File &libraryDir,
+                          const juce::File &audioDir,
+                          const RenderSpec &spec,
+                          int numWorkers,
+                          int timeBudgetMs)
+{
+    juce::Array<juce::String> presetPaths;
+    juce::Array<int> presetIndices;
+    for (int i = 0; i < presets.size(); ++i)
+    {
+        if (presets[i].status != "scanned")
+            continue;
+        presetPaths.add(presets[i].presetPath);
+        presetIndices.add(i);
+    }
+
+    RenderPool renderPool(numWorkers);
+    renderPool.setTimeBudget(timeBudgetMs);
+    renderPool.start(presetPaths, spec);
+
+    RenderPool::Result result;
+    for (int i = 0; i < presetPaths.size();)
+    {
+        // keep the message loop running, some plugins can only be instantiated on the message thread
+        if (!renderPool.popResult(i, result))
+        {
+            juce::MessageManager::getInstance()->runDispatchLoopUntil(10);
+            continue;
+        }
+
+        auto &preset = presets.getReference(presetIndices[i]);
+        if (result.failed)
+        {
+            preset.status = "failed";
+            std::cerr << "Failed to render " << preset.presetPath << ": " << result.errorMessage << std::endl;
+        }
+        else
+        {
+            auto relativePath = juce::File(preset.presetPath).getRelativePathFrom(libraryDir);
+            preset.audioFile = audioDir.getChildFile(relativePath).withFileExtension("wav");
+            preset.status = OfflineRenderer::saveToWavFile(result.audio, spec.sampleRate, preset.audioFile) ?
+                            "rendered" : "failed";
+        }
+
+        ++i;
+        std::cout << "Rendered " << i << "/" << presetPaths.size() << "\r" << std::flush;
+    }
+    std::cout << std::endl;
+}
+
+static bool analyzeWithBackend(juce::Array<LibraryPreset> &presets,
+                               const juce::File &libraryDir,
+                               const RenderSpec &spec,
+                               int timeBudgetMs,
+                               const juce::ArgumentList &args)
+{
+    const int windowSize = args.getValueForOption("--window").getIntValue();
+    const int batchSize = args.getValueForOption("--batch").getIntValue();
+    const int timeoutSeconds = args.getValueForOption("--timeout").getIntValue();
+
+    juce::Array<juce::String> presetPaths;
+    for (const auto &preset : presets)
+        if (preset.status != "unparsable" && preset.status != "failed")
+            presetPaths.add(preset.presetPath);
+
+    if (presetPaths.isEmpty())
+        return true;
+
+    OSCManager oscManager;
+    PluginManager pluginManager;
+    pluginManager.setOSCManager(&oscManager);
+    pluginManager.setRenderSpec(spec);
+    // the latent features are kept for finding similar presets in the host
+    pluginManager.setLibraryDirectory(libraryDir);
+    if (windowSize > 0)
+        pluginManager.setAnalysisWindowSize(windowSize);
+    if (batchSize > 0)
+        pluginManager.setAnalysisBatchSize(batchSize);
+    pluginManager.setRenderTimeBudget(timeBudgetMs);
+    if (args.containsOption("--transport"))
+        pluginManager.setStreamTransportEnabled(args.getValueForOption("--transport").equalsIgnoreCase("stream"));
+    if (args.containsOption("--encoder") && !pluginManager.loadLatentEncoder(args.getFileForOption("--encoder")))
+    {
+        std::cerr << "Cannot load the encoder " << args.getValueForOption("--encoder") << std::endl;
+        return false;
+    }
+
+    if (!pluginManager.analyzeLibrary(presetPaths))
+        return false;
+
+    const auto startTime = juce::Time::getMillisecondCounter();
+    while (pluginManager.isAnalyzingLibrary())
+    {
+        juce::MessageManager::getInstance()->runDispatchLoopUntil(50);
+
+        if (timeoutSeconds > 0 && juce::Time::getMillisecondCounter() - startTime > (juce::uint32) timeoutSeconds * 1000)
+        {
+            std::cerr << "Timed out waiting for the back-end" << std::endl;
+            return false;
+        }
+    }
+
+    const auto &failedPresetPaths = pluginManager.getFailedPresetPaths();
+    for (auto &preset : presets)
+    {
+        // the presets that have been put into presetPaths
+        if (preset.status == "unparsable" || preset.status == "failed")
+            continue;
+        preset.status = failedPresetPaths.count(preset.presetPath) > 0 ? "failed" : "analyzed";
+    }
+
+    return true;
+}
+
+static bool writeIndex(const juce::Array<LibraryPreset> &presets, const juce::File &libraryDir, const juce::File &indexFile)
+{
+    juce::XmlElement xmlLibrary("IdeatorLibrary");
+    xmlLibrary.setAttribute("path", libraryDir.getFullPathName());
+
+    for (const auto &preset : presets)
+    {
+        auto xmlPreset = xmlLibrary.createNewChildElement("Preset");
+        xmlPreset->setAttribute("path", preset.presetPath);
+        xmlPreset->setAttribute("plugin", preset.pluginPath);
+        xmlPreset->setAttribute("descriptors", preset.descriptors.toString());
+        xmlPreset->setAttribute("status", preset.status);
+        if (preset.audioFile != juce::File())
+            xmlPreset->setAttribute("audio", preset.audioFile.getFullPathName());
+    }
+
+    if (!indexFile.create().wasOk())
+        return false;
+    return xmlLibrary.writeTo(indexFile);
+}
+
+static void runAnalysis(const juce::ArgumentList &args)
+{
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    auto libraryDir = args.getExistingFolderForOption("--library");
+    auto spec = parseRenderSpec(args);
+    const int numWorkers = args.containsOption("--workers") ?
+                           args.getValueForOption("--workers").getIntValue() : RENDER_POOL_NUM_WORKERS;
+    const int timeBudgetMs = args.containsOption("--time-budget") ?
+                             args.getValueForOption("--time-budget").getIntValue() : RENDER_TIME_BUDGET_MS;
+
+    // 1. scan
+    auto presets = scanLibrary(libraryDir);
+    std::cout << "Found " << presets.size() << " presets in " << libraryDir.getFullPathName() << std::endl;
+
+    // 2. render, the rendered audio also ends up in the render cache, so the analysis
+    // below doesn't need to render the presets again
+    if (args.containsOption("--audio-out"))
+    {
+        auto audioDir = args.getFileForOption("--audio-out");
+        if (!audioDir.createDirectory().wasOk())
+            juce::ConsoleApplication::fail("Cannot create " + audioDir.getFullPathName());
+        renderToFiles(presets, libraryDir, audioDir, spec, numWorkers, timeBudgetMs);
+    }
+
+    // 3. analyze
+    bool isAnalysisFinished = true;
+    if (!args.containsOption("--no-backend"))
+        isAnalysisFinished = analyzeWithBackend(presets, libraryDir, spec, timeBudgetMs, args);
+
+    // 4. write the index
+    if (args.containsOption("--index-out"))
+    {
+        auto indexFile = args.getFileForOption("--index-out");
+        if (!writeIndex(presets, libraryDir, indexFile))
+            juce::ConsoleApplication::fail("Cannot write " + indexFile.getFullPathName());
+    }
+
+    // 5. summary
+    juce::StringPairArray counts;
+    for (const auto &preset : presets)
+        counts.set(preset.status, juce::String(counts[preset.status].getIntValue() + 1));
+
+    std::cout << "Summary:" << std::endl;
+    for (const auto &status : counts.getAllKeys())
+        std::cout << "    " << status << ": " << counts[status] << std::endl;
+    std::cout << "    time: " << juce::String((juce::Time::getMillisecondCounterHiRes() - startTime) / 1000., 1) << " s" << std::endl;
+
+    if (!isAnalysisFinished)
+        juce::ConsoleApplication::fail("The analysis has not finished", 2);
+    if (counts["failed"].getIntValue() + counts["unparsable"].getIntValue() > 0)
+        juce::ConsoleApplication::fail("Some presets could not be processed", 3);
+}
+
+static void runParseBenchmark(const juce::ArgumentList &args)
+{
+    auto libraryDir = args.getExistingFolderForOption("--bench-parse");
+    const int numRepeats = args.containsOption("--repeat") ?
+                           juce::jmax(1, args.getValueForOption("--repeat").getIntValue()) : 10;
+
+    // the files are read before timing, so only the parsing is measured
+    juce::Array<juce::MemoryBlock> contents;
+    for (const auto &file : libraryDir.findChildFiles(juce::File::TypesOfFileToFind::findFiles, true, "*.xml"))
+    {
+        juce::MemoryBlock content;
+        if (file.loadFileAsData(content))
+            contents.add(content);
+    }
+    if (contents.isEmpty())
+        juce::ConsoleApplication::fail("No presets in " + libraryDir.getFullPathName());
+
+    juce::String pluginPath;
+    DescriptorSet descriptors;
+    juce::Array<std::pair<int, float>> domParameters;
+    std::vector<float> parameters;
+
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+    for (int i = 0; i < numRepeats; ++i)
+    {
+        for (const auto &content : contents)
+        {
+            domParameters.clearQuick();
+            auto xmlPreset = juce::XmlDocument::parse(content.toString());
+            if (xmlPreset)
+                PresetManager::parse(*xmlPreset, domParameters, pluginPath, descriptors);
+        }
+    }
+    const auto domTime = juce::Time::getMillisecondCounterHiRes() - startTime;
+
+    startTime = juce::Time::getMillisecondCounterHiRes();
+    for (int i = 0; i < numRepeats; ++i)
+        for (const auto &content : contents)
+            PresetManager::parse(static_cast<const char*>(content.getData()), content.getSize(),
+                                 parameters, pluginPath, descriptors);
+    const auto singlePassTime = juce::Time::getMillisecondCounterHiRes() - startTime;
+
+    // both parsers have to agree, so the gain cannot come from reading less
+    int numMismatches = 0;
+    for (const auto &content : contents)
+    {
+        juce::String domPluginPath;
+        DescriptorSet domDescriptors;
+        domParameters.clearQuick();
+        auto xmlPreset = juce::XmlDocument::parse(content.toString());
+        const bool isDomParsed = xmlPreset && PresetManager::parse(*xmlPreset, domParameters, domPluginPath, domDescriptors);
+        const bool isParsed = PresetManager::parse(static_cast<const char*>(content.getData()), content.getSize(),
+                                                   parameters, pluginPath, descriptors);
+        bool isMatching = isDomParsed == isParsed;
+        if (isMatching && isParsed)
+        {
+            isMatching = pluginPath == domPluginPath && descriptors == domDescriptors
+                         && parameters.size() == static_cast<size_t>(domParameters.size());
+            for (int i = 0; isMatching && i < domParameters.size(); ++i)
+                isMatching = parameters[static_cast<size_t>(i)] == domParameters[i].second;
+        }
+        if (!isMatching)
+            ++numMismatches;
+    }
+
+    const auto numParsed = static_cast<double>(contents.size()) * numRepeats;
+    std::cout << "Parsed " << contents.size() << " presets " << numRepeats << " times" << std::endl;
+    std::cout << "    XML document: " << juce::String(domTime * 1000. / numParsed, 2) << " us per preset" << std::endl;
+    std::cout << "    single-pass:  " << juce::String(singlePassTime * 1000. / numParsed, 2) << " us per preset" << std::endl;
+    std::cout << "    speed-up:     " << juce::String(domTime / juce::jmax(singlePassTime, 1e-6), 1) << "x" << std::endl;
+    std::cout << "    mismatches:   " << numMismatches << std::endl;
+
+    if (numMismatches > 0)
+        juce::ConsoleApplication::fail("The parsers disagree on some presets", 1);
+}
+
+static void runSimilarBenchmark(const juce::ArgumentList &args)
+{
+    auto getIntOption = [&args] (const juce::String &option, int defaultValue) {
+        return args.containsOption(option) ? juce::jmax(1, args.getValueForOption(option).getIntValue()) : defaultValue;
+    };
+    const int numPresets = getIntOption("--presets", 100000);
+    const int dimension = getIntOption("--dimension", 64);
+    const int numQueries = getIntOption("--queries", 1000);
+    const int numMatches = NUM_SIMILAR_PRESETS;
+
+    juce::Random random(1);
+    const auto latents = SelfTests::makeSyntheticLatents(numPresets, dimension, random);
+    auto getPresetPath = [] (int i) { return "/Bench/Preset" + juce::String(i) + ".xml"; };
+
+    // the patches that are looked up are close to some of the presets
+    std::vector<float> queries((size_t) numQueries * (size_t) dimension);
+    for (int q = 0; q < numQueries; ++q)
+    {
+        const auto* latent = latents.data() + (size_t) random.nextInt(numPresets) * (size_t) dimension;
+        for (int j = 0; j < dimension; ++j)
+            queries[(size_t) q * (size_t) dimension + (size_t) j] = latent[j] + random.nextFloat() - 0.5f;
+    }
+
+    LatentIndex index;
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+    for (int i = 0; i < numPresets; ++i)
+        index.add(getPresetPath(i), latents.data() + (size_t) i * (size_t) dimension, dimension);
+    const auto buildTime = juce::Time::getMillisecondCounterHiRes() - startTime;
+
+    std::vector<std::vector<int>> closest;
+    startTime = juce::Time::getMillisecondCounterHiRes();
+    for (int q = 0; q < numQueries; ++q)
+        closest.push_back(SelfTests::findClosestByBruteForce(latents, dimension,
+                                                             queries.data() + (size_t) q * (size_t) dimension, numMatches));
+    const auto bruteForceTime = juce::Time::getMillisecondCounterHiRes() - startTime;
+
+    std::vector<std::vector<LatentIndex::Match>> matches;
+    startTime = juce::Time::getMillisecondCounterHiRes();
+    for (int q = 0; q < numQueries; ++q)
+        matches.push_back(index.search(queries.data() + (size_t) q * (size_t) dimension, dimension, numMatches));
+    const auto indexTime = juce::Time::getMillisecondCounterHiRes() - startTime;
+
+    int numFound = 0;
+    for (int q = 0; q < numQueries; ++q)
+        for (int i : closest[(size_t) q])
+            numFound += std::any_of(matches[(size_t) q].begin(), matches[(size_t) q].end(),
+                                    [&] (const LatentIndex::Match &match) { return match.presetPath == getPresetPath(i); });
+    const auto recall = numFound / static_cast<double>(numQueries * numMatches);
+
+    // the loaded index has to find the same presets
+    juce::TemporaryFile file(".latents");
+    startTime = juce::Time::getMillisecondCounterHiRes();
+    const bool isSaved = index.save(file.getFile());
+    const auto saveTime = juce::Time::getMillisecondCounterHiRes() - startTime;
+    LatentIndex loadedIndex;
+    startTime = juce::Time::getMillisecondCounterHiRes();
+    const bool isLoaded = isSaved && loadedIndex.load(file.getFile());
+    const auto loadTime = juce::Time::getMillisecondCounterHiRes() - startTime;
+    int numMismatches = 0;
+    for (int q = 0; isLoaded && q < numQueries; ++q)
+    {
+        const auto loadedMatches = loadedIndex.search(queries.data() + (size_t) q * (size_t) dimension, dimension, numMatches);
+        numMismatches += !std::equal(loadedMatches.begin(), loadedMatches.end(),
+                                     matches[(size_t) q].begin(), matches[(size_t) q].end(),
+                                     [] (const LatentIndex::Match &a, const LatentIndex::Match &b) { return a.presetPath == b.presetPath; });
+    }
+
+    std::cout << "Looked up " << numQueries << " patches among " << numPresets << " presets of "
+              << dimension << " latent features" << std::endl;
+    std::cout << "    building the index: " << juce::String(buildTime / 1000., 2) << " s" << std::endl;
+    std::cout << "    brute force:        " << juce::String(bruteForceTime * 1000. / numQueries, 1) << " us per patch" << std::endl;
+    std::cout << "    LatentIndex:        " << juce::String(indexTime * 1000. / numQueries, 1) << " us per patch" << std::endl;
+    std::cout << "    speed-up:           " << juce::String(bruteForceTime / juce::jmax(indexTime, 1e-6), 1) << "x" << std::endl;
+    std::cout << "    recall@" << numMatches << ":           " << juce::String(recall, 4) << std::endl;
+    std::cout << "    save / load:        " << juce::String(saveTime, 1) << " / " << juce::String(loadTime, 1) << " ms" << std::endl;
+    std::cout << "    mismatches:         " << numMismatches << std::endl;
+
+    if (!isLoaded)
+        juce::ConsoleApplication::fail("The index cannot be saved and loaded again", 1);
+    if (numMismatches > 0)
+        juce::ConsoleApplication::fail("The loaded index finds other presets", 1);
+}
+
+static void runSelfTests(const juce::ArgumentList &args)
+{
+    SelfTests::Options options;
+    if (args.containsOption("--mel-reference"))
+        options.melReferenceFile = args.getExistingFileForOption("--mel-reference");
+
+    if (SelfTests::run(options) > 0)
+        juce::ConsoleApplication::fail("Some checks have failed", 1);
+}
+
+int main (int argc, char* argv[])
+{
+    // plugin hosting and OSC need the message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ConsoleApplication app;
+    app.addHelpCommand("--help|-h", helpText, true);
+    app.addDefaultCommand({"",
+                           "--library <dir> [options]",
+                           "Scans, renders and analyzes a preset library",
+                           helpText,
+                           [] (const juce::ArgumentList &args) { runAnalysis(args); }});
+    app.addCommand({"--bench-parse",
+                    "--bench-parse <dir> [--repeat <number>]",
+                    "Times the preset parsers on a library",
+                    helpText,
+                    [] (const juce::ArgumentList &args) { runParseBenchmark(args); }});
+    app.addCommand({"--bench-similar",
+                    "--bench-similar [--presets <number>] [--dimension <number>] [--queries <number>]",
+                    "Times the LatentIndex against the brute force on made-up latent features",
+                    helpText,
+                    [] (const juce::ArgumentList &args) { runSimilarBenchmark(args); }});
+    app.addCommand({"--self-test",
+                    "--self-test [--mel-reference <file>]",
+                    "Checks the parts of the host that need neither a plugin nor the back-end",
+                    helpText,
+                    [] (const juce::ArgumentList &args) { runSelfTests(args); }});
+
+    return app.findAndRunCommand(argc, argv);
+}
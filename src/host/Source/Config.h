@@ -16,7 +16,85 @@ const juce::String LOCAL_ADDRESS = "127.0.0.1";
 const int OSC_RECEIVE_PORT = 9001;
 const int OSC_SEND_PORT = 7777;
 const int UDP_SEND_PORT = 8888;
-const int UDP_MESSAGE_SIZE = 512;
+// The size of a UDP message including its header. Larger messages mean fewer system calls, but
+// macOS doesn't send datagrams larger than 9216 bytes by default (net.inet.udp.maxdgram).
+const int UDP_MESSAGE_SIZE = 9216;
+// the number of UDP messages handed to the OS in one system call where that is supported
+const int UDP_BATCH_SIZE = 64;
+// The receive buffer of the Python program is capped by the OS (net.core.rmem_max, 208 KB by default
+// on Linux), so a large buffer is sent in bursts of this size with a pause in between to let it drain.
+const int UDP_BURST_MAX_BYTES = 131072;
+const int UDP_BURST_PAUSE_MS = 1;
+
+// The audio buffers are sent through the shared memory created by the Python program when it's
+// available, and in UDP messages otherwise. See SharedMemoryTransport.
+const bool USE_SHARED_MEMORY = true;
+const juce::String SHARED_MEMORY_NAME = "/IdeatorAudio";
+// how long to wait for the Python program to free space in the shared memory before falling back to UDP
+const juce::uint32 SHARED_MEMORY_TIMEOUT_MS = 100;
+// The buffers can also be sent over a TCP connection instead of UDP messages, which is chosen at
+// startup with IDEATOR_AUDIO_TRANSPORT=stream. See StreamTransport.
+const juce::String AUDIO_TRANSPORT_ENVIRONMENT_VARIABLE = "IDEATOR_AUDIO_TRANSPORT";
+const int STREAM_PORT = 8889;
+// the number of buffers that can be sent before the Python program has acknowledged them
+const int STREAM_WINDOW_SIZE = 16;
+const int STREAM_TIMEOUT_MS = 5000;
+
+// send the log-mel spectrogram that the auto-encoder takes instead of the audio when possible, see MelSpectrogram
+const bool SEND_MEL_SPECTROGRAM = true;
+
+// the block size of offline rendering, nothing is played in real time, so a large block
+// saves most of the per-call overhead of the plugin
+const int OFFLINE_BLOCK_SIZE = 4096;
+// the number of plugin instances that render the library concurrently, 0 means one per spare CPU core
+const int RENDER_POOL_NUM_WORKERS = 0;
+// the time a render worker may spend on one preset, see RenderPool::setTimeBudget
+const int RENDER_TIME_BUDGET_MS = 15000;
+// the time a render worker may spend on loading a plugin, which doesn't count against the time budget
+const int PLUGIN_LOAD_TIMEOUT_MS = 60000;
+// the number of presets that can be sent to the back-end before their analysis has finished
+const int ANALYSIS_WINDOW_SIZE = 8;
+// the number of presets that are sent in one message and encoded in one pass by the back-end
+const int ANALYSIS_BATCH_SIZE = 16;
+// the time the back-end may take to reply to a preset, it's skipped afterwards, as its message might have been lost
+const int ANALYSIS_REPLY_TIMEOUT_MS = 60000;
+// a batch is sent early when its buffer gets this large, 16 presets of raw audio wouldn't fit the shared memory
+const int ANALYSIS_BATCH_MAX_NUM_SAMPLES = 1 << 20;
+// the OSC messages of a batch are kept below this size, the Python program can receive up to 64 KB
+const int OSC_MAX_MESSAGE_SIZE = 32768;
+// the rendered audio is cached on disk, the least recently used entries are removed beyond this size
+const juce::int64 RENDER_CACHE_MAX_SIZE_MB = 4096;
+// the parsed presets are kept in memory, the least recently used ones are dropped beyond this size
+const juce::int64 PRESET_CACHE_MAX_SIZE_MB = 64;
+// the number of threads that parse the presets of a library, 0 means one per CPU core
+const int LIBRARY_SCAN_NUM_THREADS = 0;
+// the number of presets a scan job parses before handing them to the preset list
+const int LIBRARY_SCAN_JOB_SIZE = 32;
+// how often the library is rescanned for the presets that have been changed while Ideator is running, 0 means never
+const int LIBRARY_WATCH_INTERVAL_MS = 10000;
+// the number of recently used plugins whose instances are kept alive after switching to another plugin
+const int NUM_WARM_PLUGINS = 4;
+// the number of presets that finding similar presets shows, the back-end shows as many
+const int NUM_SIMILAR_PRESETS = 5;
+// the number of links of a preset on every level of the LatentIndex, the bottom level has twice as many
+const int LATENT_INDEX_NUM_NEIGHBOURS = 16;
+// the number of candidates that are kept while a preset is inserted or looked up in the LatentIndex,
+// wider beams miss fewer of the closest presets and take longer
+const int LATENT_INDEX_INSERTION_BEAM_WIDTH = 100;
+const int LATENT_INDEX_SEARCH_BEAM_WIDTH = 64;
+
+// the timbre descriptors that Ideator suggests, they get the first ids in the DescriptorRegistry
+const juce::StringArray TIMBRE_DESCRIPTORS { "Bright", "Dark",
+                                             "Dynamic", "Static",
+                                             "Constant", "Moving",
+                                             "Soft", "Aggressive",
+                                             "Harmonic", "Inharmonic",
+                                             "Phat", "Thin",
+                                             "Clean", "Dirty",
+                                             "Wide", "Narrow",
+                                             "Modern", "Vintage",
+                                             "Acoustic", "Electric",
+                                             "Natural", "Synthetic" };
 
 const juce::String OSC_SEND_PATTERN = "/Ideator/python/";
 const juce::String OSC_RECEIVE_PATTERN = "/Ideator/cpp/";
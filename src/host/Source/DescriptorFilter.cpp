@@ -0,0 +1,142 @@
+/*
+  ==============================================================================
+
+    DescriptorFilter.cpp
+    Created: 17 Oct 2026 8:08:28pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#include "DescriptorFilter.h"
+
+DescriptorFilter::DescriptorFilter()
+{
+    modes.fill(Mode::off);
+    counts.fill(0);
+}
+
+void DescriptorFilter::build(const LibraryIndex &index)
+{
+    clear();
+
+    // the presets are visited in the order of their positions, so every bitmap is only appended to
+    numPresets = index.getNumPresets();
+    for (int i = 0; i < numPresets; ++i)
+    {
+        if (!index.isParsable(i))
+            continue;
+
+        const auto position = static_cast<juce::uint32>(i);
+        parsablePresets.add(position);
+        const auto bits = index.getDescriptors(i).getBits();
+        for (int id = 0; id < DescriptorRegistry::maxNumWords; ++id)
+            if ((bits >> id & 1) != 0)
+                descriptorBitmaps[(size_t) id].add(position);
+    }
+}
+
+void DescriptorFilter::clear()
+{
+    numPresets = 0;
+    parsablePresets.clear();
+    for (auto &bitmap : descriptorBitmaps)
+        bitmap.clear();
+    isUpToDate = false;
+}
+
+int DescriptorFilter::getNumPresets() const
+{
+    return numPresets;
+}
+
+void DescriptorFilter::setMode(int descriptorId, Mode mode)
+{
+    if (!juce::isPositiveAndBelow(descriptorId, DescriptorRegistry::maxNumWords))
+        return;
+
+    modes[(size_t) descriptorId] = mode;
+    isUpToDate = false;
+}
+
+DescriptorFilter::Mode DescriptorFilter::getMode(int descriptorId) const
+{
+    if (!juce::isPositiveAndBelow(descriptorId, DescriptorRegistry::maxNumWords))
+        return Mode::off;
+    return modes[(size_t) descriptorId];
+}
+
+void DescriptorFilter::resetModes()
+{
+    modes.fill(Mode::off);
+    isUpToDate = false;
+}
+
+bool DescriptorFilter::isActive() const
+{
+    for (auto mode : modes)
+        if (mode != Mode::off)
+            return true;
+    return false;
+}
+
+const RoaringBitmap& DescriptorFilter::getMatches()
+{
+    update();
+    return matches;
+}
+
+int DescriptorFilter::getNumMatches()
+{
+    update();
+    return matches.getCardinality();
+}
+
+int DescriptorFilter::getCount(int descriptorId)
+{
+    if (!juce::isPositiveAndBelow(descriptorId, DescriptorRegistry::maxNumWords))
+        return 0;
+
+    update();
+    return counts[(size_t) descriptorId];
+}
+
+juce::Array<int> DescriptorFilter::getDescriptorIds() const
+{
+    juce::Array<int> descriptorIds;
+    for (int id = 0; id < DescriptorRegistry::maxNumWords; ++id)
+        if (!descriptorBitmaps[(size_t) id].isEmpty())
+            descriptorIds.add(id);
+    return descriptorIds;
+}
+
+void DescriptorFilter::update()
+{
+    if (isUpToDate)
+        return;
+
+    // (all of the "all" descriptors) and (any of the "any" descriptors) and not (any of the "none" descriptors)
+    matches = parsablePresets;
+    RoaringBitmap anyMatches;
+    bool hasAnyMode = false;
+    for (size_t id = 0; id < modes.size(); ++id)
+    {
+        if (modes[id] == Mode::all)
+            matches = RoaringBitmap::intersect(matches, descriptorBitmaps[id]);
+        else if (modes[id] == Mode::any)
+        {
+            anyMatches = RoaringBitmap::unite(anyMatches, descriptorBitmaps[id]);
+            hasAnyMode = true;
+        }
+    }
+    if (hasAnyMode)
+        matches = RoaringBitmap::intersect(matches, anyMatches);
+    for (size_t id = 0; id < modes.size(); ++id)
+        if (modes[id] == Mode::none)
+            matches = RoaringBitmap::subtract(matches, descriptorBitmaps[id]);
+
+    for (size_t id = 0; id < counts.size(); ++id)
+        counts[id] = descriptorBitmaps[id].isEmpty() ? 0 : RoaringBitmap::getIntersectionCardinality(matches, descriptorBitmaps[id]);
+
+    isUpToDate = true;
+}
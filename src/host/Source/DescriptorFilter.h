@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    DescriptorFilter.h
+    Created: 17 Oct 2026 8:08:28pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include "DescriptorRegistry.h"
+#include "LibraryIndex.h"
+#include "RoaringBitmap.h"
+
+// Filters the presets of a library by their descriptors in the host. Every descriptor has a
+// bitmap of the presets (their positions in the LibraryIndex) that have it, so a filter is a
+// handful of bitmap operations and doesn't need the back-end. Along with the matching presets,
+// it counts how many of them have each descriptor, which is what the facets show.
+class DescriptorFilter
+{
+public:
+    enum class Mode
+    {
+        off,
+        all,  // the presets must have this descriptor
+        any,  // the presets must have at least one of the descriptors in this mode
+        none  // the presets must not have this descriptor
+    };
+
+    DescriptorFilter();
+
+    /*!
+     * Builds the bitmaps of a library, the modes are kept.
+     * @param index the index of the library, the unparsable presets are left out
+     */
+    void build(const LibraryIndex &index);
+
+    void clear();
+
+    // the number of presets in the index the bitmaps have been built from
+    int getNumPresets() const;
+
+    void setMode(int descriptorId, Mode mode);
+    Mode getMode(int descriptorId) const;
+    void resetModes();
+    // false if every descriptor is off, all the presets match then
+    bool isActive() const;
+
+    // the positions of the matching presets in the index
+    const RoaringBitmap& getMatches();
+    int getNumMatches();
+
+    /*!
+     * @param descriptorId the id in the DescriptorRegistry
+     * @return the number of matching presets that have the descriptor
+     */
+    int getCount(int descriptorId);
+
+    // the descriptors that at least one preset of the library has, in the order of their ids
+    juce::Array<int> getDescriptorIds() const;
+
+private:
+    void update();
+
+    int numPresets = 0;
+    RoaringBitmap parsablePresets;
+    std::array<RoaringBitmap, DescriptorRegistry::maxNumWords> descriptorBitmaps;
+    std::array<Mode, DescriptorRegistry::maxNumWords> modes;
+
+    bool isUpToDate = false;
+    RoaringBitmap matches;
+    std::array<int, DescriptorRegistry::maxNumWords> counts;
+
+    JUCE_DECLARE_NON_COPYABLE (DescriptorFilter)
+};
@@ -0,0 +1,165 @@
+/*
+  ==============================================================================
+
+    DescriptorRegistry.cpp
+    Created: 17 Oct 2026 8:05:02pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#include "DescriptorRegistry.h"
+#include "Config.h"
+#include <cstring>
+
+// ========================================
+// DescriptorRegistry
+// ========================================
+
+DescriptorRegistry& DescriptorRegistry::getInstance()
+{
+    static DescriptorRegistry instance;
+    return instance;
+}
+
+DescriptorRegistry::DescriptorRegistry()
+{
+    for (const auto &word : TIMBRE_DESCRIPTORS)
+        intern(word);
+}
+
+int DescriptorRegistry::intern(const juce::String &word)
+{
+    if (word.isEmpty())
+        return -1;
+
+    int id = find(word.toRawUTF8(), word.getNumBytesAsUTF8());
+    if (id >= 0)
+        return id;
+
+    const juce::ScopedLock sl(lock);
+    // another thread may have added the word in the meantime
+    id = find(word.toRawUTF8(), word.getNumBytesAsUTF8());
+    if (id >= 0)
+        return id;
+
+    const int newId = numWords.load();
+    if (newId >= maxNumWords)
+    {
+        DBG("DescriptorRegistry::intern: no id left for " << word);
+        return -1;
+    }
+
+    words[static_cast<size_t>(newId)] = word;
+    // the word has to be in place before the other threads can see it
+    numWords.store(newId + 1, std::memory_order_release);
+    return newId;
+}
+
+int DescriptorRegistry::find(const char* word, size_t numBytes) const
+{
+    // there are only a few dozen words, comparing them is faster than hashing the word
+    const int n = numWords.load(std::memory_order_acquire);
+    for (int id = 0; id < n; ++id)
+    {
+        const auto &registeredWord = words[static_cast<size_t>(id)];
+        if (registeredWord.getNumBytesAsUTF8() == numBytes
+            && std::memcmp(registeredWord.toRawUTF8(), word, numBytes) == 0)
+            return id;
+    }
+    return -1;
+}
+
+juce::String DescriptorRegistry::getWord(int id) const
+{
+    if (!juce::isPositiveAndBelow(id, numWords.load(std::memory_order_acquire)))
+        return {};
+    return words[static_cast<size_t>(id)];
+}
+
+int DescriptorRegistry::getNumWords() const
+{
+    return numWords.load(std::memory_order_acquire);
+}
+
+// ========================================
+// DescriptorSet
+// ========================================
+
+DescriptorSet DescriptorSet::fromString(const juce::String &descriptorString)
+{
+    return fromString(descriptorString.toRawUTF8(), descriptorString.getNumBytesAsUTF8());
+}
+
+DescriptorSet DescriptorSet::fromString(const char* text, size_t numBytes)
+{
+    auto &registry = DescriptorRegistry::getInstance();
+    auto isSeparator = [] (char c) { return c == ',' || c == ' ' || c == '&'; };
+
+    DescriptorSet descriptors;
+    const char* end = text + numBytes;
+    while (text < end)
+    {
+        while (text < end && isSeparator(*text))
+            ++text;
+        const char* wordStart = text;
+        while (text < end && !isSeparator(*text))
+            ++text;
+        if (text == wordStart)
+            break;
+
+        int id = registry.find(wordStart, static_cast<size_t>(text - wordStart));
+        if (id < 0)
+        {
+            const auto word = juce::String::fromUTF8(wordStart, static_cast<int>(text - wordStart));
+            id = registry.intern(word);
+            if (id < 0)
+            {
+                descriptors.addExtraWord(word);
+                continue;
+            }
+        }
+        descriptors.add(id);
+    }
+    return descriptors;
+}
+
+juce::String DescriptorSet::toString() const
+{
+    auto &registry = DescriptorRegistry::getInstance();
+    juce::String descriptorString;
+    for (int id = 0; id < DescriptorRegistry::maxNumWords; ++id)
+    {
+        if (!contains(id))
+            continue;
+        if (descriptorString.isNotEmpty())
+            descriptorString << ", ";
+        descriptorString << registry.getWord(id);
+    }
+
+    for (const auto &word : extraWords)
+    {
+        if (descriptorString.isNotEmpty())
+            descriptorString << ", ";
+        descriptorString << word;
+    }
+    return descriptorString;
+}
+
+juce::StringArray DescriptorSet::toWords() const
+{
+    auto &registry = DescriptorRegistry::getInstance();
+    juce::StringArray descriptorWords;
+    for (int id = 0; id < DescriptorRegistry::maxNumWords; ++id)
+        if (contains(id))
+            descriptorWords.add(registry.getWord(id));
+    descriptorWords.addArray(extraWords);
+    return descriptorWords;
+}
+
+void DescriptorSet::addExtraWord(const juce::String &word)
+{
+    // sorted, so the same words compare equal in any order
+    if (word.isNotEmpty() && extraWords.addIfNotAlreadyThere(word))
+        extraWords.sort(false);
+}
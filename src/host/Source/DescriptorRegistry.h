@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    DescriptorRegistry.h
+    Created: 17 Oct 2026 8:05:02pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+// Gives every descriptor word a small id, so the descriptors of a preset can be kept as a
+// DescriptorSet. The timbre descriptors of TIMBRE_DESCRIPTORS always have the first ids, the
+// words that the user types get the next ones as they appear. The ids only live as long as
+// the process, the descriptors are stored and sent as strings. It's safe to use from several threads.
+// The words beyond maxNumWords get no id, DescriptorSet keeps them as strings.
+class DescriptorRegistry
+{
+public:
+    static constexpr int maxNumWords = 64;
+
+    static DescriptorRegistry& getInstance();
+
+    /*!
+     * @param word the descriptor
+     * @return the id of the word, it gets a new one if it's not registered yet, -1 if there is no id left
+     */
+    int intern(const juce::String &word);
+
+    /*!
+     * Looks a word up without creating a string, this doesn't take a lock.
+     * @param word the descriptor in UTF-8, it doesn't need to be null-terminated
+     * @param numBytes the length of the word in bytes
+     * @return the id of the word, -1 if it's not registered
+     */
+    int find(const char* word, size_t numBytes) const;
+
+    // the word of an id, an empty string if the id is not in use
+    juce::String getWord(int id) const;
+
+    int getNumWords() const;
+
+private:
+    DescriptorRegistry();
+
+    juce::CriticalSection lock;
+    // the words are never changed once they have been added, so they can be read without the lock
+    std::array<juce::String, maxNumWords> words;
+    std::atomic<int> numWords { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (DescriptorRegistry)
+};
+
+// The descriptors of a preset, bit i stands for the word with id i in the DescriptorRegistry.
+// The strings are only used to read and write presets and to talk to the Python program.
+// A word that the registry has no id left for is kept as a string next to the bits, so the
+// descriptors are written back unchanged, but it can't be filtered by.
+class DescriptorSet
+{
+public:
+    DescriptorSet() = default;
+    explicit DescriptorSet(juce::uint64 bits): bits(bits) {}
+
+    /*!
+     * Parses the descriptors of a preset file or an OSC message, the words are separated by commas,
+     * spaces or ampersands. The new words are registered.
+     */
+    static DescriptorSet fromString(const juce::String &descriptorString);
+    static DescriptorSet fromString(const char* text, size_t numBytes);
+
+    // the words in the order of their ids, then the words without an id, separated by ", "
+    juce::String toString() const;
+    juce::StringArray toWords() const;
+
+    // adds a word that has no id in the DescriptorRegistry
+    void addExtraWord(const juce::String &word);
+    // the words that have no id, sorted, empty for almost every preset
+    const juce::StringArray& getExtraWords() const { return extraWords; }
+    bool hasExtraWords() const { return !extraWords.isEmpty(); }
+
+    bool contains(int id) const { return juce::isPositiveAndBelow(id, DescriptorRegistry::maxNumWords) && (bits >> id & 1) != 0; }
+    void add(int id) { if (juce::isPositiveAndBelow(id, DescriptorRegistry::maxNumWords)) bits |= (juce::uint64) 1 << id; }
+    void remove(int id) { if (juce::isPositiveAndBelow(id, DescriptorRegistry::maxNumWords)) bits &= ~((juce::uint64) 1 << id); }
+    void clear() { bits = 0; extraWords.clearQuick(); }
+    bool isEmpty() const { return bits == 0 && extraWords.isEmpty(); }
+    int size() const { return juce::countNumberOfBits(bits) + extraWords.size(); }
+    // only the words that have an id
+    juce::uint64 getBits() const { return bits; }
+
+    bool operator== (const DescriptorSet &other) const { return bits == other.bits && extraWords == other.extraWords; }
+    bool operator!= (const DescriptorSet &other) const { return !(*this == other); }
+
+private:
+    juce::uint64 bits = 0;
+    juce::StringArray extraWords;
+};
@@ -10,6 +10,7 @@
 
 #include "Interface.h"
 #include "Config.h"
+#include "PresetCache.h"
 
 // ================================================
 // PresetTableModel
@@ -50,12 +51,12 @@ void PresetTableModel::paintCell (juce::Graphics &g, int rowNumber, int columnId
     g.setColour(juce::Colours::whitesmoke);
     if (columnId == 1)
     {
-        auto presetName = getPresetNameFromPath(presetPaths[rowNumber]);
+        const auto &presetName = getPresetName(rowNumber);
         g.drawFittedText(presetName, {6, 0, width - 12, height}, juce::Justification::centredLeft, 1, 1.f);
     }
     else
     {
-        auto descriptorString = PresetManager::descriptorsToString(descriptors[rowNumber]);
+        const auto &descriptorString = getDescriptorDisplayString(descriptors.getReference(rowNumber));
         g.drawFittedText(descriptorString, {6,0,width - 12,height}, juce::Justification::centredLeft, 1, 1.f);
     }
 
@@ -82,24 +83,77 @@ void PresetTableModel::resized()
     presetTable.setBounds(getLocalBounds());
 }
 
-void PresetTableModel::addItem(const juce::String &pluginPath, const juce::String &presetPath, const std::unordered_set<juce::String> &descriptors)
+void PresetTableModel::addItem(const juce::String &pluginPath, const juce::String &presetPath, const DescriptorSet &descriptors)
 {
     this->pluginPaths.add(pluginPath);
     this->descriptors.add(descriptors);
     this->presetPaths.add(presetPath);
-    presetTable.updateContent();
+    // the rows added in one go only update the table once
+    triggerAsyncUpdate();
     // presetTable.selectRow(getNumRows() - 1);
 }
 
+void PresetTableModel::addItems(const std::vector<LibraryIndex::Preset> &presets)
+{
+    if (presets.empty())
+        return;
+
+    reserve(getNumRows() + static_cast<int>(presets.size()));
+    for (const auto &preset : presets)
+    {
+        pluginPaths.add(preset.pluginPath);
+        descriptors.add(preset.descriptors);
+        presetPaths.add(preset.presetPath);
+    }
+    triggerAsyncUpdate();
+}
+
+void PresetTableModel::reserve(int numRows)
+{
+    pluginPaths.ensureStorageAllocated(numRows);
+    descriptors.ensureStorageAllocated(numRows);
+    presetPaths.ensureStorageAllocated(numRows);
+}
+
 void PresetTableModel::clear()
 {
     pluginPaths.clear();
     descriptors.clear();
     presetPaths.clear();
+    presetNames.clear();
+    cancelPendingUpdate();
     presetTable.selectRow(0);
     presetTable.updateContent();
 }
 
+void PresetTableModel::handleAsyncUpdate()
+{
+    presetTable.updateContent();
+}
+
+const juce::String& PresetTableModel::getPresetName(int rowNumber)
+{
+    // the names are only made for the rows that are painted, in a large library most never are
+    if (presetNames.size() < static_cast<size_t>(presetPaths.size()))
+        presetNames.resize(static_cast<size_t>(presetPaths.size()));
+
+    auto &presetName = presetNames[static_cast<size_t>(rowNumber)];
+    if (presetName.isEmpty())
+        presetName = getPresetNameFromPath(presetPaths.getReference(rowNumber));
+    return presetName;
+}
+
+const juce::String& PresetTableModel::getDescriptorDisplayString(const DescriptorSet &descriptorSet)
+{
+    if (descriptorSet.hasExtraWords())
+        return *extraDescriptorStrings.insert(descriptorSet.toString()).first;
+
+    auto it = descriptorStrings.find(descriptorSet.getBits());
+    if (it == descriptorStrings.end())
+        it = descriptorStrings.emplace(descriptorSet.getBits(), descriptorSet.toString()).first;
+    return it->second;
+}
+
 const juce::String& PresetTableModel::getPluginPath() const
 {
     return currentPluginPath;
@@ -117,19 +171,124 @@ const juce::Array<juce::String>& PresetTableModel::getLibraryPresetPaths() const
 
 juce::String PresetTableModel::getDescriptorString() const
 {
-    return PresetManager::descriptorsToString(currentDescriptors);
+    return currentDescriptors.toString();
 }
 
-const std::unordered_set<juce::String>& PresetTableModel::getDescriptors() const
+const DescriptorSet& PresetTableModel::getDescriptors() const
 {
     return currentDescriptors;
 }
 
 juce::String PresetTableModel::getPresetNameFromPath(const juce::String& path)
 {
-    juce::StringArray tokens;
-    tokens.addTokens (path, "/\\", "\"");
-    return tokens[tokens.size()-1].trimCharactersAtEnd(".xml");
+    // trimCharactersAtEnd(".xml") would also eat the trailing l, m and x of the name itself
+    auto fileName = path.substring(juce::jmax(path.lastIndexOfChar('/'), path.lastIndexOfChar('\\')) + 1);
+    return fileName.endsWithIgnoreCase(".xml") ? fileName.dropLastCharacters(4) : fileName;
+}
+
+// ================================================
+// DescriptorFilterPanel
+// ================================================
+
+static const int filterButtonWidth = 120;
+static const int filterButtonHeight = 24;
+static const int filterButtonGap = 4;
+
+DescriptorFilterPanel::DescriptorFilterPanel(DescriptorFilter &filter):
+        filter(filter)
+{
+    clearButton.onClick = [this] { clearButtonClicked(); };
+    addAndMakeVisible(clearButton);
+}
+
+void DescriptorFilterPanel::refresh()
+{
+    auto newDescriptorIds = filter.getDescriptorIds();
+    if (newDescriptorIds != descriptorIds)
+    {
+        descriptorIds = newDescriptorIds;
+        descriptorButtons.clear();
+        for (auto id : descriptorIds)
+        {
+            auto button = descriptorButtons.add(new juce::TextButton());
+            button->onClick = [this, id] { descriptorButtonClicked(id); };
+            addAndMakeVisible(button);
+        }
+        resized();
+    }
+
+    updateButtons();
+}
+
+int DescriptorFilterPanel::getHeightForWidth(int width) const
+{
+    const int numColumns = juce::jmax(1, (width + filterButtonGap) / (filterButtonWidth + filterButtonGap));
+    const int numRows = (descriptorButtons.size() + 1 + numColumns - 1) / numColumns;
+    return numRows * (filterButtonHeight + filterButtonGap);
+}
+
+void DescriptorFilterPanel::resized()
+{
+    const int numColumns = juce::jmax(1, (getWidth() + filterButtonGap) / (filterButtonWidth + filterButtonGap));
+    auto placeButton = [numColumns] (juce::Component &button, int position) {
+        button.setBounds((position % numColumns) * (filterButtonWidth + filterButtonGap),
+                         (position / numColumns) * (filterButtonHeight + filterButtonGap),
+                         filterButtonWidth, filterButtonHeight);
+    };
+
+    for (int i = 0; i < descriptorButtons.size(); ++i)
+        placeButton(*descriptorButtons[i], i);
+    placeButton(clearButton, descriptorButtons.size());
+}
+
+void DescriptorFilterPanel::descriptorButtonClicked(int descriptorId)
+{
+    // off -> all -> any -> none -> off
+    using Mode = DescriptorFilter::Mode;
+    switch (filter.getMode(descriptorId))
+    {
+        case Mode::off:  filter.setMode(descriptorId, Mode::all); break;
+        case Mode::all:  filter.setMode(descriptorId, Mode::any); break;
+        case Mode::any:  filter.setMode(descriptorId, Mode::none); break;
+        case Mode::none: filter.setMode(descriptorId, Mode::off); break;
+    }
+
+    updateButtons();
+    filterChangedBroadcaster.sendChangeMessage();
+}
+
+void DescriptorFilterPanel::clearButtonClicked()
+{
+    if (!filter.isActive())
+        return;
+
+    filter.resetModes();
+    updateButtons();
+    filterChangedBroadcaster.sendChangeMessage();
+}
+
+void DescriptorFilterPanel::updateButtons()
+{
+    auto &registry = DescriptorRegistry::getInstance();
+    for (int i = 0; i < descriptorButtons.size(); ++i)
+    {
+        const int id = descriptorIds[i];
+        auto button = descriptorButtons[i];
+
+        juce::String prefix;
+        auto colour = getLookAndFeel().findColour(juce::TextButton::buttonColourId);
+        switch (filter.getMode(id))
+        {
+            case DescriptorFilter::Mode::off:  break;
+            case DescriptorFilter::Mode::all:  prefix = "+ "; colour = juce::Colours::darkgreen; break;
+            case DescriptorFilter::Mode::any:  prefix = "| "; colour = juce::Colours::steelblue; break;
+            case DescriptorFilter::Mode::none: prefix = "- "; colour = juce::Colours::darkred; break;
+        }
+
+        // the counts are over the presets that match, so they tell what ticking a descriptor would leave
+        button->setButtonText(prefix + registry.getWord(id) + " (" + juce::String(filter.getCount(id)) + ")");
+        button->setColour(juce::TextButton::buttonColourId, colour);
+    }
 }
 
 // ================================================
@@ -139,6 +298,7 @@ juce::String PresetTableModel::getPresetNameFromPath(const juce::String& path)
 Interface::Interface(ProcessorManager& pm, OSCManager& oscManager) :
         processorManager(pm),
         oscManager(oscManager),
+        libraryScanner(LIBRARY_SCAN_NUM_THREADS),
         midiKeyboard(keyboardState, juce::MidiKeyboardComponent::horizontalKeyboard)
 {
     // Make sure you set the size of the component after
@@ -149,12 +309,22 @@ Interface::Interface(ProcessorManager& pm, OSCManager& oscManager) :
 
     oscManager.selectedPresetsReadyBroadcaster.addChangeListener(this);
     oscManager.autoTagsReadyBroadcaster.addChangeListener(this);
+    oscManager.storedPresetsReadyBroadcaster.addChangeListener(this);
     presetList.cellClickedBroadcaster.addChangeListener(this);
     presetList.cellDoubleClickedBroadcaster.addChangeListener(this);
+    libraryScanner.scanProgressBroadcaster.addChangeListener(this);
+    descriptorFilterPanel.filterChangedBroadcaster.addChangeListener(this);
+    libraryScanner.setWatchInterval(LIBRARY_WATCH_INTERVAL_MS);
+    processorManager.getLibraryAnalyzedBroadcaster().addChangeListener(this);
+    processorManager.getSimilarPresetsFoundBroadcaster().addChangeListener(this);
 }
 
 Interface::~Interface()
 {
+    // the plugin processor outlives the editor
+    processorManager.getLibraryAnalyzedBroadcaster().removeChangeListener(this);
+    processorManager.getSimilarPresetsFoundBroadcaster().removeChangeListener(this);
+
     if (pluginWindow)
         pluginWindow.deleteAndZero();
 
@@ -189,6 +359,10 @@ void Interface::resized()
                                                    buttonSize.getWidth(), buttonSize.getHeight());
     juce::Rectangle<int> synthNameLabelArea (margin, margin + buttonDistance * 4,
                                              buttonSize.getWidth(), buttonSize.getHeight());
+    juce::Rectangle<int> libraryScanProgressBarArea (margin, margin + buttonDistance * 5,
+                                                     buttonSize.getWidth(), buttonSize.getHeight());
+    juce::Rectangle<int> cancelLibraryScanButtonArea (margin, margin + buttonDistance * 6,
+                                                      buttonSize.getWidth(), buttonSize.getHeight());
     juce::Rectangle<int> loadPresetButtonArea (margin,
                                                getHeight() - keyboardHeight - margin * 2 - buttonDistance * 2,
                                                buttonSize.getWidth(), buttonSize.getHeight());
@@ -219,6 +393,10 @@ void Interface::resized()
                                                 margin + buttonDistance,
                                                 smallButtonSize.getWidth(),
                                                 smallButtonSize.getHeight());
+    juce::Rectangle<int> filterButtonArea (getWidth() - margin - smallButtonSize.getWidth(),
+                                           margin + buttonDistance * 2,
+                                           smallButtonSize.getWidth(),
+                                           smallButtonSize.getHeight());
     juce::Rectangle<int> presetListUndoButtonArea (getWidth() - margin - smallButtonSize.getWidth(),
                                                    getHeight() - keyboardHeight - margin * 2 - buttonDistance * 3,
                                                    smallButtonSize.getWidth()/2, smallButtonSize.getHeight());
@@ -232,6 +410,12 @@ void Interface::resized()
                                                getHeight() - keyboardHeight - margin * 2 - buttonDistance,
                                                smallButtonSize.getWidth(), smallButtonSize.getHeight());
 
+    // the filter panel takes the top of the preset list
+    juce::Rectangle<int> descriptorFilterPanelArea;
+    if (descriptorFilterPanel.isVisible())
+        descriptorFilterPanelArea = presetListArea.removeFromTop(
+                descriptorFilterPanel.getHeightForWidth(presetListArea.getWidth()));
+
     // keyboard
     juce::Rectangle<int> keyboardArea (margin, getHeight() - keyboardHeight - margin,
                                        getWidth() - 2 * margin, keyboardHeight);
@@ -242,6 +426,7 @@ void Interface::resized()
     analyzeLibraryButton.setBounds(analyzeLibraryButtonArea);
     searchButton.setBounds(searchButtonArea);
     findSimilarButton.setBounds(findSimilarButtonArea);
+    filterButton.setBounds(filterButtonArea);
     presetListUndoButton.setBounds(presetListUndoButtonArea);
     presetListRedoButton.setBounds(presetListRedoButtonArea);
     autoTagButton.setBounds(autoTagButtonArea);
@@ -250,8 +435,11 @@ void Interface::resized()
     savePresetButton.setBounds(savePresetButtonArea);
     tagInputBox.setBounds(tagInputBoxArea);
     synthNameLabel.setBounds(synthNameLabelArea);
+    libraryScanProgressBar.setBounds(libraryScanProgressBarArea);
+    cancelLibraryScanButton.setBounds(cancelLibraryScanButtonArea);
     statusLabel.setBounds(statusLabelArea);
     presetList.setBounds(presetListArea);
+    descriptorFilterPanel.setBounds(descriptorFilterPanelArea);
     tagEditInputBox.setBounds(tagEditInputBoxArea);
     midiKeyboard.setBounds(keyboardArea);
 }
@@ -273,6 +461,11 @@ void Interface::initializeComponents()
     findSimilarButton.onClick = [this] {findSimilarButtonClicked(); };
     addAndMakeVisible(findSimilarButton);
 
+    filterButton.setClickingTogglesState(true);
+    filterButton.onClick = [this] {filterButtonClicked(); };
+    addAndMakeVisible(filterButton);
+    addChildComponent(descriptorFilterPanel);
+
     presetListUndoButton.onClick = [this] {presetListUndoButtonClicked(); };
     addAndMakeVisible(presetListUndoButton);
     presetListUndoButton.setEnabled(undoStack.isUndoAvailable());
@@ -296,6 +489,11 @@ void Interface::initializeComponents()
     setLibraryButton.onClick = [this] {setLibraryButtonClicked(); };
     addAndMakeVisible(setLibraryButton);
 
+    // only shown while a library is being scanned
+    addChildComponent(libraryScanProgressBar);
+    cancelLibraryScanButton.onClick = [this] {cancelLibraryScanButtonClicked(); };
+    addChildComponent(cancelLibraryScanButton);
+
     addAndMakeVisible(tagInputBox);
     addAndMakeVisible(tagEditInputBox);
     addAndMakeVisible(presetList);
@@ -327,12 +525,16 @@ void Interface::changeListenerCallback(juce::ChangeBroadcaster *source)
         openPluginEditorCallback();
     }
 
-    else if (source == &oscManager.selectedPresetsReadyBroadcaster)
+    else if (source == &oscManager.selectedPresetsReadyBroadcaster
+             || source == &processorManager.getSimilarPresetsFoundBroadcaster())
     {
-        auto presetPaths = oscManager.getSelectedPresetPaths();
+        // the host finds the similar presets itself once it has analyzed the library
+        auto presetPaths = source == &oscManager.selectedPresetsReadyBroadcaster ? oscManager.getSelectedPresetPaths()
+                                                                                   : processorManager.getSimilarPresetPaths();
         if (!presetPaths.isEmpty())
         {
             setPresetList(presetPaths);
+            isShowingLibrary = false;
             undoStack.push(presetPaths);
             presetListUndoButton.setEnabled(undoStack.isUndoAvailable());
             presetListRedoButton.setEnabled(undoStack.isRedoAvailable());
@@ -344,6 +546,27 @@ void Interface::changeListenerCallback(juce::ChangeBroadcaster *source)
         auto autoTags = oscManager.getAutoTags();
         tagEditInputBox.setText(autoTags.joinIntoString(", "));
     }
+
+    else if (source == &libraryScanner.scanProgressBroadcaster)
+    {
+        libraryScanProgressCallback();
+    }
+
+    else if (source == &oscManager.storedPresetsReadyBroadcaster)
+    {
+        storedPresetsReadyCallback();
+    }
+
+    else if (source == &descriptorFilterPanel.filterChangedBroadcaster)
+    {
+        descriptorFilterChangedCallback();
+    }
+
+    else if (source == &processorManager.getLibraryAnalyzedBroadcaster())
+    {
+        // the next analysis only needs the presets that change after this one
+        libraryScanner.markAnalyzed(processorManager.getAnalyzedPresetPaths(), libraryAnalysisStartTime);
+    }
 }
 
 void Interface::labelTextChanged(juce::Label *labelThatHasChanged)
@@ -403,30 +626,21 @@ void Interface::loadPluginCallback(const juce::String &path)
 
 void Interface::loadPresetCallback(const juce::String &path)
 {
-    juce::String descriptorString;
-
-    // Load the plugin if the plugin is different from the current one
-    // it's possible that the presetList returns an empty plugin path when
+    // it's possible that the presetList returns an empty path when
     // the user imports a new library after he/she loads a plugin.
-    // so it's necessary to reject the empty plugin path.
-    if (path != processorManager.getPluginPath() && !path.isEmpty())
-    {
-        // parse the preset
-        juce::File file(path);
-        auto xmlPreset = juce::XmlDocument::parse(file);
-        if (!xmlPreset)
-            return;
-        juce::String pluginPath;
-        std::unordered_set<juce::String> descriptors;
-        juce::Array<std::pair<int, float>> parameters;
-        auto isSuccessful = PresetManager::parse(*xmlPreset, parameters, pluginPath, descriptors);
-        if (!isSuccessful)
-            return;
-        descriptorString = PresetManager::descriptorsToString(descriptors);
+    // so it's necessary to reject the empty path.
+    if (path.isEmpty())
+        return;
 
-        // load the plugin
-        loadPluginCallback(pluginPath);
-    }
+    // the preset is parsed only once, PluginManager::loadPreset gets it from the cache as well
+    auto preset = PresetCache::getInstance().get(path);
+    if (!preset)
+        return;
+    const auto descriptorString = preset->descriptors.toString();
+
+    // Load the plugin if the plugin is different from the current one
+    if (preset->pluginPath != processorManager.getPluginPath())
+        loadPluginCallback(preset->pluginPath);
 
     // load the preset
     if (!processorManager.loadPreset(path))
@@ -476,23 +690,111 @@ void Interface::openPluginEditorCallback()
 void Interface::setPresetList(const juce::StringArray &presetPaths)
 {
     presetList.clear();
+    presetList.reserve(presetPaths.size());
 
+    // undo, redo and the search results mostly show presets that have been shown before, so they come from the cache
+    auto &presetCache = PresetCache::getInstance();
     for (const auto &path : presetPaths)
     {
-        juce::File file(path); // the path is already a absolute path
-        auto xmlPreset = juce::XmlDocument::parse(file);
-        if (!xmlPreset)
-            return;
+        // the path is already a absolute path
+        auto preset = presetCache.get(path);
+        if (!preset)
+            continue;
+
+        presetList.addItem(preset->pluginPath, path, preset->descriptors);
+    }
+}
+
+void Interface::libraryScanProgressCallback()
+{
+    // the change messages are coalesced, so everything scanned since the last one arrives in one batch
+    presetList.addItems(libraryScanner.popScannedPresets());
+    libraryScanProgress = libraryScanner.getProgress();
+
+    if (libraryScanner.isScanning())
+        return;
 
-        juce::String pluginPath;
-        std::unordered_set<juce::String> descriptors;
-        juce::Array<std::pair<int, float>> parameters;
-        auto isSuccessful = PresetManager::parse(*xmlPreset, parameters, pluginPath, descriptors);
-        if (!isSuccessful)
+    libraryScanProgressBar.setVisible(false);
+    cancelLibraryScanButton.setVisible(false);
+    setLibraryButton.setEnabled(true);
+
+    const auto stats = libraryScanner.getStats();
+    updateLibraryPresets(stats.isCancelled);
+
+    const bool hasChanged = stats.isListing || stats.numChanged > 0 || stats.numRemoved > 0;
+    if (hasChanged)
+    {
+        // the presets may have moved in the index, so the bitmaps are built again
+        descriptorFilter.build(libraryScanner.getIndex());
+        descriptorFilterPanel.refresh();
+        resized();
+    }
+
+    // a listing has already put the whole library into presetList, it only needs to be filtered
+    if (isShowingLibrary && (isFilterPending || (hasChanged && (!stats.isListing || descriptorFilter.isActive()))))
+        showLibraryPresets();
+    isFilterPending = false;
+
+    // the rescans in the background only show up when something has changed
+    if (!hasChanged)
+        return;
+
+    juce::String status = "Library Path: " + libraryPath + " (" + juce::String(stats.numPresets) + " presets, "
+                          + juce::String(stats.numChanged) + " new or changed";
+    if (stats.numRemoved > 0)
+        status << ", " << stats.numRemoved << " removed";
+    if (stats.numUnparsable > 0)
+        status << ", " << stats.numUnparsable << " skipped";
+    if (stats.isCancelled)
+        status << ", cancelled";
+    statusLabel.setText(status + ")", juce::NotificationType::dontSendNotification);
+}
+
+void Interface::updateLibraryPresets(bool isScanCancelled)
+{
+    // findSimilar only searches in the host once every preset has been analyzed with the encoder,
+    // the index of a cancelled scan may be missing some of them
+    juce::StringArray presetPaths, outdatedPresetPaths;
+    const auto &index = libraryScanner.getIndex();
+    for (int i = 0; !isScanCancelled && i < index.getNumPresets(); ++i)
+    {
+        if (!index.isParsable(i))
             continue;
+        presetPaths.add(index.getPresetPath(i));
+        if (!index.isAnalyzed(i))
+            outdatedPresetPaths.add(presetPaths[presetPaths.size() - 1]);
+    }
+    processorManager.setLibraryPresets(presetPaths, outdatedPresetPaths);
+}
+
+void Interface::showLibraryPresets()
+{
+    // the filter is built after every scan, so its positions are the ones in the index
+    const auto &index = libraryScanner.getIndex();
+    const auto &matches = descriptorFilter.getMatches();
+
+    presetList.clear();
+    presetList.reserve(matches.getCardinality());
+    matches.forEach([this, &index] (juce::uint32 position) {
+        const auto i = static_cast<int>(position);
+        presetList.addItem(index.getPluginPath(i), index.getPresetPath(i), index.getDescriptors(i));
+    });
+}
+
+void Interface::descriptorFilterChangedCallback()
+{
+    isShowingLibrary = true;
 
-        presetList.addItem(pluginPath, path, descriptors);
+    // the index is replaced at the end of a scan, so the presets are shown once it has finished
+    if (libraryScanner.isScanning())
+    {
+        isFilterPending = true;
+        return;
     }
+
+    showLibraryPresets();
+    statusLabel.setText(juce::String(descriptorFilter.getNumMatches()) + " presets match the filter",
+                        juce::NotificationType::dontSendNotification);
 }
 
 // =================================================
@@ -506,7 +808,64 @@ void Interface::openPluginEditorButtonClicked()
 
 void Interface::analyzeLibraryButtonClicked()
 {
-    processorManager.analyzeLibrary(presetList.getLibraryPresetPaths());
+    if (libraryScanner.isScanning())
+    {
+        statusLabel.setText("The library is being scanned", juce::NotificationType::dontSendNotification);
+        return;
+    }
+
+    const auto &index = libraryScanner.getIndex();
+    if (!index.isOpen())
+    {
+        libraryAnalysisStartTime = juce::Time::getCurrentTime();
+        processorManager.analyzeLibrary(presetList.getLibraryPresetPaths());
+        return;
+    }
+
+    // The analyzed flags in the index are only trusted for the presets that the back-end still has,
+    // its cache might have been deleted, or not saved if it was stopped during an analysis.
+    isWaitingForStoredPresets = true;
+    statusLabel.setText("Asking the back-end which presets it has", juce::NotificationType::dontSendNotification);
+    oscManager.requestStoredPresets(index.getLibraryDirectory());
+}
+
+void Interface::storedPresetsReadyCallback()
+{
+    if (!isWaitingForStoredPresets)
+        return;
+    isWaitingForStoredPresets = false;
+
+    // the index is replaced at the end of a scan
+    if (libraryScanner.isScanning())
+    {
+        statusLabel.setText("The library is being scanned", juce::NotificationType::dontSendNotification);
+        return;
+    }
+
+    const auto &storedPaths = oscManager.getStoredPresetPaths();
+    const std::unordered_set<juce::String> storedPresetPaths(storedPaths.begin(), storedPaths.end());
+
+    // the presets that have been added or modified since they were last analyzed, and the ones the back-end has lost
+    const auto &index = libraryScanner.getIndex();
+    juce::Array<juce::String> presetPaths;
+    for (int i = 0; i < index.getNumPresets(); ++i)
+    {
+        if (!index.isParsable(i))
+            continue;
+        auto presetPath = index.getPresetPath(i);
+        if (!index.isAnalyzed(i) || storedPresetPaths.count(presetPath) == 0)
+            presetPaths.add(std::move(presetPath));
+    }
+
+    if (presetPaths.isEmpty())
+    {
+        statusLabel.setText("All the presets in the library have been analyzed", juce::NotificationType::dontSendNotification);
+        return;
+    }
+    statusLabel.setText("Analyzing " + juce::String(presetPaths.size()) + " presets",
+                        juce::NotificationType::dontSendNotification);
+    libraryAnalysisStartTime = juce::Time::getCurrentTime();
+    processorManager.analyzeLibrary(presetPaths);
 }
 
 void Interface::searchButtonClicked()
@@ -519,6 +878,21 @@ void Interface::findSimilarButtonClicked()
     processorManager.findSimilar();
 }
 
+void Interface::filterButtonClicked()
+{
+    const bool isShowingFilter = filterButton.getToggleState();
+    descriptorFilterPanel.setVisible(isShowingFilter);
+    resized();
+
+    // a hidden filter would keep presets out of the list without showing why
+    if (!isShowingFilter && descriptorFilter.isActive())
+    {
+        descriptorFilter.resetModes();
+        descriptorFilterPanel.refresh();
+        descriptorFilterChangedCallback();
+    }
+}
+
 void Interface::autoTagButtonClicked()
 {
     processorManager.autoTag();
@@ -539,32 +913,28 @@ void Interface::setLibraryButtonClicked()
     if (fileChooser.browseForDirectory())
     {
         libraryPath = fileChooser.getResult().getFullPathName();
-        statusLabel.setText("Library Path: " + libraryPath, juce::NotificationType::dontSendNotification);
+        processorManager.setLibraryDirectory(juce::File(libraryPath));
+        statusLabel.setText("Scanning " + libraryPath, juce::NotificationType::dontSendNotification);
 
-        // scan all the presets in the directory and add them to presetList
+        // the presets are added to presetList in batches while the library is scanned in the background
         presetList.clear();
-        juce::File libraryDir(libraryPath);
-        auto presetFiles = libraryDir.findChildFiles(juce::File::TypesOfFileToFind::findFiles,
-                                                     true,
-                                                     "*.xml");
-        for (auto &file : presetFiles)
-        {
-            auto presetPath = file.getFullPathName();
-            auto xmlPreset = juce::XmlDocument::parse(file);
-            if (!xmlPreset)
-                return;
-
-            juce::String pluginPath;
-            std::unordered_set<juce::String> descriptors;
-            juce::Array<std::pair<int, float>> parameters;
-            auto isSuccessful = PresetManager::parse(*xmlPreset, parameters, pluginPath, descriptors);
-            if (!isSuccessful)
-                continue;
-            presetList.addItem(pluginPath, presetPath, descriptors);
-        }
+        isShowingLibrary = true;
+        // the bitmaps belong to the old library, they are built again when the scan finishes
+        descriptorFilter.clear();
+        descriptorFilterPanel.refresh();
+        libraryScanProgress = -1.0;
+        libraryScanProgressBar.setVisible(true);
+        cancelLibraryScanButton.setVisible(true);
+        setLibraryButton.setEnabled(false);
+        libraryScanner.start(juce::File(libraryPath));
     }
 }
 
+void Interface::cancelLibraryScanButtonClicked()
+{
+    libraryScanner.cancel();
+}
+
 void Interface::savePresetButtonClicked()
 {
     juce::FileChooser fileChooser("Select the path", {});
@@ -578,7 +948,7 @@ void Interface::savePresetButtonClicked()
 void Interface::confirmTagButtonClicked()
 {
     auto selectedPresetPath = presetList.getPresetPath();
-    auto descriptors= PresetManager::stringToDescriptors(tagEditInputBox.getText());
+    auto descriptors = DescriptorSet::fromString(tagEditInputBox.getText());
     processorManager.changeDescriptors(selectedPresetPath, descriptors);
 
     // refresh the preset list
@@ -593,6 +963,7 @@ void Interface::presetListUndoButtonClicked()
 
     auto presetPaths = undoStack.undo();
     setPresetList(presetPaths);
+    isShowingLibrary = false;
     presetListUndoButton.setEnabled(undoStack.isUndoAvailable());
     presetListRedoButton.setEnabled(undoStack.isRedoAvailable());
 }
@@ -604,6 +975,7 @@ void Interface::presetListRedoButtonClicked()
 
     auto presetPaths = undoStack.redo();
     setPresetList(presetPaths);
+    isShowingLibrary = false;
     presetListUndoButton.setEnabled(undoStack.isUndoAvailable());
     presetListRedoButton.setEnabled(undoStack.isRedoAvailable());
 }
\ No newline at end of file
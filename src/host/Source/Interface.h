@@ -10,12 +10,20 @@
 
 #pragma once
 #include <JuceHeader.h>
+#include <unordered_map>
+#include <unordered_set>
 #include "ProcessorManager.h"
 #include "PluginWindow.h"
 #include "Utils.h"
+#include "LibraryScanner.h"
+#include "DescriptorFilter.h"
 
+// The rows are kept as columns. Only the rows that are painted get their display strings, and
+// the descriptor strings are shared by all the rows with the same descriptors, so a library of
+// any size costs the same to scroll. Adding rows updates the table once per message loop.
 class PresetTableModel : public juce::Component,
-                         public juce::TableListBoxModel
+                         public juce::TableListBoxModel,
+                         private juce::AsyncUpdater
 {
 public:
     explicit PresetTableModel();
@@ -25,25 +33,62 @@ public:
     void cellClicked (int rowNumber, int columnId, const juce::MouseEvent &) override;
     void cellDoubleClicked (int rowNumber, int columnId, const juce::MouseEvent &) override;
     void resized() override;
-    void addItem(const juce::String &pluginPath, const juce::String &presetPath, const std::unordered_set<juce::String> &descriptors);
+    void addItem(const juce::String &pluginPath, const juce::String &presetPath, const DescriptorSet &descriptors);
+    void addItems(const std::vector<LibraryIndex::Preset> &presets);
+    // makes room for more rows, so adding them doesn't reallocate the columns
+    void reserve(int numRows);
     void clear();
     const juce::String& getPluginPath() const;
     const juce::String& getPresetPath() const;
     const juce::Array<juce::String>& getLibraryPresetPaths() const;
     juce::String getDescriptorString() const;
-    const std::unordered_set<juce::String>& getDescriptors() const;
+    const DescriptorSet& getDescriptors() const;
 
     juce::ChangeBroadcaster cellClickedBroadcaster;
     juce::ChangeBroadcaster cellDoubleClickedBroadcaster;
 private:
+    void handleAsyncUpdate() override;
+    const juce::String& getPresetName(int rowNumber);
+    const juce::String& getDescriptorDisplayString(const DescriptorSet &descriptorSet);
     static juce::String getPresetNameFromPath(const juce::String& path);
     juce::TableListBox presetTable;
     juce::Array<juce::String> pluginPaths;
     juce::Array<juce::String> presetPaths;
-    juce::Array<std::unordered_set<juce::String>> descriptors;
+    juce::Array<DescriptorSet> descriptors;
+    // filled when a row is painted for the first time
+    std::vector<juce::String> presetNames;
+    // there are far fewer distinct descriptor sets than presets
+    std::unordered_map<juce::uint64, juce::String> descriptorStrings;
+    // the sets with words that have no id can't be keyed by their bits
+    std::unordered_set<juce::String> extraDescriptorStrings;
     juce::String currentPluginPath;
     juce::String currentPresetPath;
-    std::unordered_set<juce::String> currentDescriptors;
+    DescriptorSet currentDescriptors;
+};
+
+// The descriptors of the library as buttons, clicking one cycles it through the modes of the
+// DescriptorFilter. Every button shows how many of the matching presets have its descriptor.
+class DescriptorFilterPanel : public juce::Component
+{
+public:
+    explicit DescriptorFilterPanel(DescriptorFilter &filter);
+    // creates a button for every descriptor of the library, should be called after the filter has been built
+    void refresh();
+    // the height the buttons need at a width
+    int getHeightForWidth(int width) const;
+    void resized() override;
+
+    // broadcasts when the user has changed the filter, other classes should only call addListener
+    juce::ChangeBroadcaster filterChangedBroadcaster;
+private:
+    void descriptorButtonClicked(int descriptorId);
+    void clearButtonClicked();
+    void updateButtons();
+
+    DescriptorFilter &filter;
+    juce::OwnedArray<juce::TextButton> descriptorButtons;
+    juce::Array<int> descriptorIds;
+    juce::TextButton clearButton {"Clear"};
 };
 
 class Interface : public juce::Component,
@@ -75,6 +120,12 @@ private:
     void loadPresetCallback(const juce::String &path);
     void openPluginEditorCallback();
     void setPresetList(const juce::StringArray& presetPaths);
+    void libraryScanProgressCallback();
+    void storedPresetsReadyCallback();
+    // tells the PluginManager which presets the scan has found, see PluginManager::setLibraryPresets
+    void updateLibraryPresets(bool isScanCancelled);
+    void showLibraryPresets();
+    void descriptorFilterChangedCallback();
 
     /// functionalities
     // load plugin
@@ -95,6 +146,11 @@ private:
     // set preset library path
     juce::TextButton setLibraryButton { "Set Library" };
     void setLibraryButtonClicked();
+    // the progress of scanning the library
+    double libraryScanProgress = 0.0;
+    juce::ProgressBar libraryScanProgressBar { libraryScanProgress };
+    juce::TextButton cancelLibraryScanButton { "Cancel Scan" };
+    void cancelLibraryScanButtonClicked();
     // input boxes
     juce::TextEditor tagInputBox {"tagInput"};
     juce::TextEditor tagEditInputBox{"tagEdit"};
@@ -104,6 +160,8 @@ private:
     // buttons on the right side
     juce::TextButton findSimilarButton {"Similar"};
     void findSimilarButtonClicked();
+    juce::TextButton filterButton {"Filter"};
+    void filterButtonClicked();
     juce::TextButton presetListUndoButton {"<"};
     void presetListUndoButtonClicked();
     juce::TextButton presetListRedoButton {">"};
@@ -121,6 +179,14 @@ private:
 
     // TODO: maybe put this into another class
     juce::String libraryPath; // the path to the preset library
+    LibraryScanner libraryScanner;
+    bool isShowingLibrary = false; // presetList shows the whole library rather than the result of a search
+    // filters the library by its descriptors, the panel is shown above presetList
+    DescriptorFilter descriptorFilter;
+    DescriptorFilterPanel descriptorFilterPanel { descriptorFilter };
+    bool isFilterPending = false; // the filter has changed during a scan, it's applied when the scan finishes
+    bool isWaitingForStoredPresets = false; // Analyze Lib has asked the back-end which presets it has
+    juce::Time libraryAnalysisStartTime;
 
     /// MIDI keyboard
     // keyboardState is an argument when initializing midiKeyboard
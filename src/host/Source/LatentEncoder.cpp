@@ -0,0 +1,355 @@
+/*
+  ==============================================================================
+
+    LatentEncoder.cpp
+    Created: 17 Oct 2026 7:45:49pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#include "LatentEncoder.h"
+#include <cmath>
+#include <cstring>
+
+// the layout of the file written by export_encoder.py, all the values are little-endian:
+//     "IDEN", version, input channels, input height, input width, number of layers
+//     every layer: type, then for a convolution: input channels, output channels, kernel size, stride,
+//                  padding, weights, bias, and for max pooling: kernel size, stride
+//     the size and the values of the reference input, the size and the values of the reference output
+static const char fileMagic[] = "IDEN";
+static const int fileVersion = 1;
+static const int maxNumLayers = 64;
+static const int maxLayerSize = 1 << 20;
+static const int maxNumChannels = 4096;
+static const int maxKernelSize = 64;
+// the outputs are a sum of a few hundred products, so they differ from PyTorch's only by rounding
+static const float absoluteTolerance = 1e-4f;
+static const float relativeTolerance = 1e-3f;
+
+// FNV-1a, it only has to tell the exported encoders apart
+static juce::uint64 hashBytes(juce::uint64 hash, const void* data, size_t numBytes)
+{
+    const auto* bytes = static_cast<const juce::uint8*>(data);
+    for (size_t i = 0; i < numBytes; ++i)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash;
+}
+
+bool LatentEncoder::load(const juce::File &file, juce::String &errorMessage)
+{
+    juce::FileInputStream stream(file);
+    if (!stream.openedOk())
+    {
+        errorMessage = "Cannot open " + file.getFullPathName();
+        return false;
+    }
+
+    char magic[4];
+    if (stream.read(magic, 4) != 4 || std::memcmp(magic, fileMagic, 4) != 0)
+    {
+        errorMessage = file.getFileName() + " is not an exported encoder";
+        return false;
+    }
+    if (stream.readInt() != fileVersion)
+    {
+        errorMessage = file.getFileName() + " has been exported by another version of export_encoder.py";
+        return false;
+    }
+
+    auto newModel = std::make_shared<Model>();
+    newModel->inputShape.channels = stream.readInt();
+    newModel->inputShape.height = stream.readInt();
+    newModel->inputShape.width = stream.readInt();
+    const int numLayers = stream.readInt();
+
+    auto shape = newModel->inputShape;
+    if (shape.channels <= 0 || shape.height <= 0 || shape.width <= 0 || shape.getSize() > maxLayerSize
+        || numLayers <= 0 || numLayers > maxNumLayers)
+    {
+        errorMessage = file.getFileName() + " is corrupted";
+        return false;
+    }
+
+    newModel->maxLayerSize = shape.getSize();
+    newModel->layers.resize((size_t) numLayers);
+    for (auto &layer : newModel->layers)
+    {
+        layer.inputShape = shape;
+        if (!readLayer(stream, layer, errorMessage))
+        {
+            errorMessage = file.getFileName() + ": " + errorMessage;
+            return false;
+        }
+        shape = layer.outputShape;
+
+        newModel->maxLayerSize = juce::jmax(newModel->maxLayerSize, shape.getSize());
+        if (layer.type == LayerType::conv2d)
+            newModel->maxColumnsSize = juce::jmax(newModel->maxColumnsSize,
+                                                  static_cast<int>(layer.weights.size() / layer.bias.size())
+                                                  * shape.height * shape.width);
+    }
+
+    // the reference is what PyTorch gives, a mismatch means the file doesn't belong to this code
+    std::vector<float> referenceInput, referenceOutput;
+    if (stream.readInt() != newModel->inputShape.getSize()
+        || !readFloats(stream, newModel->inputShape.getSize(), referenceInput)
+        || stream.readInt() != shape.getSize()
+        || !readFloats(stream, shape.getSize(), referenceOutput))
+    {
+        errorMessage = file.getFileName() + " has no valid reference output";
+        return false;
+    }
+
+    LatentEncoder encoder;
+    encoder.model = newModel;
+    std::vector<float> output;
+    encoder.encode(referenceInput.data(), static_cast<int>(referenceInput.size()), output);
+    for (size_t i = 0; i < output.size(); ++i)
+    {
+        if (!(std::abs(output[i] - referenceOutput[i])
+              <= absoluteTolerance + relativeTolerance * std::abs(referenceOutput[i])))
+        {
+            errorMessage = file.getFileName() + " doesn't match the reference output (output "
+                           + juce::String((int) i) + " is " + juce::String(output[i])
+                           + ", PyTorch gives " + juce::String(referenceOutput[i]) + ")";
+            return false;
+        }
+    }
+
+    // the same weights give the same latent features, wherever the file comes from
+    juce::uint64 id = 14695981039346656037ull;
+    for (const auto &layer : newModel->layers)
+    {
+        const int description[] = { (int) layer.type, layer.kernelSize, layer.stride, layer.padding,
+                                    layer.outputShape.channels };
+        id = hashBytes(id, description, sizeof(description));
+        id = hashBytes(id, layer.weights.data(), layer.weights.size() * sizeof(float));
+        id = hashBytes(id, layer.bias.data(), layer.bias.size() * sizeof(float));
+    }
+    newModel->id = id != 0 ? id : 1;
+
+    model = newModel;
+    return true;
+}
+
+bool LatentEncoder::isLoaded() const
+{
+    return model != nullptr;
+}
+
+juce::uint64 LatentEncoder::getId() const
+{
+    return model ? model->id : 0;
+}
+
+int LatentEncoder::getNumInputs() const
+{
+    return model ? model->inputShape.getSize() : 0;
+}
+
+int LatentEncoder::getNumOutputs() const
+{
+    return model ? model->layers.back().outputShape.getSize() : 0;
+}
+
+bool LatentEncoder::encode(const float* input, int numInputs, std::vector<float> &latent)
+{
+    if (!model || input == nullptr || numInputs != model->inputShape.getSize())
+        return false;
+
+    // only allocates the first time
+    bufferA.resize((size_t) model->maxLayerSize);
+    bufferB.resize((size_t) model->maxLayerSize);
+    columns.resize((size_t) model->maxColumnsSize);
+
+    const float* layerInput = input;
+    float* layerOutput = bufferA.data();
+    for (const auto &layer : model->layers)
+    {
+        switch (layer.type)
+        {
+            case LayerType::conv2d:
+                runConv2d(layer, layerInput, layerOutput);
+                break;
+            case LayerType::relu:
+                juce::FloatVectorOperations::max(layerOutput, layerInput, 0.f, layer.outputShape.getSize());
+                break;
+            case LayerType::maxPool2d:
+                runMaxPool2d(layer, layerInput, layerOutput);
+                break;
+        }
+
+        layerInput = layerOutput;
+        layerOutput = layerOutput == bufferA.data() ? bufferB.data() : bufferA.data();
+    }
+
+    // the latent is flattened in the same order as torch.reshape does
+    latent.assign(layerInput, layerInput + getNumOutputs());
+    return true;
+}
+
+juce::File LatentEncoder::getDefaultFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+            .getChildFile("Ideator")
+            .getChildFile("Encoder.bin");
+}
+
+bool LatentEncoder::readLayer(juce::InputStream &stream, Layer &layer, juce::String &errorMessage)
+{
+    const auto &inputShape = layer.inputShape;
+    auto &outputShape = layer.outputShape;
+
+    const int type = stream.readInt();
+    if (type == static_cast<int>(LayerType::conv2d))
+    {
+        layer.type = LayerType::conv2d;
+        const int inputChannels = stream.readInt();
+        outputShape.channels = stream.readInt();
+        layer.kernelSize = stream.readInt();
+        layer.stride = stream.readInt();
+        layer.padding = stream.readInt();
+        if (inputChannels != inputShape.channels || outputShape.channels <= 0 || outputShape.channels > maxNumChannels
+            || layer.kernelSize <= 0 || layer.kernelSize > maxKernelSize || layer.stride <= 0
+            || layer.padding < 0 || layer.padding >= layer.kernelSize)
+        {
+            errorMessage = "invalid convolution";
+            return false;
+        }
+
+        const auto numWeights = (juce::int64) outputShape.channels * inputChannels * layer.kernelSize * layer.kernelSize;
+        if (numWeights > maxLayerSize
+            || !readFloats(stream, static_cast<int>(numWeights), layer.weights)
+            || !readFloats(stream, outputShape.channels, layer.bias))
+        {
+            errorMessage = "the weights are incomplete";
+            return false;
+        }
+
+        outputShape.height = (inputShape.height + 2 * layer.padding - layer.kernelSize) / layer.stride + 1;
+        outputShape.width = (inputShape.width + 2 * layer.padding - layer.kernelSize) / layer.stride + 1;
+    }
+    else if (type == static_cast<int>(LayerType::relu))
+    {
+        layer.type = LayerType::relu;
+        outputShape = inputShape;
+    }
+    else if (type == static_cast<int>(LayerType::maxPool2d))
+    {
+        layer.type = LayerType::maxPool2d;
+        layer.kernelSize = stream.readInt();
+        layer.stride = stream.readInt();
+        if (layer.kernelSize <= 0 || layer.kernelSize > maxKernelSize || layer.stride <= 0)
+        {
+            errorMessage = "invalid max pooling";
+            return false;
+        }
+
+        outputShape.channels = inputShape.channels;
+        outputShape.height = (inputShape.height - layer.kernelSize) / layer.stride + 1;
+        outputShape.width = (inputShape.width - layer.kernelSize) / layer.stride + 1;
+    }
+    else
+    {
+        errorMessage = "unknown layer type " + juce::String(type);
+        return false;
+    }
+
+    if (outputShape.height <= 0 || outputShape.width <= 0 || outputShape.getSize() > maxLayerSize)
+    {
+        errorMessage = "the input is too small for the layers";
+        return false;
+    }
+    return true;
+}
+
+bool LatentEncoder::readFloats(juce::InputStream &stream, int numValues, std::vector<float> &values)
+{
+    if (numValues < 0 || stream.getNumBytesRemaining() < (juce::int64) numValues * 4)
+        return false;
+
+    values.resize((size_t) numValues);
+    for (auto &value : values)
+        value = stream.readFloat();
+    return true;
+}
+
+void LatentEncoder::runConv2d(const Layer &layer, const float* input, float* output)
+{
+    // The patches are copied into rows first (im2col), one row per kernel weight and one column per
+    // output position, so every output channel becomes a sum of whole rows scaled by its weights,
+    // which is what the vectorised FloatVectorOperations are fast at.
+    const auto &inputShape = layer.inputShape;
+    const auto &outputShape = layer.outputShape;
+    const int kernelSize = layer.kernelSize;
+    const int numPositions = outputShape.height * outputShape.width;
+    const int numRows = inputShape.channels * kernelSize * kernelSize;
+
+    float* row = columns.data();
+    for (int channel = 0; channel < inputShape.channels; ++channel)
+    {
+        const float* inputChannel = input + channel * inputShape.height * inputShape.width;
+        for (int ky = 0; ky < kernelSize; ++ky)
+        {
+            for (int kx = 0; kx < kernelSize; ++kx)
+            {
+                for (int oy = 0; oy < outputShape.height; ++oy)
+                {
+                    const int iy = oy * layer.stride - layer.padding + ky;
+                    float* rowOutput = row + oy * outputShape.width;
+                    // the padding is zeros
+                    if (iy < 0 || iy >= inputShape.height)
+                    {
+                        juce::FloatVectorOperations::clear(rowOutput, outputShape.width);
+                        continue;
+                    }
+
+                    const float* inputRow = inputChannel + iy * inputShape.width;
+                    for (int ox = 0; ox < outputShape.width; ++ox)
+                    {
+                        const int ix = ox * layer.stride - layer.padding + kx;
+                        rowOutput[ox] = (ix >= 0 && ix < inputShape.width) ? inputRow[ix] : 0.f;
+                    }
+                }
+                row += numPositions;
+            }
+        }
+    }
+
+    for (int outputChannel = 0; outputChannel < outputShape.channels; ++outputChannel)
+    {
+        float* outputChannelData = output + outputChannel * numPositions;
+        const float* weights = layer.weights.data() + outputChannel * numRows;
+
+        juce::FloatVectorOperations::fill(outputChannelData, layer.bias[(size_t) outputChannel], numPositions);
+        for (int r = 0; r < numRows; ++r)
+            juce::FloatVectorOperations::addWithMultiply(outputChannelData,
+                                                         columns.data() + r * numPositions,
+                                                         weights[r],
+                                                         numPositions);
+    }
+}
+
+void LatentEncoder::runMaxPool2d(const Layer &layer, const float* input, float* output)
+{
+    const auto &inputShape = layer.inputShape;
+    const auto &outputShape = layer.outputShape;
+
+    for (int channel = 0; channel < outputShape.channels; ++channel)
+    {
+        const float* inputChannel = input + channel * inputShape.height * inputShape.width;
+        for (int oy = 0; oy < outputShape.height; ++oy)
+        {
+            for (int ox = 0; ox < outputShape.width; ++ox)
+            {
+                const float* window = inputChannel + (oy * layer.stride) * inputShape.width + ox * layer.stride;
+                float value = window[0];
+                for (int ky = 0; ky < layer.kernelSize; ++ky)
+                    for (int kx = 0; kx < layer.kernelSize; ++kx)
+                        value = juce::jmax(value, window[ky * inputShape.width + kx]);
+                *output++ = value;
+            }
+        }
+    }
+}
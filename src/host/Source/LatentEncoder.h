@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    LatentEncoder.h
+    Created: 17 Oct 2026 7:45:49pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+#include <memory>
+
+// Runs the encoder of the auto-encoder (DivaAutoEncoder.encoder in model.py) in the host, so a
+// preset can be turned into its latent features without the Python program. The weights are
+// exported from a PyTorch checkpoint by export_encoder.py, together with a reference input and
+// the output PyTorch gives for it, which is checked every time the file is loaded.
+// Copies share the weights, but every thread needs its own copy.
+class LatentEncoder
+{
+public:
+    LatentEncoder() = default;
+
+    /*!
+     * Loads an encoder exported by export_encoder.py.
+     * @param file the exported file
+     * @param errorMessage receives the reason if the file cannot be loaded
+     * @return false if the file cannot be read or its output doesn't match the reference
+     */
+    bool load(const juce::File &file, juce::String &errorMessage);
+
+    bool isLoaded() const;
+
+    // a fingerprint of the weights, the latent features of two encoders can only be compared
+    // if they have the same id, 0 if no encoder has been loaded
+    juce::uint64 getId() const;
+
+    // the input is the output of MelSpectrogram
+    int getNumInputs() const;
+    int getNumOutputs() const;
+
+    /*!
+     * Computes the latent features.
+     * @param input the log-mel spectrogram
+     * @param numInputs the size of the input, has to be getNumInputs()
+     * @param latent receives getNumOutputs() values
+     * @return false if no encoder has been loaded or the input size is wrong
+     */
+    bool encode(const float* input, int numInputs, std::vector<float> &latent);
+
+    // where export_encoder.py puts the file by default
+    static juce::File getDefaultFile();
+
+private:
+    enum class LayerType
+    {
+        conv2d = 1,
+        relu = 2,
+        maxPool2d = 3
+    };
+
+    struct Shape
+    {
+        int channels = 0;
+        int height = 0;
+        int width = 0;
+
+        int getSize() const { return channels * height * width; }
+    };
+
+    struct Layer
+    {
+        LayerType type = LayerType::relu;
+        Shape inputShape;
+        Shape outputShape;
+        int kernelSize = 0;
+        int stride = 1;
+        int padding = 0;
+        // the weights of a convolution are ordered as in PyTorch (output channel, input channel, row, column)
+        std::vector<float> weights;
+        std::vector<float> bias;
+    };
+
+    struct Model
+    {
+        Shape inputShape;
+        std::vector<Layer> layers;
+        int maxLayerSize = 0;
+        int maxColumnsSize = 0;
+        juce::uint64 id = 0;
+    };
+
+    static bool readLayer(juce::InputStream &stream, Layer &layer, juce::String &errorMessage);
+    static bool readFloats(juce::InputStream &stream, int numValues, std::vector<float> &values);
+
+    void runConv2d(const Layer &layer, const float* input, float* output);
+    static void runMaxPool2d(const Layer &layer, const float* input, float* output);
+
+    std::shared_ptr<const Model> model;
+    // the input and output of the layers take turns in these two
+    std::vector<float> bufferA;
+    std::vector<float> bufferB;
+    // the patches of the input under the kernel, one row per kernel weight
+    std::vector<float> columns;
+};
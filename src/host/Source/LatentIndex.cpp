@@ -0,0 +1,561 @@
+/*
+  ==============================================================================
+
+    LatentIndex.cpp
+    Created: 17 Oct 2026 8:20:03pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#include "LatentIndex.h"
+#include "Config.h"
+#include "LibraryIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <queue>
+
+// The file is a header followed by the arrays of the graph, the removed presets are kept.
+// The values are in the byte order of the machine, like the ones of the LibraryIndex.
+struct LatentIndexHeader
+{
+    char magic[4];
+    juce::uint32 version;
+    juce::uint32 dimension;
+    juce::uint32 maxNumNeighbours;
+    juce::uint32 numNodes;
+    juce::int32 entryPoint;
+    juce::int32 topLevel;
+    juce::uint32 numUpperLinks;
+    juce::uint64 encoderId;
+    // followed by
+    // float latents[numNodes * dimension]
+    // uint8 isRemoved[numNodes]
+    // int32 baseLinks[numNodes * (2 * maxNumNeighbours + 1)]
+    // int32 levels[numNodes]
+    // int32 upperLinks[numUpperLinks]
+    // zero-terminated UTF-8 preset paths
+};
+
+static const char latentIndexMagic[] = "IDLX";
+// version 2 has added the encoder id
+static const juce::uint32 latentIndexVersion = 2;
+// the levels are drawn at random, this only guards against a corrupt file
+static const int maxLevel = 32;
+// a corrupt header must not make the sizes of the arrays overflow
+static const juce::uint32 maxNumNeighboursInFile = 1024;
+static const juce::uint32 maxDimension = 1 << 16;
+
+LatentIndex::LatentIndex():
+        maxNumNeighbours(LATENT_INDEX_NUM_NEIGHBOURS),
+        beamWidthForInsertion(LATENT_INDEX_INSERTION_BEAM_WIDTH),
+        beamWidthForSearch(LATENT_INDEX_SEARCH_BEAM_WIDTH),
+        levelMultiplier(1.0 / std::log((double) LATENT_INDEX_NUM_NEIGHBOURS)),
+        random(0)
+{
+}
+
+// ========================================
+// Changes
+// ========================================
+
+bool LatentIndex::add(const juce::String &presetPath, const float* latent, int size)
+{
+    if (latent == nullptr || size <= 0)
+        return false;
+
+    if (dimension != size)
+    {
+        clear();
+        dimension = size;
+    }
+
+    // the same preset is often analyzed again without having been changed
+    auto it = nodeIds.find(presetPath);
+    if (it != nodeIds.end())
+    {
+        if (std::equal(latent, latent + size, getLatent(it->second)))
+            return true;
+        remove(presetPath);
+    }
+
+    const int node = getNumNodes();
+    latents.insert(latents.end(), latent, latent + size);
+    presetPaths.push_back(presetPath);
+    isRemoved.push_back(0);
+    baseLinks.resize(baseLinks.size() + (size_t) getMaxNumLinks(0) + 1, 0);
+    upperLinks.emplace_back();
+    nodeIds[presetPath] = node;
+
+    insert(node);
+    isChanged = true;
+    return true;
+}
+
+bool LatentIndex::remove(const juce::String &presetPath)
+{
+    auto it = nodeIds.find(presetPath);
+    if (it == nodeIds.end())
+        return false;
+
+    // the node stays in the graph, the searches still go through it
+    isRemoved[(size_t) it->second] = 1;
+    ++numRemoved;
+    nodeIds.erase(it);
+    isChanged = true;
+    return true;
+}
+
+bool LatentIndex::contains(const juce::String &presetPath) const
+{
+    return nodeIds.find(presetPath) != nodeIds.end();
+}
+
+void LatentIndex::clear()
+{
+    if (getNumNodes() > 0)
+        isChanged = true;
+
+    dimension = 0;
+    latents.clear();
+    presetPaths.clear();
+    isRemoved.clear();
+    baseLinks.clear();
+    upperLinks.clear();
+    nodeIds.clear();
+    numRemoved = 0;
+    entryPoint = -1;
+    topLevel = -1;
+    visitMarks.clear();
+    visitMark = 0;
+}
+
+void LatentIndex::insert(int node)
+{
+    const int level = drawLevel();
+    upperLinks[(size_t) node].assign((size_t) (level * (maxNumNeighbours + 1)), 0);
+
+    if (entryPoint < 0)
+    {
+        entryPoint = node;
+        topLevel = level;
+        return;
+    }
+
+    // go down to the level of the node, then connect it on every level from there
+    const auto* latent = getLatent(node);
+    auto entryPoints = findEntryPoints(latent, level);
+    for (int l = juce::jmin(level, topLevel); l >= 0; --l)
+    {
+        auto candidates = searchLevel(latent, entryPoints, beamWidthForInsertion, l);
+        const auto neighbours = selectNeighbours(candidates, maxNumNeighbours);
+
+        auto* links = getLinks(node, l);
+        links[0] = static_cast<int>(neighbours.size());
+        for (size_t i = 0; i < neighbours.size(); ++i)
+            links[i + 1] = neighbours[i].second;
+
+        for (const auto &neighbour : neighbours)
+            connect(neighbour.second, node, neighbour.first, l);
+
+        entryPoints = std::move(candidates);
+    }
+
+    if (level > topLevel)
+    {
+        entryPoint = node;
+        topLevel = level;
+    }
+}
+
+void LatentIndex::connect(int node, int other, float distance, int level)
+{
+    auto* links = getLinks(node, level);
+    const int maxNumLinks = getMaxNumLinks(level);
+    if (links[0] < maxNumLinks)
+    {
+        links[++links[0]] = other;
+        return;
+    }
+
+    // keep the links that reach the most of the neighbourhood
+    std::vector<Candidate> candidates;
+    candidates.reserve((size_t) maxNumLinks + 1);
+    candidates.emplace_back(distance, other);
+    for (int i = 1; i <= links[0]; ++i)
+        candidates.emplace_back(getDistance(getLatent(node), getLatent(links[i])), links[i]);
+    std::sort(candidates.begin(), candidates.end());
+
+    const auto neighbours = selectNeighbours(candidates, maxNumLinks);
+    links[0] = static_cast<int>(neighbours.size());
+    for (size_t i = 0; i < neighbours.size(); ++i)
+        links[i + 1] = neighbours[i].second;
+}
+
+std::vector<LatentIndex::Candidate> LatentIndex::selectNeighbours(const std::vector<Candidate> &candidates,
+                                                                  int maxNumSelected) const
+{
+    // A candidate is skipped if it's closer to a selected one than to the node, it can be
+    // reached through that one. So the links point in different directions instead of
+    // all going into the same cluster.
+    std::vector<Candidate> selected;
+    selected.reserve((size_t) maxNumSelected);
+    for (const auto &candidate : candidates)
+    {
+        if ((int) selected.size() >= maxNumSelected)
+            break;
+
+        const auto* latent = getLatent(candidate.second);
+        const bool isCovered = std::any_of(selected.begin(), selected.end(), [&] (const Candidate &s) {
+            return getDistance(latent, getLatent(s.second)) < candidate.first;
+        });
+        if (!isCovered)
+            selected.push_back(candidate);
+    }
+    return selected;
+}
+
+void LatentIndex::compact()
+{
+    std::vector<float> oldLatents;
+    std::vector<juce::String> oldPresetPaths;
+    oldLatents.swap(latents);
+    oldPresetPaths.swap(presetPaths);
+    const auto oldIsRemoved = std::move(isRemoved);
+    const int size = dimension;
+
+    clear();
+    for (size_t node = 0; node < oldPresetPaths.size(); ++node)
+        if (oldIsRemoved[node] == 0)
+            add(oldPresetPaths[node], oldLatents.data() + node * (size_t) size, size);
+}
+
+// ========================================
+// Search
+// ========================================
+
+std::vector<LatentIndex::Match> LatentIndex::search(const float* query, int size, int numMatches)
+{
+    std::vector<Match> matches;
+    if (query == nullptr || size != dimension || entryPoint < 0 || numMatches <= 0)
+        return matches;
+
+    // the removed presets are found as well, so the beam is widened by their share
+    const int numPresets = juce::jmax(1, getNumPresets());
+    const int beamWidth = static_cast<int>(juce::jmin((juce::int64) getNumNodes(),
+                                                      (juce::int64) juce::jmax(beamWidthForSearch, numMatches)
+                                                          * getNumNodes() / numPresets));
+
+    const auto candidates = searchLevel(query, findEntryPoints(query, 0), beamWidth, 0);
+    for (const auto &candidate : candidates)
+    {
+        if (isRemoved[(size_t) candidate.second] != 0)
+            continue;
+
+        matches.push_back({ presetPaths[(size_t) candidate.second], std::sqrt(candidate.first) });
+        if ((int) matches.size() == numMatches)
+            break;
+    }
+    return matches;
+}
+
+std::vector<LatentIndex::Candidate> LatentIndex::findEntryPoints(const float* query, int level)
+{
+    // a greedy walk on the levels above, they only have a few nodes
+    std::vector<Candidate> entryPoints { { getDistance(query, getLatent(entryPoint)), entryPoint } };
+    for (int l = topLevel; l > level; --l)
+        entryPoints = searchLevel(query, entryPoints, 1, l);
+    return entryPoints;
+}
+
+std::vector<LatentIndex::Candidate> LatentIndex::searchLevel(const float* query,
+                                                             const std::vector<Candidate> &entryPoints,
+                                                             int beamWidth, int level)
+{
+    if (visitMarks.size() < (size_t) getNumNodes())
+        visitMarks.resize((size_t) getNumNodes(), 0);
+    if (++visitMark == 0)
+    {
+        std::fill(visitMarks.begin(), visitMarks.end(), 0);
+        visitMark = 1;
+    }
+
+    // the closest candidate is expanded first, the results keep the farthest one on top
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> candidates;
+    std::priority_queue<Candidate> results;
+    for (const auto &entryPoint : entryPoints)
+    {
+        visitMarks[(size_t) entryPoint.second] = visitMark;
+        candidates.push(entryPoint);
+        results.push(entryPoint);
+        if ((int) results.size() > beamWidth)
+            results.pop();
+    }
+
+    while (!candidates.empty())
+    {
+        const auto candidate = candidates.top();
+        if ((int) results.size() >= beamWidth && candidate.first > results.top().first)
+            break;
+        candidates.pop();
+
+        const auto* links = getLinks(candidate.second, level);
+        for (int i = 1; i <= links[0]; ++i)
+        {
+            const int neighbour = links[i];
+            if (visitMarks[(size_t) neighbour] == visitMark)
+                continue;
+            visitMarks[(size_t) neighbour] = visitMark;
+
+            const float distance = getDistance(query, getLatent(neighbour));
+            if ((int) results.size() < beamWidth || distance < results.top().first)
+            {
+                candidates.emplace(distance, neighbour);
+                results.emplace(distance, neighbour);
+                if ((int) results.size() > beamWidth)
+                    results.pop();
+            }
+        }
+    }
+
+    std::vector<Candidate> sortedResults(results.size());
+    for (auto it = sortedResults.rbegin(); it != sortedResults.rend(); ++it)
+    {
+        *it = results.top();
+        results.pop();
+    }
+    return sortedResults;
+}
+
+// ========================================
+// Helpers
+// ========================================
+
+int* LatentIndex::getLinks(int node, int level)
+{
+    if (level == 0)
+        return baseLinks.data() + (size_t) node * (size_t) (getMaxNumLinks(0) + 1);
+    return upperLinks[(size_t) node].data() + (size_t) ((level - 1) * (maxNumNeighbours + 1));
+}
+
+float LatentIndex::getDistance(const float* a, const float* b) const
+{
+    // the squared distance, it's only compared
+    float distance = 0.f;
+    for (int i = 0; i < dimension; ++i)
+    {
+        const float difference = a[i] - b[i];
+        distance += difference * difference;
+    }
+    return distance;
+}
+
+int LatentIndex::drawLevel()
+{
+    // every level has about 1 / maxNumNeighbours of the nodes of the level below
+    const double uniform = 1.0 - random.nextDouble();
+    return juce::jmin(maxLevel, static_cast<int>(-std::log(uniform) * levelMultiplier));
+}
+
+int LatentIndex::getNumPresets() const
+{
+    return static_cast<int>(nodeIds.size());
+}
+
+bool LatentIndex::isEmpty() const
+{
+    return nodeIds.empty();
+}
+
+int LatentIndex::getDimension() const
+{
+    return dimension;
+}
+
+bool LatentIndex::hasChanged() const
+{
+    return isChanged;
+}
+
+void LatentIndex::setEncoderId(juce::uint64 newEncoderId)
+{
+    if (newEncoderId == encoderId)
+        return;
+
+    // the latent features of another encoder cannot be compared with the new ones
+    clear();
+    encoderId = newEncoderId;
+    isChanged = true;
+}
+
+juce::uint64 LatentIndex::getEncoderId() const
+{
+    return encoderId;
+}
+
+// ========================================
+// Files
+// ========================================
+
+bool LatentIndex::load(const juce::File &file)
+{
+    clear();
+    encoderId = 0;
+    isChanged = false;
+
+    juce::FileInputStream fileInput(file);
+    if (!fileInput.openedOk())
+        return false;
+    juce::BufferedInputStream input(fileInput, 1 << 16);
+
+    auto readArray = [&input] (void* data, size_t numBytes) {
+        return numBytes == 0 || input.read(data, (int) numBytes) == (int) numBytes;
+    };
+
+    LatentIndexHeader header;
+    if (!readArray(&header, sizeof(header))
+        || std::memcmp(header.magic, latentIndexMagic, 4) != 0
+        || header.version != latentIndexVersion
+        || header.dimension == 0 || header.dimension > maxDimension
+        || header.maxNumNeighbours == 0 || header.maxNumNeighbours > maxNumNeighboursInFile
+        || header.numNodes > (juce::uint32) std::numeric_limits<int>::max()
+        || (header.numNodes > 0 && !juce::isPositiveAndBelow(header.entryPoint, (juce::int32) header.numNodes))
+        || header.topLevel > maxLevel)
+        return false;
+
+    // With the bounds above, these fit in 64 bits whatever the header says. A corrupt header
+    // must not make the arrays larger than the file.
+    const auto numNodes = (size_t) header.numNodes;
+    const int numLinksPerNode = 2 * (int) header.maxNumNeighbours + 1;
+    const auto numBytesPerNode = (juce::uint64) header.dimension * sizeof(float) + 1
+                                 + ((juce::uint64) numLinksPerNode + 1) * sizeof(int);
+    const auto numArrayBytes = (juce::uint64) header.numNodes * numBytesPerNode
+                               + (juce::uint64) header.numUpperLinks * sizeof(int);
+    if (input.getNumBytesRemaining() < 0 || (juce::uint64) input.getNumBytesRemaining() < numArrayBytes)
+        return false;
+
+    maxNumNeighbours = static_cast<int>(header.maxNumNeighbours);
+    dimension = static_cast<int>(header.dimension);
+    entryPoint = numNodes > 0 ? header.entryPoint : -1;
+    topLevel = numNodes > 0 ? header.topLevel : -1;
+
+    std::vector<int> levels(numNodes);
+    std::vector<int> allUpperLinks(header.numUpperLinks);
+    latents.resize(numNodes * (size_t) dimension);
+    isRemoved.resize(numNodes);
+    baseLinks.resize(numNodes * (size_t) numLinksPerNode);
+    bool isValid = readArray(latents.data(), latents.size() * sizeof(float))
+                   && readArray(isRemoved.data(), isRemoved.size())
+                   && readArray(baseLinks.data(), baseLinks.size() * sizeof(int))
+                   && readArray(levels.data(), levels.size() * sizeof(int))
+                   && readArray(allUpperLinks.data(), allUpperLinks.size() * sizeof(int));
+
+    // every link must point to a node, or a search would read past the arrays
+    auto areLinksValid = [numNodes] (const int* links, int maxNumLinks) {
+        if (!juce::isPositiveAndNotGreaterThan(links[0], maxNumLinks))
+            return false;
+        return std::all_of(links + 1, links + 1 + links[0], [numNodes] (int node) {
+            return juce::isPositiveAndBelow(node, (int) numNodes);
+        });
+    };
+
+    size_t upperLinkOffset = 0;
+    upperLinks.resize(numNodes);
+    presetPaths.reserve(numNodes);
+    for (size_t node = 0; isValid && node < numNodes; ++node)
+    {
+        isValid = areLinksValid(&baseLinks[node * (size_t) numLinksPerNode], getMaxNumLinks(0))
+                  && juce::isPositiveAndNotGreaterThan(levels[node], topLevel);
+        if (!isValid)
+            break;
+
+        const auto numUpperLinks = (size_t) (levels[node] * (maxNumNeighbours + 1));
+        isValid = upperLinkOffset + numUpperLinks <= allUpperLinks.size();
+        if (!isValid)
+            break;
+        upperLinks[node].assign(allUpperLinks.begin() + (std::ptrdiff_t) upperLinkOffset,
+                                allUpperLinks.begin() + (std::ptrdiff_t) (upperLinkOffset + numUpperLinks));
+        upperLinkOffset += numUpperLinks;
+        for (int level = 1; isValid && level <= levels[node]; ++level)
+            isValid = areLinksValid(getLinks((int) node, level), maxNumNeighbours);
+
+        presetPaths.push_back(input.readString());
+        if (isRemoved[node] != 0)
+            ++numRemoved;
+        else
+            nodeIds[presetPaths.back()] = static_cast<int>(node);
+    }
+
+    if (!isValid || !input.isExhausted() || (entryPoint >= 0 && getLevel(entryPoint) != topLevel))
+    {
+        clear();
+        maxNumNeighbours = LATENT_INDEX_NUM_NEIGHBOURS;
+        isChanged = false;
+        return false;
+    }
+
+    encoderId = header.encoderId;
+    // the searches go through the removed presets as well, so they are dropped once they are the most
+    if (numRemoved > getNumPresets())
+        compact();
+    return true;
+}
+
+bool LatentIndex::save(const juce::File &file)
+{
+    LatentIndexHeader header;
+    std::memcpy(header.magic, latentIndexMagic, 4);
+    header.version = latentIndexVersion;
+    header.dimension = static_cast<juce::uint32>(dimension);
+    header.maxNumNeighbours = static_cast<juce::uint32>(maxNumNeighbours);
+    header.numNodes = static_cast<juce::uint32>(getNumNodes());
+    header.entryPoint = entryPoint;
+    header.topLevel = topLevel;
+    header.encoderId = encoderId;
+
+    std::vector<int> levels;
+    std::vector<int> allUpperLinks;
+    levels.reserve(presetPaths.size());
+    for (int node = 0; node < getNumNodes(); ++node)
+    {
+        levels.push_back(getLevel(node));
+        allUpperLinks.insert(allUpperLinks.end(), upperLinks[(size_t) node].begin(), upperLinks[(size_t) node].end());
+    }
+    header.numUpperLinks = static_cast<juce::uint32>(allUpperLinks.size());
+
+    if (!file.getParentDirectory().createDirectory().wasOk())
+        return false;
+
+    juce::TemporaryFile temporaryFile(file);
+    {
+        juce::FileOutputStream output(temporaryFile.getFile(), 1 << 16);
+        if (!output.openedOk())
+            return false;
+
+        output.write(&header, sizeof(header));
+        output.write(latents.data(), latents.size() * sizeof(float));
+        output.write(isRemoved.data(), isRemoved.size());
+        output.write(baseLinks.data(), baseLinks.size() * sizeof(int));
+        output.write(levels.data(), levels.size() * sizeof(int));
+        output.write(allUpperLinks.data(), allUpperLinks.size() * sizeof(int));
+        for (const auto &presetPath : presetPaths)
+            output.writeString(presetPath);
+
+        output.flush();
+        if (output.getStatus().failed())
+            return false;
+    }
+
+    if (!temporaryFile.overwriteTargetFileWithTemporary())
+        return false;
+
+    isChanged = false;
+    return true;
+}
+
+juce::File LatentIndex::getIndexFile(const juce::File &libraryDir)
+{
+    return LibraryIndex::getIndexFile(libraryDir).withFileExtension("latents");
+}
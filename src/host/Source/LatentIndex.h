@@ -0,0 +1,140 @@
+/*
+  ==============================================================================
+
+    LatentIndex.h
+    Created: 17 Oct 2026 8:20:03pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// An approximate nearest neighbour index over the latent features of the presets, so similar
+// presets are found in the host instead of comparing the patch to every preset in the back-end.
+// It's a hierarchical navigable small world graph (HNSW): every preset is linked to its closest
+// presets on the bottom level, and to fewer, farther ones on the levels above, which only a
+// random fraction of the presets reach. A search walks down from the top level, so it visits
+// a few hundred presets however large the library is.
+// A preset that is added again or removed is only marked as removed, the graph is built again
+// without them when they outnumber the others and the index is loaded. The index keeps the id of
+// the encoder its latent features come from. It's not thread-safe, use it on the message thread.
+class LatentIndex
+{
+public:
+    struct Match
+    {
+        juce::String presetPath;
+        float distance; // the Euclidean distance to the query
+    };
+
+    LatentIndex();
+
+    /*!
+     * Adds a preset or replaces its latent features. The latent features of another size come from
+     * another encoder, so the index is cleared first then.
+     * @param presetPath the full path to the preset
+     * @param latent the latent features
+     * @param size the number of values in latent
+     * @return false if there are no latent features
+     */
+    bool add(const juce::String &presetPath, const float* latent, int size);
+
+    // returns false if the preset is not in the index
+    bool remove(const juce::String &presetPath);
+    bool contains(const juce::String &presetPath) const;
+    void clear();
+
+    /*!
+     * Finds the presets whose latent features are the closest to the query.
+     * @param query the latent features of the patch
+     * @param size the number of values in query, nothing is found if it's not the size of the index
+     * @param numMatches the number of presets to find
+     * @return the presets in the order of their distances, closest first
+     */
+    std::vector<Match> search(const float* query, int size, int numMatches);
+
+    // the number of presets in the index, without the removed ones
+    int getNumPresets() const;
+    bool isEmpty() const;
+    // the number of values of the latent features, 0 if nothing has been added
+    int getDimension() const;
+    // true if the index has been changed since it was loaded or saved
+    bool hasChanged() const;
+
+    /*!
+     * Sets the encoder that the latent features come from, the index is cleared if it's another
+     * one than the one of the presets that are in it.
+     * @param newEncoderId see LatentEncoder::getId
+     */
+    void setEncoderId(juce::uint64 newEncoderId);
+    // 0 if it has not been set
+    juce::uint64 getEncoderId() const;
+
+    /*!
+     * Loads an index that has been saved, the current one is cleared. The graph is built again
+     * if most of its presets have been removed.
+     * @return false if the file doesn't exist or is not a valid index, the index is empty then
+     */
+    bool load(const juce::File &file);
+    bool save(const juce::File &file);
+
+    // the index of a library is stored next to its LibraryIndex
+    static juce::File getIndexFile(const juce::File &libraryDir);
+
+private:
+    // a distance and a node
+    using Candidate = std::pair<float, int>;
+
+    const float* getLatent(int node) const { return latents.data() + (size_t) node * (size_t) dimension; }
+    // the number of links followed by the linked nodes
+    int* getLinks(int node, int level);
+    int getMaxNumLinks(int level) const { return level == 0 ? 2 * maxNumNeighbours : maxNumNeighbours; }
+    int getLevel(int node) const { return static_cast<int>(upperLinks[(size_t) node].size()) / (maxNumNeighbours + 1); }
+    int getNumNodes() const { return static_cast<int>(presetPaths.size()); }
+    float getDistance(const float* a, const float* b) const;
+    int drawLevel();
+
+    void insert(int node);
+    // connects a node to another one, the farthest links are dropped if there are too many
+    void connect(int node, int other, float distance, int level);
+    // the candidates must be sorted, closest first
+    std::vector<Candidate> selectNeighbours(const std::vector<Candidate> &candidates, int maxNumSelected) const;
+    // a beam search on one level, the results are sorted, closest first
+    std::vector<Candidate> searchLevel(const float* query, const std::vector<Candidate> &entryPoints,
+                                       int beamWidth, int level);
+    std::vector<Candidate> findEntryPoints(const float* query, int level);
+    // builds the graph again without the removed presets
+    void compact();
+
+    int maxNumNeighbours;
+    int beamWidthForInsertion;
+    int beamWidthForSearch;
+    double levelMultiplier;
+    juce::Random random;
+
+    int dimension = 0;
+    juce::uint64 encoderId = 0;
+    std::vector<float> latents;
+    std::vector<juce::String> presetPaths;
+    std::vector<juce::uint8> isRemoved;
+    // the links of the bottom level, getMaxNumLinks(0) + 1 values per node
+    std::vector<int> baseLinks;
+    // the links of the levels above, maxNumNeighbours + 1 values per level, empty for most of the nodes
+    std::vector<std::vector<int>> upperLinks;
+    std::unordered_map<juce::String, int> nodeIds; // without the removed presets
+    int numRemoved = 0;
+    int entryPoint = -1;
+    int topLevel = -1;
+    bool isChanged = false;
+
+    // the nodes that a search has visited are marked with the number of the search
+    std::vector<juce::uint32> visitMarks;
+    juce::uint32 visitMark = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (LatentIndex)
+};
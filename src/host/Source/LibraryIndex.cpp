@@ -0,0 +1,446 @@
+/*
+  ==============================================================================
+
+    LibraryIndex.cpp
+    Created: 17 Oct 2026 7:51:17pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#include "LibraryIndex.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+// The file is a header followed by the columns, every column starts at a multiple of 8 bytes.
+// The values are in the byte order of the machine, which is little-endian everywhere Ideator runs.
+enum IndexSection
+{
+    presetPathSection,       // uint32 per preset, an offset into the strings, relative to the library
+    pluginPathSection,       // uint32 per preset, an offset into the strings
+    descriptorStringSection, // uint32 per preset, an offset into the strings
+    descriptorBitsSection,   // uint64 per preset
+    parameterOffsetSection,  // uint32 per preset and one more, where the parameters of a preset start
+    parameterSection,        // float
+    flagSection,             // uint32 per preset
+    fileSizeSection,         // int64 per preset
+    modificationTimeSection, // int64 per preset, in milliseconds
+    contentHashSection,      // uint64 per preset
+    descriptorWordSection,   // uint32 per word, an offset into the strings
+    stringSection,           // zero-terminated UTF-8 strings
+    numSections
+};
+
+enum IndexFlag
+{
+    parsableFlag = 1,
+    analyzedFlag = 2,
+    extraDescriptorFlag = 4 // some descriptors have no bit, they are only in the descriptor string
+};
+
+struct LibraryIndex::Header
+{
+    char magic[4];
+    juce::uint32 version;
+    juce::uint32 numPresets;
+    juce::uint32 numDescriptorWords;
+
+    struct
+    {
+        juce::uint64 offset;
+        juce::uint64 size;
+    } sections[numSections];
+};
+
+static const char indexMagic[] = "IDLI";
+// version 3 has dropped the latent features, which are kept by LatentIndex,
+// version 4 has added extraDescriptorFlag
+static const juce::uint32 indexVersion = 4;
+
+// ========================================
+// Reading
+// ========================================
+
+bool LibraryIndex::open(const juce::File &libraryDir)
+{
+    close();
+
+    auto file = std::make_unique<juce::MemoryMappedFile>(getIndexFile(libraryDir), juce::MemoryMappedFile::readOnly);
+    const auto fileSize = static_cast<juce::uint64>(file->getSize());
+    if (file->getData() == nullptr || fileSize < sizeof(Header))
+        return false;
+
+    // only the header is checked, so opening doesn't depend on the size of the library
+    auto fileHeader = static_cast<const Header*>(file->getData());
+    if (std::memcmp(fileHeader->magic, indexMagic, 4) != 0 || fileHeader->version != indexVersion)
+        return false;
+
+    const juce::uint64 numPresets = fileHeader->numPresets;
+    const juce::uint64 expectedSizes[] = {
+        numPresets * 4, numPresets * 4, numPresets * 4, numPresets * 8, (numPresets + 1) * 4, 0,
+        numPresets * 4, numPresets * 8, numPresets * 8, numPresets * 8,
+        (juce::uint64) fileHeader->numDescriptorWords * 4, 0
+    };
+    for (int i = 0; i < numSections; ++i)
+    {
+        const auto &section = fileHeader->sections[i];
+        if (section.offset % 8 != 0 || section.offset > fileSize || section.size > fileSize - section.offset
+            || (expectedSizes[i] != 0 && section.size != expectedSizes[i]))
+            return false;
+    }
+
+    // every string ends before the end of the section
+    const auto &strings = fileHeader->sections[stringSection];
+    if (strings.size == 0 || static_cast<const char*>(file->getData())[strings.offset + strings.size - 1] != 0)
+        return false;
+
+    libraryDirectory = libraryDir;
+    mappedFile = std::move(file);
+    header = fileHeader;
+
+    // the words are registered once here, so reading the descriptors of a preset only shuffles bits
+    descriptorIds.fill(-1);
+    auto wordOffsets = static_cast<const juce::uint32*>(getSection(descriptorWordSection));
+    const auto numWords = juce::jmin((int) header->numDescriptorWords, DescriptorRegistry::maxNumWords);
+    for (int i = 0; i < numWords; ++i)
+        descriptorIds[(size_t) i] = DescriptorRegistry::getInstance().intern(juce::CharPointer_UTF8(getString(wordOffsets[i])));
+    return true;
+}
+
+void LibraryIndex::close()
+{
+    header = nullptr;
+    mappedFile.reset();
+}
+
+bool LibraryIndex::isOpen() const
+{
+    return header != nullptr;
+}
+
+const juce::File& LibraryIndex::getLibraryDirectory() const
+{
+    return libraryDirectory;
+}
+
+int LibraryIndex::getNumPresets() const
+{
+    return header ? static_cast<int>(header->numPresets) : 0;
+}
+
+juce::String LibraryIndex::getPresetPath(int index) const
+{
+    return libraryDirectory.getChildFile(juce::CharPointer_UTF8(getString(getUint32(presetPathSection, index))))
+            .getFullPathName();
+}
+
+juce::String LibraryIndex::getPluginPath(int index) const
+{
+    return juce::CharPointer_UTF8(getString(getUint32(pluginPathSection, index)));
+}
+
+DescriptorSet LibraryIndex::getDescriptors(int index) const
+{
+    DescriptorSet descriptors;
+    if (!juce::isPositiveAndBelow(index, getNumPresets()))
+        return descriptors;
+
+    // the string is only parsed if the bits don't hold all the words
+    auto parseDescriptorString = [this, index] {
+        const char* descriptorString = getString(getUint32(descriptorStringSection, index));
+        return DescriptorSet::fromString(descriptorString, std::strlen(descriptorString));
+    };
+    if ((getUint32(flagSection, index) & extraDescriptorFlag) != 0)
+        return parseDescriptorString();
+
+    const auto bits = static_cast<const juce::uint64*>(getSection(descriptorBitsSection))[index];
+    for (int bit = 0; bit < DescriptorRegistry::maxNumWords; ++bit)
+    {
+        if ((bits >> bit & 1) == 0)
+            continue;
+        // a word that this process has no id left for
+        if (descriptorIds[(size_t) bit] < 0)
+            return parseDescriptorString();
+        descriptors.add(descriptorIds[(size_t) bit]);
+    }
+    return descriptors;
+}
+
+bool LibraryIndex::isParsable(int index) const
+{
+    return (getUint32(flagSection, index) & parsableFlag) != 0;
+}
+
+bool LibraryIndex::isAnalyzed(int index) const
+{
+    return (getUint32(flagSection, index) & analyzedFlag) != 0;
+}
+
+juce::int64 LibraryIndex::getFileSize(int index) const
+{
+    if (!juce::isPositiveAndBelow(index, getNumPresets()))
+        return 0;
+    return static_cast<const juce::int64*>(getSection(fileSizeSection))[index];
+}
+
+juce::int64 LibraryIndex::getModificationTime(int index) const
+{
+    if (!juce::isPositiveAndBelow(index, getNumPresets()))
+        return 0;
+    return static_cast<const juce::int64*>(getSection(modificationTimeSection))[index];
+}
+
+juce::uint64 LibraryIndex::getContentHash(int index) const
+{
+    if (!juce::isPositiveAndBelow(index, getNumPresets()))
+        return 0;
+    return static_cast<const juce::uint64*>(getSection(contentHashSection))[index];
+}
+
+const float* LibraryIndex::getParameters(int index, int &numParameters) const
+{
+    numParameters = 0;
+    if (!juce::isPositiveAndBelow(index, getNumPresets()))
+        return nullptr;
+
+    const auto begin = getUint32(parameterOffsetSection, index);
+    const auto end = getUint32(parameterOffsetSection, index + 1);
+    if (begin > end || end > header->sections[parameterSection].size / sizeof(float))
+        return nullptr;
+
+    numParameters = static_cast<int>(end - begin);
+    return static_cast<const float*>(getSection(parameterSection)) + begin;
+}
+
+int LibraryIndex::findPreset(const juce::String &presetPath) const
+{
+    if (!header)
+        return -1;
+
+    // the presets are sorted by their relative paths, compared byte by byte
+    const auto relativePath = juce::File(presetPath).getRelativePathFrom(libraryDirectory);
+    const char* target = relativePath.toRawUTF8();
+    int low = 0, high = getNumPresets();
+    while (low < high)
+    {
+        const int middle = (low + high) / 2;
+        const int order = std::strcmp(getString(getUint32(presetPathSection, middle)), target);
+        if (order == 0)
+            return middle;
+        if (order < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return -1;
+}
+
+LibraryIndex::Preset LibraryIndex::getPreset(int index) const
+{
+    Preset preset;
+    if (!juce::isPositiveAndBelow(index, getNumPresets()))
+        return preset;
+
+    preset.presetPath = getPresetPath(index);
+    preset.pluginPath = getPluginPath(index);
+    preset.descriptors = getDescriptors(index);
+
+    int numParameters;
+    if (auto parameters = getParameters(index, numParameters))
+        preset.parameters.assign(parameters, parameters + numParameters);
+
+    preset.fileSize = getFileSize(index);
+    preset.modificationTime = getModificationTime(index);
+    preset.contentHash = getContentHash(index);
+    preset.isParsable = isParsable(index);
+    preset.isAnalyzed = isAnalyzed(index);
+    return preset;
+}
+
+const char* LibraryIndex::getString(juce::uint32 offset) const
+{
+    if (!header || offset >= header->sections[stringSection].size)
+        return "";
+    return static_cast<const char*>(getSection(stringSection)) + offset;
+}
+
+juce::uint32 LibraryIndex::getUint32(int section, int index) const
+{
+    if (!header || index < 0 || (juce::uint64) index >= header->sections[section].size / 4)
+        return 0;
+    return static_cast<const juce::uint32*>(getSection(section))[index];
+}
+
+const void* LibraryIndex::getSection(int section) const
+{
+    return static_cast<const char*>(mappedFile->getData()) + header->sections[section].offset;
+}
+
+// ========================================
+// Parsing and writing
+// ========================================
+
+void LibraryIndex::parsePreset(const juce::File &file, Preset &preset)
+{
+    juce::MemoryBlock content;
+    file.loadFileAsData(content);
+    parsePreset(file, content, preset);
+}
+
+void LibraryIndex::parsePreset(const juce::File &file, const juce::MemoryBlock &content, Preset &preset)
+{
+    preset.presetPath = file.getFullPathName();
+    preset.fileSize = file.getSize();
+    preset.modificationTime = file.getLastModificationTime().toMilliseconds();
+    preset.contentHash = computeContentHash(content);
+    preset.isAnalyzed = false;
+
+    preset.isParsable = PresetManager::parse(static_cast<const char*>(content.getData()), content.getSize(),
+                                             preset.parameters, preset.pluginPath, preset.descriptors);
+}
+
+juce::uint64 LibraryIndex::computeContentHash(const juce::MemoryBlock &content)
+{
+    juce::uint64 hash = 14695981039346656037ull;
+    auto data = static_cast<const juce::uint8*>(content.getData());
+    for (size_t i = 0; i < content.getSize(); ++i)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool LibraryIndex::write(const juce::File &indexFile, const juce::File &libraryDir, std::vector<Preset> &presets)
+{
+    // the relative paths are the keys of findPreset
+    std::vector<juce::String> relativePaths;
+    relativePaths.reserve(presets.size());
+    for (const auto &preset : presets)
+        relativePaths.push_back(juce::File(preset.presetPath).getRelativePathFrom(libraryDir));
+
+    std::vector<size_t> order(presets.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&relativePaths] (size_t a, size_t b) {
+        return std::strcmp(relativePaths[a].toRawUTF8(), relativePaths[b].toRawUTF8()) < 0;
+    });
+
+    // the bits are the ids of this process, the words tell the next process which bit is which
+    const int numWords = DescriptorRegistry::getInstance().getNumWords();
+
+    // all the presets of a library come from a handful of plugins, so the strings are stored once
+    juce::MemoryOutputStream strings;
+    std::unordered_map<juce::String, juce::uint32> stringOffsets;
+    auto addString = [&strings, &stringOffsets] (const juce::String &string) {
+        auto it = stringOffsets.find(string);
+        if (it != stringOffsets.end())
+            return it->second;
+        const auto offset = static_cast<juce::uint32>(strings.getDataSize());
+        strings.write(string.toRawUTF8(), string.getNumBytesAsUTF8() + 1);
+        stringOffsets[string] = offset;
+        return offset;
+    };
+
+    const auto numPresets = presets.size();
+    std::vector<juce::uint32> presetPathOffsets, pluginPathOffsets, descriptorStringOffsets, parameterOffsets, flags;
+    std::vector<juce::uint64> descriptorBits;
+    std::vector<juce::int64> fileSizes, modificationTimes;
+    std::vector<juce::uint64> contentHashes;
+    std::vector<float> parameters;
+    parameterOffsets.push_back(0);
+
+    for (size_t i = 0; i < numPresets; ++i)
+    {
+        const auto &preset = presets[order[i]];
+        presetPathOffsets.push_back(addString(relativePaths[order[i]]));
+        pluginPathOffsets.push_back(addString(preset.pluginPath));
+        descriptorStringOffsets.push_back(addString(preset.descriptors.toString()));
+        descriptorBits.push_back(preset.descriptors.getBits());
+
+        parameters.insert(parameters.end(), preset.parameters.begin(), preset.parameters.end());
+        parameterOffsets.push_back(static_cast<juce::uint32>(parameters.size()));
+
+        juce::uint32 flag = preset.isParsable ? parsableFlag : 0;
+        if (preset.isAnalyzed)
+            flag |= analyzedFlag;
+        if (preset.descriptors.hasExtraWords())
+            flag |= extraDescriptorFlag;
+        flags.push_back(flag);
+
+        fileSizes.push_back(preset.fileSize);
+        modificationTimes.push_back(preset.modificationTime);
+        contentHashes.push_back(preset.contentHash);
+    }
+
+    std::vector<juce::uint32> wordOffsets;
+    for (int id = 0; id < numWords; ++id)
+        wordOffsets.push_back(addString(DescriptorRegistry::getInstance().getWord(id)));
+    // an empty string section would not be valid
+    addString("");
+
+    Header fileHeader {};
+    std::memcpy(fileHeader.magic, indexMagic, 4);
+    fileHeader.version = indexVersion;
+    fileHeader.numPresets = static_cast<juce::uint32>(numPresets);
+    fileHeader.numDescriptorWords = static_cast<juce::uint32>(wordOffsets.size());
+
+    const std::pair<const void*, size_t> sections[numSections] = {
+        { presetPathOffsets.data(), presetPathOffsets.size() * sizeof(juce::uint32) },
+        { pluginPathOffsets.data(), pluginPathOffsets.size() * sizeof(juce::uint32) },
+        { descriptorStringOffsets.data(), descriptorStringOffsets.size() * sizeof(juce::uint32) },
+        { descriptorBits.data(), descriptorBits.size() * sizeof(juce::uint64) },
+        { parameterOffsets.data(), parameterOffsets.size() * sizeof(juce::uint32) },
+        { parameters.data(), parameters.size() * sizeof(float) },
+        { flags.data(), flags.size() * sizeof(juce::uint32) },
+        { fileSizes.data(), fileSizes.size() * sizeof(juce::int64) },
+        { modificationTimes.data(), modificationTimes.size() * sizeof(juce::int64) },
+        { contentHashes.data(), contentHashes.size() * sizeof(juce::uint64) },
+        { wordOffsets.data(), wordOffsets.size() * sizeof(juce::uint32) },
+        { strings.getData(), strings.getDataSize() }
+    };
+
+    juce::uint64 offset = sizeof(Header);
+    for (int i = 0; i < numSections; ++i)
+    {
+        offset = (offset + 7) & ~juce::uint64(7);
+        fileHeader.sections[i].offset = offset;
+        fileHeader.sections[i].size = sections[i].second;
+        offset += sections[i].second;
+    }
+
+    if (!indexFile.getParentDirectory().createDirectory().wasOk())
+        return false;
+
+    juce::TemporaryFile temporaryFile(indexFile);
+    {
+        juce::FileOutputStream output(temporaryFile.getFile());
+        if (!output.openedOk())
+            return false;
+
+        output.write(&fileHeader, sizeof(Header));
+        for (int i = 0; i < numSections; ++i)
+        {
+            while ((juce::uint64) output.getPosition() < fileHeader.sections[i].offset)
+                output.writeByte(0);
+            output.write(sections[i].first, sections[i].second);
+        }
+
+        output.flush();
+        if (output.getStatus().failed())
+            return false;
+    }
+
+    return temporaryFile.overwriteTargetFileWithTemporary();
+}
+
+juce::File LibraryIndex::getIndexFile(const juce::File &libraryDir)
+{
+    const auto hash = juce::String::toHexString(libraryDir.getFullPathName().hashCode64());
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+            .getChildFile("Ideator")
+            .getChildFile("Libraries")
+            .getChildFile(libraryDir.getFileName() + "-" + hash + ".index");
+}
@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    LibraryIndex.h
+    Created: 17 Oct 2026 7:51:17pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+#include <memory>
+#include <array>
+#include "DescriptorRegistry.h"
+
+// A binary index of the presets in a library, so a library can be opened without parsing its XML
+// files again. The file is memory-mapped and stores every field as a column (an array over all
+// the presets), so opening it takes constant time and nothing is read until it's used.
+// LibraryScanner keeps it up to date. The index files live in the application data folder, one per library.
+class LibraryIndex
+{
+public:
+    struct Preset
+    {
+        juce::String presetPath; // the full path
+        juce::String pluginPath;
+        DescriptorSet descriptors;
+        std::vector<float> parameters;
+        juce::int64 fileSize = 0;
+        juce::int64 modificationTime = 0;
+        // a file whose size or modification time has changed but whose content hasn't is not analyzed again
+        juce::uint64 contentHash = 0;
+        bool isParsable = true; // the files that cannot be parsed are kept so they are not parsed every time
+        bool isAnalyzed = false; // the back-end has the latent features of this version of the preset
+    };
+
+    LibraryIndex() = default;
+
+    /*!
+     * Maps the index of a library as it was last written, without checking the files.
+     * @param libraryDir the root directory of the library
+     * @return false if the library has no valid index
+     */
+    bool open(const juce::File &libraryDir);
+
+    void close();
+    bool isOpen() const;
+    const juce::File& getLibraryDirectory() const;
+
+    // the presets are sorted by their paths
+    int getNumPresets() const;
+    juce::String getPresetPath(int index) const;
+    juce::String getPluginPath(int index) const;
+    // The descriptor bits are translated to the ids of this process, which can differ from the ones in the file,
+    // the descriptor string is only parsed for the words that have no bit.
+    DescriptorSet getDescriptors(int index) const;
+    bool isParsable(int index) const;
+    bool isAnalyzed(int index) const;
+    juce::int64 getFileSize(int index) const;
+    juce::int64 getModificationTime(int index) const;
+    juce::uint64 getContentHash(int index) const;
+
+    /*!
+     * @param index the index of the preset
+     * @param numParameters receives the number of parameters
+     * @return the parameter values in the order of their indices, they stay valid until the index is closed
+     */
+    const float* getParameters(int index, int &numParameters) const;
+
+    /*!
+     * @param presetPath the full path to the preset
+     * @return the index of the preset, -1 if it's not in the library
+     */
+    int findPreset(const juce::String &presetPath) const;
+
+    Preset getPreset(int index) const;
+
+    /*!
+     * Parses a preset file.
+     * @param file the preset
+     * @param preset receives the preset, isParsable is false if the file cannot be parsed
+     */
+    static void parsePreset(const juce::File &file, Preset &preset);
+
+    /*!
+     * Parses a preset that has already been read.
+     * @param file the preset, only its path, size and modification time are taken
+     * @param content the content of the file
+     * @param preset receives the preset, isParsable is false if the content cannot be parsed
+     */
+    static void parsePreset(const juce::File &file, const juce::MemoryBlock &content, Preset &preset);
+
+    // a 64-bit FNV-1a hash, it only has to tell the versions of a file apart
+    static juce::uint64 computeContentHash(const juce::MemoryBlock &content);
+
+    /*!
+     * Writes an index. The file is replaced atomically, so a reader never sees a partial index.
+     * @param indexFile the file to write
+     * @param libraryDir the root directory of the library, the presets are stored relative to it
+     * @param presets the presets, they will be sorted by their paths
+     * @return false if the file cannot be written
+     */
+    static bool write(const juce::File &indexFile, const juce::File &libraryDir, std::vector<Preset> &presets);
+
+    static juce::File getIndexFile(const juce::File &libraryDir);
+
+private:
+    struct Header;
+
+    const char* getString(juce::uint32 offset) const;
+    juce::uint32 getUint32(int section, int index) const;
+    const void* getSection(int section) const;
+
+    juce::File libraryDirectory;
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    const Header* header = nullptr;
+    // the DescriptorRegistry id of every word in the file, -1 if the registry has no id left for it
+    std::array<int, DescriptorRegistry::maxNumWords> descriptorIds;
+
+    JUCE_DECLARE_NON_COPYABLE (LibraryIndex)
+};
@@ -0,0 +1,399 @@
+/*
+  ==============================================================================
+
+    LibraryScanner.cpp
+    Created: 17 Oct 2026 7:54:16pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#include "LibraryScanner.h"
+#include "Config.h"
+#include <unordered_set>
+
+// ========================================
+// ParseJob
+// ========================================
+
+class LibraryScanner::ParseJob : public juce::ThreadPoolJob
+{
+public:
+    ParseJob(LibraryScanner &scanner, std::vector<ParseTask> &&tasks):
+            juce::ThreadPoolJob("Ideator Library Parse Job"),
+            scanner(scanner),
+            tasks(std::move(tasks))
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        std::vector<LibraryIndex::Preset> parsedPresets;
+        parsedPresets.reserve(tasks.size());
+        int numChangedPresets = 0;
+        for (auto &task : tasks)
+        {
+            if (shouldExit())
+                break;
+
+            juce::MemoryBlock content;
+            task.file.loadFileAsData(content);
+
+            // the file has only been touched, so the preset keeps its latent features and doesn't need to be analyzed again
+            LibraryIndex::Preset preset;
+            if (task.isInOldIndex && task.oldPreset.contentHash == LibraryIndex::computeContentHash(content))
+            {
+                preset = std::move(task.oldPreset);
+                preset.fileSize = task.file.getSize();
+                preset.modificationTime = task.file.getLastModificationTime().toMilliseconds();
+            }
+            else
+            {
+                LibraryIndex::parsePreset(task.file, content, preset);
+                ++numChangedPresets;
+            }
+            parsedPresets.push_back(std::move(preset));
+        }
+
+        scanner.addParsedPresets(std::move(parsedPresets), numChangedPresets);
+        return jobHasFinished;
+    }
+
+private:
+    LibraryScanner &scanner;
+    std::vector<ParseTask> tasks;
+};
+
+// ========================================
+// Watcher
+// ========================================
+
+// JUCE has no portable way of getting notified of the changes in a directory, so the library is polled
+class LibraryScanner::Watcher : public juce::Timer
+{
+public:
+    explicit Watcher(LibraryScanner &scanner):
+            scanner(scanner)
+    {
+    }
+
+    void timerCallback() override
+    {
+        if (!scanner.isScanning() && scanner.libraryDirectory.isDirectory())
+            scanner.start(scanner.libraryDirectory, false);
+    }
+
+private:
+    LibraryScanner &scanner;
+};
+
+// ========================================
+// LibraryScanner
+// ========================================
+
+LibraryScanner::LibraryScanner(int numThreads):
+        juce::Thread("Ideator Library Scanner"),
+        threadPool(numThreads > 0 ? numThreads : juce::SystemStats::getNumCpus()),
+        watcher(std::make_unique<Watcher>(*this))
+{
+}
+
+LibraryScanner::~LibraryScanner()
+{
+    watcher->stopTimer();
+    stopThread(4000);
+}
+
+void LibraryScanner::start(const juce::File &libraryDir, bool shouldListPresets)
+{
+    stopThread(4000);
+
+    libraryDirectory = libraryDir;
+    isListing = shouldListPresets;
+    numFiles = 0;
+    numScanned = 0;
+    numChanged = 0;
+    {
+        const juce::ScopedLock sl(presetsLock);
+        parsedPresets.clear();
+        pendingPresets.clear();
+        stats = Stats();
+    }
+
+    scanning = true;
+    startThread();
+}
+
+void LibraryScanner::cancel()
+{
+    signalThreadShouldExit();
+}
+
+bool LibraryScanner::isScanning() const
+{
+    return scanning;
+}
+
+double LibraryScanner::getProgress() const
+{
+    // the number of files is unknown until the directory has been walked, -1 makes a ProgressBar spin
+    if (numFiles == 0)
+        return -1.0;
+    return juce::jmin(1.0, numScanned / static_cast<double>(numFiles));
+}
+
+std::vector<LibraryIndex::Preset> LibraryScanner::popScannedPresets()
+{
+    const juce::ScopedLock sl(presetsLock);
+    std::vector<LibraryIndex::Preset> scannedPresets;
+    scannedPresets.swap(pendingPresets);
+    return scannedPresets;
+}
+
+LibraryScanner::Stats LibraryScanner::getStats() const
+{
+    const juce::ScopedLock sl(presetsLock);
+    return stats;
+}
+
+const LibraryIndex& LibraryScanner::getIndex() const
+{
+    return index;
+}
+
+void LibraryScanner::markAnalyzed(const juce::StringArray &presetPaths, juce::Time analysisStartTime)
+{
+    {
+        const juce::ScopedLock sl(presetsLock);
+        for (const auto &path : presetPaths)
+            analyzedPresets[path] = analysisStartTime.toMilliseconds();
+    }
+
+    if (!isScanning() && libraryDirectory.isDirectory())
+        start(libraryDirectory, false);
+}
+
+void LibraryScanner::setWatchInterval(int intervalMs)
+{
+    if (intervalMs > 0)
+        watcher->startTimer(intervalMs);
+    else
+        watcher->stopTimer();
+}
+
+void LibraryScanner::run()
+{
+    // the old index tells which presets haven't changed, opening it doesn't read anything yet
+    index.open(libraryDirectory);
+
+    // A file is read again only if its size or its modification time has changed. The presets
+    // that haven't changed are only copied out of the old index if a new one has to be written.
+    std::vector<int> unchangedIndices;
+    std::vector<LibraryIndex::Preset> listedPresets;
+    std::vector<ParseTask> parseTasks;
+    int numFound = 0;
+    int numWalked = 0;
+    for (const auto &entry : juce::RangedDirectoryIterator(libraryDirectory, true, "*.xml",
+                                                           juce::File::TypesOfFileToFind::findFiles))
+    {
+        // nothing is written if the directory hasn't been walked completely, the old index stays
+        if (threadShouldExit())
+        {
+            {
+                const juce::ScopedLock sl(presetsLock);
+                stats.isCancelled = true;
+                stats.isListing = isListing;
+            }
+            scanning = false;
+            scanProgressBroadcaster.sendChangeMessage();
+            return;
+        }
+
+        ++numWalked;
+        const auto &file = entry.getFile();
+        const int presetIndex = index.findPreset(file.getFullPathName());
+        if (presetIndex >= 0)
+            ++numFound;
+
+        if (presetIndex >= 0
+            && index.getFileSize(presetIndex) == entry.getFileSize()
+            && index.getModificationTime(presetIndex) == entry.getModificationTime().toMilliseconds())
+        {
+            unchangedIndices.push_back(presetIndex);
+            if (isListing && index.isParsable(presetIndex))
+            {
+                LibraryIndex::Preset listedPreset;
+                listedPreset.presetPath = file.getFullPathName();
+                listedPreset.pluginPath = index.getPluginPath(presetIndex);
+                listedPreset.descriptors = index.getDescriptors(presetIndex);
+                listedPresets.push_back(std::move(listedPreset));
+            }
+
+            if (unchangedIndices.size() % LIBRARY_SCAN_JOB_SIZE == 0)
+            {
+                handOver(std::move(listedPresets), LIBRARY_SCAN_JOB_SIZE);
+                listedPresets.clear();
+            }
+        }
+        else
+        {
+            ParseTask task;
+            task.file = file;
+            task.isInOldIndex = presetIndex >= 0;
+            if (task.isInOldIndex)
+                task.oldPreset = index.getPreset(presetIndex);
+            parseTasks.push_back(std::move(task));
+        }
+    }
+    handOver(std::move(listedPresets), static_cast<int>(unchangedIndices.size() % LIBRARY_SCAN_JOB_SIZE));
+    const int numOldPresets = index.getNumPresets();
+
+    // the files are parsed in small jobs, so the presets reach the GUI while the rest are parsed;
+    // the jobs get copies of the tasks, the old presets are still needed here if the scan is cancelled
+    numFiles = numWalked;
+    for (size_t i = 0; i < parseTasks.size(); i += LIBRARY_SCAN_JOB_SIZE)
+    {
+        const auto end = juce::jmin(parseTasks.size(), i + LIBRARY_SCAN_JOB_SIZE);
+        std::vector<ParseTask> tasks(parseTasks.begin() + (std::ptrdiff_t) i,
+                                     parseTasks.begin() + (std::ptrdiff_t) end);
+        threadPool.addJob(new ParseJob(*this, std::move(tasks)), true);
+    }
+
+    bool isCancelled = false;
+    while (threadPool.getNumJobs() > 0)
+    {
+        if (threadShouldExit())
+        {
+            threadPool.removeAllJobs(true, 4000);
+            isCancelled = true;
+            break;
+        }
+        wait(50);
+    }
+
+    std::vector<LibraryIndex::Preset> scannedPresets;
+    std::unordered_map<juce::String, juce::int64> newlyAnalyzedPresets;
+    {
+        const juce::ScopedLock sl(presetsLock);
+        scannedPresets.swap(parsedPresets);
+        newlyAnalyzedPresets.swap(analyzedPresets);
+    }
+
+    // The presets that haven't been parsed because of cancelling keep their old entries, with their
+    // content hashes and their analysis marks. Their old sizes and modification times make the next
+    // scan parse them.
+    std::vector<LibraryIndex::Preset> unparsedPresets;
+    if (isCancelled)
+    {
+        std::unordered_set<juce::String> parsedPaths;
+        for (const auto &preset : scannedPresets)
+            parsedPaths.insert(preset.presetPath);
+        for (auto &task : parseTasks)
+            if (task.isInOldIndex && parsedPaths.count(task.file.getFullPathName()) == 0)
+                unparsedPresets.push_back(std::move(task.oldPreset));
+    }
+
+    // only the presets that haven't changed since they were sent for analysis are marked,
+    // their index entries have the modification time of their files
+    Stats newStats;
+    std::vector<bool> isMarked(unchangedIndices.size(), false);
+    int numMarked = 0;
+    for (size_t i = 0; i < unchangedIndices.size(); ++i)
+    {
+        const int presetIndex = unchangedIndices[i];
+        if (!index.isParsable(presetIndex))
+            ++newStats.numUnparsable;
+        else if (!newlyAnalyzedPresets.empty() && !index.isAnalyzed(presetIndex))
+        {
+            auto it = newlyAnalyzedPresets.find(index.getPresetPath(presetIndex));
+            if (it != newlyAnalyzedPresets.end() && index.getModificationTime(presetIndex) <= it->second)
+            {
+                isMarked[i] = true;
+                ++numMarked;
+            }
+        }
+    }
+    for (const auto &preset : scannedPresets)
+        if (!preset.isParsable)
+            ++newStats.numUnparsable;
+
+    newStats.numPresets = static_cast<int>(unchangedIndices.size() + scannedPresets.size() + unparsedPresets.size());
+    newStats.numRead = static_cast<int>(scannedPresets.size());
+    newStats.numChanged = numChanged;
+    newStats.numRemoved = numOldPresets - numFound;
+    newStats.isCancelled = isCancelled;
+    newStats.isListing = isListing;
+
+    const bool hasChanged = !index.isOpen() || !scannedPresets.empty() || newStats.numRemoved > 0 || numMarked > 0;
+    if (hasChanged)
+    {
+        for (size_t i = 0; i < unchangedIndices.size(); ++i)
+        {
+            scannedPresets.push_back(index.getPreset(unchangedIndices[i]));
+            if (isMarked[i])
+                scannedPresets.back().isAnalyzed = true;
+        }
+        for (auto &preset : unparsedPresets)
+            scannedPresets.push_back(std::move(preset));
+
+        // the old index has to be closed before its file can be replaced
+        index.close();
+        if (!LibraryIndex::write(LibraryIndex::getIndexFile(libraryDirectory), libraryDirectory, scannedPresets))
+            DBG("LibraryScanner::run: cannot write the index of " << libraryDirectory.getFullPathName());
+        index.open(libraryDirectory);
+    }
+
+    {
+        const juce::ScopedLock sl(presetsLock);
+        stats = newStats;
+    }
+    scanning = false;
+    scanProgressBroadcaster.sendChangeMessage();
+}
+
+void LibraryScanner::addParsedPresets(std::vector<LibraryIndex::Preset> &&presets, int numChangedPresets)
+{
+    std::vector<LibraryIndex::Preset> listedPresets;
+    if (isListing)
+    {
+        // the table only shows the paths and the descriptors
+        for (const auto &preset : presets)
+        {
+            if (!preset.isParsable)
+                continue;
+
+            LibraryIndex::Preset listedPreset;
+            listedPreset.presetPath = preset.presetPath;
+            listedPreset.pluginPath = preset.pluginPath;
+            listedPreset.descriptors = preset.descriptors;
+            listedPresets.push_back(std::move(listedPreset));
+        }
+    }
+
+    const int numPresets = static_cast<int>(presets.size());
+    {
+        const juce::ScopedLock sl(presetsLock);
+        for (auto &preset : presets)
+            parsedPresets.push_back(std::move(preset));
+    }
+
+    numChanged += numChangedPresets;
+    handOver(std::move(listedPresets), numPresets);
+}
+
+void LibraryScanner::handOver(std::vector<LibraryIndex::Preset> &&listedPresets, int numScannedPresets)
+{
+    if (numScannedPresets == 0)
+        return;
+
+    if (!listedPresets.empty())
+    {
+        const juce::ScopedLock sl(presetsLock);
+        for (auto &preset : listedPresets)
+            pendingPresets.push_back(std::move(preset));
+    }
+
+    numScanned += numScannedPresets;
+    scanProgressBroadcaster.sendChangeMessage();
+    notify();
+}
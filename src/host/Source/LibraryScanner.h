@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+
+    LibraryScanner.h
+    Created: 17 Oct 2026 7:54:16pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+#include <atomic>
+#include <unordered_map>
+#include "LibraryIndex.h"
+
+// Brings the index of a library up to date in the background. The presets whose size and
+// modification time haven't changed are taken from the old index, the others are read on a
+// thread pool and only parsed if their content hash has changed. The presets are handed over
+// in batches while the scan is running, so the GUI can show them before it has finished.
+// The index also remembers which presets have been analyzed, so only the presets that have
+// been added or modified since then need to be analyzed again.
+class LibraryScanner : private juce::Thread
+{
+public:
+    struct Stats
+    {
+        int numPresets = 0;    // including the unparsable ones
+        int numRead = 0;       // the presets whose size or modification time has changed
+        int numChanged = 0;    // the presets that were added or whose content has changed
+        int numRemoved = 0;
+        int numUnparsable = 0; // these are skipped, they are kept in the index so they aren't parsed every time
+        bool isCancelled = false;
+        bool isListing = false; // the presets have been handed over by popScannedPresets
+    };
+
+    /*!
+     * @param numThreads the number of threads that parse the presets, 0 means one per CPU core
+     */
+    explicit LibraryScanner(int numThreads = 0);
+    ~LibraryScanner() override;
+
+    /*!
+     * Starts scanning a library. Any running scan will be stopped first.
+     * @param libraryDir the root directory of the library
+     * @param shouldListPresets false to only update the index, popScannedPresets gets nothing then
+     */
+    void start(const juce::File &libraryDir, bool shouldListPresets = true);
+
+    /*!
+     * Stops the scan without waiting for it. The presets that have been parsed are still written
+     * to the index, the rest will be parsed by the next scan.
+     */
+    void cancel();
+
+    bool isScanning() const;
+
+    // the fraction of the files that have been scanned, between 0 and 1
+    double getProgress() const;
+
+    /*!
+     * Takes the presets that have been scanned since the last call. They only have their paths
+     * and descriptors, the unparsable ones are left out.
+     */
+    std::vector<LibraryIndex::Preset> popScannedPresets();
+
+    // valid once the scan has finished
+    Stats getStats() const;
+
+    // should only be used while no scan is running
+    const LibraryIndex& getIndex() const;
+
+    /*!
+     * Marks presets as analyzed in the index. The index is updated by a scan in the background,
+     * which starts right away unless a scan is running, then the presets are marked by the next one.
+     * The presets are looked up by their paths when the scan writes the index, as a rescan might
+     * have moved them, and a preset whose file has been modified since the analysis started is not
+     * marked, the back-end has analyzed an older version of it.
+     * @param presetPaths the full paths to the presets that the back-end has analyzed
+     * @param analysisStartTime when the presets were sent for analysis
+     */
+    void markAnalyzed(const juce::StringArray &presetPaths, juce::Time analysisStartTime);
+
+    /*!
+     * Rescans the library every once in a while, so the presets that are changed while Ideator
+     * is running are picked up. A rescan only reads the presets that have changed.
+     * @param intervalMs the time between two scans, 0 stops watching
+     */
+    void setWatchInterval(int intervalMs);
+
+    // broadcasts when new presets have been scanned and when the scan finishes, other classes should only call addListener
+    juce::ChangeBroadcaster scanProgressBroadcaster;
+
+private:
+    // a file that needs to be read, with what the old index knows about it
+    struct ParseTask
+    {
+        juce::File file;
+        LibraryIndex::Preset oldPreset;
+        bool isInOldIndex = false;
+    };
+
+    class ParseJob;
+    class Watcher;
+
+    void run() override;
+    void addParsedPresets(std::vector<LibraryIndex::Preset> &&presets, int numChangedPresets);
+    // hands the presets to the GUI and updates the progress
+    void handOver(std::vector<LibraryIndex::Preset> &&listedPresets, int numScannedPresets);
+
+    juce::ThreadPool threadPool;
+    LibraryIndex index;
+    juce::File libraryDirectory;
+    bool isListing = true;
+    std::unique_ptr<Watcher> watcher;
+
+    std::atomic<bool> scanning { false };
+    std::atomic<int> numFiles { 0 };
+    std::atomic<int> numScanned { 0 };
+    std::atomic<int> numChanged { 0 };
+
+    juce::CriticalSection presetsLock;
+    // the presets that have been read by the jobs, to be written to the index
+    std::vector<LibraryIndex::Preset> parsedPresets;
+    // the presets that haven't been taken by popScannedPresets
+    std::vector<LibraryIndex::Preset> pendingPresets;
+    // the presets that have been analyzed since the last scan, with the time their analysis started in milliseconds
+    std::unordered_map<juce::String, juce::int64> analyzedPresets;
+    Stats stats;
+
+    JUCE_DECLARE_NON_COPYABLE (LibraryScanner)
+};
@@ -0,0 +1,185 @@
+/*
+  ==============================================================================
+
+    MelSpectrogram.cpp
+    Created: 17 Oct 2026 7:42:29pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#include "MelSpectrogram.h"
+#include <cmath>
+
+// the parameters of AudioFeatureExtractor.encode
+static const int resampleRatio = 2; // 44100 / 22050
+static const int lowpassFilterWidth = 6;
+static const double rolloff = 0.99;
+static const double outputSampleRate = 22050.;
+static const double minFrequency = 30.;
+static const double maxFrequency = 11000.;
+
+static double hzToMel(double frequency)
+{
+    return 2595. * std::log10(1. + frequency / 700.);
+}
+
+static double melToHz(double mel)
+{
+    return 700. * (std::pow(10., mel / 2595.) - 1.);
+}
+
+// A single running sum is a chain of dependent additions that the compiler may not reorder,
+// eight independent sums fit a SIMD register and are vectorised.
+static float dotProduct(const float* a, const float* b, int size)
+{
+    constexpr int numLanes = 8;
+    float sums[numLanes] = {};
+    int i = 0;
+    for (; i + numLanes <= size; i += numLanes)
+        for (int lane = 0; lane < numLanes; ++lane)
+            sums[lane] += a[i + lane] * b[i + lane];
+
+    float sum = 0.f;
+    for (; i < size; ++i)
+        sum += a[i] * b[i];
+    for (int lane = 0; lane < numLanes; ++lane)
+        sum += sums[lane];
+    return sum;
+}
+
+MelSpectrogram::MelSpectrogram():
+        fft(fftOrder),
+        window((size_t) fftSize),
+        fftBuffer((size_t) fftSize * 2),
+        powerSpectrum((size_t) numBins)
+{
+    // the periodic Hann window of torch.hann_window
+    for (int n = 0; n < fftSize; ++n)
+        window[(size_t) n] = static_cast<float>(0.5 - 0.5 * std::cos(2. * juce::MathConstants<double>::pi * n / fftSize));
+
+    // the kernel of torchaudio.functional.resample for orig_freq 2 and new_freq 1
+    const double baseFrequency = rolloff; // min(orig_freq, new_freq) * rolloff
+    kernelWidth = static_cast<int>(std::ceil(lowpassFilterWidth * resampleRatio / baseFrequency));
+    kernel.resize((size_t) (2 * kernelWidth + resampleRatio));
+    for (int k = 0; k < (int) kernel.size(); ++k)
+    {
+        double t = static_cast<double>(k - kernelWidth) / resampleRatio * baseFrequency;
+        t = juce::jlimit<double>(-lowpassFilterWidth, lowpassFilterWidth, t);
+        const double hann = std::pow(std::cos(t * juce::MathConstants<double>::pi / lowpassFilterWidth / 2.), 2.);
+        t *= juce::MathConstants<double>::pi;
+        const double sinc = t == 0. ? 1. : std::sin(t) / t;
+        kernel[(size_t) k] = static_cast<float>(sinc * hann * baseFrequency / resampleRatio);
+    }
+
+    // the filter bank of torchaudio.functional.melscale_fbanks
+    const double minMel = hzToMel(minFrequency);
+    const double maxMel = hzToMel(maxFrequency);
+    std::vector<double> filterFrequencies((size_t) numMels + 2);
+    for (int i = 0; i < numMels + 2; ++i)
+        filterFrequencies[(size_t) i] = melToHz(minMel + (maxMel - minMel) * i / (numMels + 1));
+
+    filters.resize((size_t) numMels);
+    for (int m = 0; m < numMels; ++m)
+    {
+        const double lower = filterFrequencies[(size_t) m];
+        const double centre = filterFrequencies[(size_t) m + 1];
+        const double upper = filterFrequencies[(size_t) m + 2];
+
+        auto &filter = filters[(size_t) m];
+        filter.startBin = -1;
+        for (int bin = 0; bin < numBins; ++bin)
+        {
+            const double frequency = (outputSampleRate / 2.) * bin / (numBins - 1);
+            const double weight = juce::jmax(0., juce::jmin((frequency - lower) / (centre - lower),
+                                                            (upper - frequency) / (upper - centre)));
+            if (weight <= 0.)
+            {
+                if (filter.startBin >= 0)
+                    break;
+                continue;
+            }
+
+            if (filter.startBin < 0)
+                filter.startBin = bin;
+            filter.weights.push_back(static_cast<float>(weight));
+        }
+
+        // a band that is narrower than a bin stays empty, as it does in torchaudio
+        if (filter.startBin < 0)
+            filter.startBin = 0;
+    }
+}
+
+bool MelSpectrogram::compute(const float* samples, int numSamples, double sampleRate, std::vector<float> &features)
+{
+    if (sampleRate != inputSampleRate || samples == nullptr)
+        return false;
+
+    // the model takes exactly 64 frames, which is one more than the STFT gives for about 3 seconds
+    const int numResampledSamples = (numSamples + resampleRatio - 1) / resampleRatio;
+    if (numResampledSamples / hopSize != numFrames)
+        return false;
+
+    resample(samples, numSamples);
+
+    features.assign((size_t) numFeatures, 0.f);
+    for (int frame = 0; frame < numFrames; ++frame)
+    {
+        computePowerSpectrum(frame);
+
+        for (int m = 0; m < numMels; ++m)
+        {
+            const auto &filter = filters[(size_t) m];
+            const float energy = dotProduct(filter.weights.data(), powerSpectrum.data() + filter.startBin,
+                                            static_cast<int>(filter.weights.size()));
+            features[(size_t) (m * numFrames + frame)] = std::log(energy + 1.f);
+        }
+    }
+
+    // normalise, the maximum of a silent buffer is 0
+    const auto range = juce::FloatVectorOperations::findMinAndMax(features.data(), numFeatures);
+    juce::FloatVectorOperations::multiply(features.data(), 1.f / juce::jmax(range.getEnd(), 1e-8f), numFeatures);
+    return true;
+}
+
+void MelSpectrogram::resample(const float* samples, int numSamples)
+{
+    // The input is zero-padded by kernelWidth on the left and kernelWidth + 2 on the right,
+    // and every output sample is the dot product of the kernel with the input at twice its index.
+    const int numResampledSamples = (numSamples + resampleRatio - 1) / resampleRatio;
+    const int kernelSize = static_cast<int>(kernel.size());
+    resampled.resize((size_t) numResampledSamples);
+
+    for (int n = 0; n < numResampledSamples; ++n)
+    {
+        const int start = n * resampleRatio - kernelWidth;
+        const int firstTap = juce::jmax(0, -start);
+        const int lastTap = juce::jmin(kernelSize, numSamples - start);
+        resampled[(size_t) n] = dotProduct(kernel.data() + firstTap, samples + start + firstTap, lastTap - firstTap);
+    }
+}
+
+void MelSpectrogram::computePowerSpectrum(int frameIndex)
+{
+    // the signal is centred, so the frames start half a window early with the signal mirrored at the edges
+    const int length = static_cast<int>(resampled.size());
+    const int start = frameIndex * hopSize - fftSize / 2;
+    for (int n = 0; n < fftSize; ++n)
+    {
+        int index = start + n;
+        if (index < 0)
+            index = -index;
+        else if (index >= length)
+            index = 2 * (length - 1) - index;
+        fftBuffer[(size_t) n] = resampled[(size_t) index];
+    }
+    juce::FloatVectorOperations::multiply(fftBuffer.data(), window.data(), fftSize);
+
+    // the result is interleaved complex values of the non-negative frequencies
+    fft.performRealOnlyForwardTransform(fftBuffer.data(), true);
+    // the squared magnitudes are the sums of the squares of neighbouring values
+    juce::FloatVectorOperations::multiply(fftBuffer.data(), fftBuffer.data(), numBins * 2);
+    for (int bin = 0; bin < numBins; ++bin)
+        powerSpectrum[(size_t) bin] = fftBuffer[(size_t) bin * 2] + fftBuffer[(size_t) bin * 2 + 1];
+}
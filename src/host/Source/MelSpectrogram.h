@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    MelSpectrogram.h
+    Created: 17 Oct 2026 7:42:29pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+// Computes the input of the auto-encoder of the Python program, which is the same as
+// AudioFeatureExtractor.encode in audio_feature_extractor.py does with torchaudio:
+//     1. resample from 44.1 kHz to 22.05 kHz (Resample, sinc interpolation with a Hann window)
+//     2. STFT with n_fft 2048, hop 1024, a periodic Hann window and reflected padding at both ends
+//     3. power spectrum to 64 mel bands (HTK scale, 30 - 11000 Hz, no normalisation)
+//     4. drop the last frame, log(x + 1) and divide by the maximum
+// The result is a 64 x 64 matrix, stored band by band. Not thread-safe, every thread needs its own object.
+class MelSpectrogram
+{
+public:
+    static constexpr int numMels = 64;
+    static constexpr int numFrames = 64;
+    static constexpr int numFeatures = numMels * numFrames;
+
+    MelSpectrogram();
+
+    /*!
+     * Computes the normalised log-mel spectrogram of a rendered preset.
+     * @param samples the audio, only 3 seconds at 44.1 kHz fit the model
+     * @param numSamples the number of samples
+     * @param sampleRate the sample rate of the audio
+     * @param features receives numFeatures values
+     * @return false if the audio doesn't fit the model
+     */
+    bool compute(const float* samples, int numSamples, double sampleRate, std::vector<float> &features);
+
+private:
+    void resample(const float* samples, int numSamples);
+    void computePowerSpectrum(int frameIndex);
+
+    static constexpr double inputSampleRate = 44100.;
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 2;
+    static constexpr int numBins = fftSize / 2 + 1;
+
+    juce::dsp::FFT fft;
+    std::vector<float> window;
+
+    // resampling by 2:1 is a strided convolution with a windowed sinc
+    int kernelWidth;
+    std::vector<float> kernel;
+
+    // every mel band is a triangle over a few bins of the power spectrum
+    struct MelFilter
+    {
+        int startBin = 0;
+        std::vector<float> weights;
+    };
+    std::vector<MelFilter> filters;
+
+    std::vector<float> resampled;
+    std::vector<float> fftBuffer;
+    std::vector<float> powerSpectrum;
+
+    JUCE_DECLARE_NON_COPYABLE (MelSpectrogram)
+};
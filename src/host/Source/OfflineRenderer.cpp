@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.cpp
+    Created: 17 Oct 2026 7:24:30pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+
+int RenderSpec::getNumSamples() const
+{
+    return juce::roundToInt(sampleRate * audioLength);
+}
+
+int RenderSpec::getNumNoteSamples() const
+{
+    return juce::roundToInt(sampleRate * noteLength);
+}
+
+void OfflineRenderer::prepare(juce::AudioPluginInstance &instance, const RenderSpec &spec)
+{
+    instance.setNonRealtime(true);
+    // must call prepareToPlay to enable the non-realtime setting
+    instance.prepareToPlay(spec.sampleRate, spec.blockSize);
+}
+
+bool OfflineRenderer::render(juce::AudioPluginInstance &instance,
+                             const RenderSpec &spec,
+                             juce::AudioBuffer<float> &output,
+                             const std::function<bool()> &shouldContinue)
+{
+    // initialize constants
+    const int numSamples = spec.getNumSamples();
+    const int numNoteSamples = spec.getNumNoteSamples();
+    const int blockSize = spec.blockSize;
+    const int numChannels = instance.getTotalNumOutputChannels(); // NOTE: The VST3 version of Helm returns 0 (don't know why)
+
+    // The plugin processes the output buffer in place, so there is no scratch buffer to copy from.
+    // The channels are cleared through their write pointers, because AudioBuffer::clear() would
+    // mark the whole buffer as cleared, and the writes through the block views below don't reset that flag.
+    output.setSize(numChannels, numSamples);
+    for (int i=0; i<numChannels; ++i)
+        juce::FloatVectorOperations::clear(output.getWritePointer(i), numSamples);
+
+    // create midi on and off messages
+    const auto onMessage = juce::MidiMessage::noteOn(1, spec.midiNote, spec.midiVelocity);
+    const auto offMessage = juce::MidiMessage::noteOff(1, spec.midiNote, spec.midiVelocity);
+
+    // the number of samples the output has to stay quiet before the render stops
+    const int numSilenceHoldSamples = static_cast<int>(spec.sampleRate * spec.silenceHoldTime);
+    const int numSilentPresetHoldSamples = static_cast<int>(spec.sampleRate * spec.silentPresetHoldTime);
+    bool hasSound = false;
+    int numQuietSamples = 0;
+
+    // process
+    juce::MidiBuffer midiBlock;
+    bool hasNoteOff = false;
+    for (int currentSample=0, numBlockSamples=0; currentSample < numSamples; currentSample+=numBlockSamples)
+    {
+        if (shouldContinue && !shouldContinue())
+            return false;
+
+        numBlockSamples = juce::jmin(blockSize, numSamples - currentSample);
+
+        // The timestamp of an event is the number of samples from the start of the block,
+        // so both notes land on their exact samples whatever the block size is.
+        midiBlock.clear();
+        if (currentSample == 0)
+            midiBlock.addEvent(onMessage, 0);
+        if (!hasNoteOff && numNoteSamples < currentSample + numBlockSamples)
+        {
+            midiBlock.addEvent(offMessage, numNoteSamples - currentSample);
+            hasNoteOff = true;
+        }
+
+        // a view of the block inside the output buffer
+        juce::AudioBuffer<float> block(output.getArrayOfWritePointers(),
+                                       numChannels,
+                                       currentSample,
+                                       numBlockSamples);
+        instance.processBlock(block, midiBlock);
+
+        if (!spec.stopOnSilence)
+            continue;
+
+        if (block.getMagnitude(0, numBlockSamples) > spec.silenceThreshold)
+        {
+            hasSound = true;
+            numQuietSamples = 0;
+        }
+        else
+        {
+            numQuietSamples += numBlockSamples;
+        }
+
+        // A sound can only fade out after the note-off. A preset that hasn't made any sound is
+        // only given up on after the note-off as well, a pad may take most of the note to fade in,
+        // and some presets only sound on the release. The rest of the output is already zero.
+        const int numReleaseSamples = currentSample + numBlockSamples - numNoteSamples;
+        if ((hasNoteOff && numQuietSamples >= numSilenceHoldSamples)
+            || (!hasSound && hasNoteOff && numReleaseSamples >= numSilentPresetHoldSamples))
+            break;
+    }
+
+    return true;
+}
+
+bool OfflineRenderer::isSilent(const juce::AudioBuffer<float> &buffer, const RenderSpec &spec)
+{
+    return buffer.getMagnitude(0, buffer.getNumSamples()) <= spec.silenceThreshold;
+}
+
+bool OfflineRenderer::saveToWavFile(const juce::AudioBuffer<float> &buffer, double sampleRate, const juce::File &wavFile)
+{
+    juce::WavAudioFormat format;
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    // a FileOutputStream appends to an existing file, so start from an empty one
+    if (!wavFile.deleteFile() || !wavFile.create().wasOk())
+        return false;
+
+    writer.reset (format.createWriterFor (new juce::FileOutputStream (wavFile),
+                                          sampleRate,
+                                          buffer.getNumChannels(),
+                                          24,
+                                          {},
+                                          0));
+    if (writer == nullptr)
+        return false;
+
+    return writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+}
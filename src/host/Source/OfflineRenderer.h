@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.h
+    Created: 17 Oct 2026 7:24:30pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "Config.h"
+
+// Describes how a preset is rendered: a single note that is held for noteLength seconds
+// inside a clip of audioLength seconds.
+struct RenderSpec
+{
+    double sampleRate = 44100.;
+    double audioLength = 3.; // 3 seconds of audio
+    double noteLength = 2.;
+    int blockSize = OFFLINE_BLOCK_SIZE;
+    int midiNote = 60;
+    juce::uint8 midiVelocity = 127;
+
+    // Early termination: the render stops once the output has stayed below silenceThreshold
+    // for silenceHoldTime seconds after the note-off. A preset that hasn't made any sound is
+    // given up on silentPresetHoldTime seconds after the note-off, so the slow attacks are
+    // heard through the whole note. The rest of the clip is zero-filled.
+    bool stopOnSilence = true;
+    float silenceThreshold = 0.0001f; // -80 dB
+    double silenceHoldTime = 0.2;
+    double silentPresetHoldTime = 0.5;
+
+    int getNumSamples() const;
+    int getNumNoteSamples() const;
+};
+
+class OfflineRenderer
+{
+public:
+    /*!
+     * Switches the instance to non-realtime mode and prepares it for the given spec.
+     * @param instance the plugin instance that will be used for rendering
+     * @param spec the render spec
+     */
+    static void prepare(juce::AudioPluginInstance &instance, const RenderSpec &spec);
+
+    /*!
+     * Renders one note with the current setting of the instance.
+     * The instance must have been prepared with the same spec.
+     * @param instance the plugin instance
+     * @param spec the render spec
+     * @param output the buffer that receives the rendered audio, it will be resized
+     * @param shouldContinue called before every block, the render is cancelled once it returns false
+     * @return false if the render has been cancelled
+     */
+    static bool render(juce::AudioPluginInstance &instance,
+                       const RenderSpec &spec,
+                       juce::AudioBuffer<float> &output,
+                       const std::function<bool()> &shouldContinue = nullptr);
+
+    /*!
+     * Checks if the rendered audio never goes above the silence threshold of the spec,
+     * which means the preset doesn't make any sound with the given note.
+     * @param buffer the rendered audio
+     * @param spec the render spec
+     */
+    static bool isSilent(const juce::AudioBuffer<float> &buffer, const RenderSpec &spec);
+
+    /*!
+     * Saves the rendered audio as a 24-bit WAV file.
+     * @param buffer the rendered audio
+     * @param sampleRate the sample rate of the audio
+     * @param wavFile the file to write, it will be created if it doesn't exist
+     * @return true if the file has been written
+     */
+    static bool saveToWavFile(const juce::AudioBuffer<float> &buffer, double sampleRate, const juce::File &wavFile);
+};
@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    PluginInstancePool.cpp
+    Created: 17 Oct 2026 7:28:08pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#include "PluginInstancePool.h"
+
+PluginInstancePool::PluginInstancePool(int maxNumEntries):
+        maxNumEntries(juce::jmax(0, maxNumEntries))
+{
+}
+
+PluginInstancePool::~PluginInstancePool()
+{
+    clear();
+}
+
+void PluginInstancePool::release(Entry entry)
+{
+    if (!entry.instance || maxNumEntries == 0)
+    {
+        deleteEntry(entry);
+        return;
+    }
+
+    entries.push_front(std::move(entry));
+
+    while (static_cast<int>(entries.size()) > maxNumEntries)
+    {
+        deleteEntry(entries.back());
+        entries.pop_back();
+    }
+}
+
+bool PluginInstancePool::acquire(const juce::String &pluginPath, Entry &entry)
+{
+    for (auto it = entries.begin(); it != entries.end(); ++it)
+    {
+        if (it->pluginPath == pluginPath)
+        {
+            entry = std::move(*it);
+            entries.erase(it);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void PluginInstancePool::clear()
+{
+    for (auto &entry : entries)
+        deleteEntry(entry);
+    entries.clear();
+}
+
+void PluginInstancePool::deleteEntry(Entry &entry)
+{
+    if (entry.instance)
+        entry.instance->releaseResources();
+    if (entry.offlineInstance)
+        entry.offlineInstance->releaseResources();
+
+    entry.offlineInstance.reset();
+    entry.instance.reset();
+}
@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    PluginInstancePool.h
+    Created: 17 Oct 2026 7:28:08pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <list>
+
+// Keeps the instances of recently used plugins alive and prepared, so switching back to
+// one of them doesn't need a new instance. The least recently used ones are deleted once
+// there are too many of them.
+class PluginInstancePool
+{
+public:
+    struct Entry
+    {
+        juce::String pluginPath;
+        std::unique_ptr<juce::AudioPluginInstance> instance;
+        std::unique_ptr<juce::AudioPluginInstance> offlineInstance; // can be nullptr
+        double sampleRate = 0.;
+        int samplesPerBlock = 0;
+    };
+
+    /*!
+     * @param maxNumEntries the maximum number of plugins that are kept
+     */
+    explicit PluginInstancePool(int maxNumEntries);
+    ~PluginInstancePool();
+
+    /*!
+     * Puts the instances of a plugin that is no longer used into the pool.
+     * @param entry the instances, which should be prepared with the sample rate and block size in the entry
+     */
+    void release(Entry entry);
+
+    /*!
+     * Takes the instances of a plugin out of the pool.
+     * @param pluginPath the path to the plugin
+     * @param entry receives the instances
+     * @return false if the plugin is not in the pool
+     */
+    bool acquire(const juce::String &pluginPath, Entry &entry);
+
+    void clear();
+
+private:
+    static void deleteEntry(Entry &entry);
+
+    const int maxNumEntries;
+    std::list<Entry> entries; // the most recently used entry is at the front
+
+    JUCE_DECLARE_NON_COPYABLE (PluginInstancePool)
+};
@@ -0,0 +1,181 @@
+/*
+  ==============================================================================
+
+    PluginLoader.cpp
+    Created: 17 Oct 2026 7:24:30pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#include "PluginLoader.h"
+#include <map>
+
+// ========================================
+// PluginScanCache
+// ========================================
+
+// Maps the path and the modification time of a plugin file to its description, so a plugin
+// only needs to be scanned again when it has been changed. The cache is saved as an XML file.
+class PluginScanCache : private juce::DeletedAtShutdown
+{
+public:
+    PluginScanCache()
+    {
+        formatManager.addDefaultFormats();
+        load();
+    }
+
+    ~PluginScanCache() override
+    {
+        clearSingletonInstance();
+    }
+
+    bool findDescription(const juce::String &path, juce::PluginDescription &description, juce::String &errorMessage)
+    {
+        const auto modificationTime = getModificationTime(path);
+        {
+            const juce::ScopedLock sl(lock);
+            auto it = entries.find(path);
+            if (it != entries.end() && it->second.modificationTime == modificationTime)
+            {
+                description = it->second.description;
+                return true;
+            }
+        }
+
+        // The lock is not held while scanning. Some formats scan on the message thread, which
+        // may be waiting for the lock in another findDescription, so holding it would deadlock.
+        // Two threads may scan the same plugin then, the second one only overwrites the entry.
+        juce::OwnedArray<juce::PluginDescription> pluginDescriptions;
+        juce::KnownPluginList pluginList;
+        for (int i = 0; i < formatManager.getNumFormats(); ++i)
+        {
+            pluginList.scanAndAddFile (path,
+                                       true,
+                                       pluginDescriptions,
+                                       *formatManager.getFormat(i));
+        }
+
+        // If there is a problem here first check the preprocessor definitions
+        // in the projucer are sensible - is it set up to scan for plugin's?
+        jassert (pluginDescriptions.size() > 0);
+
+        if (pluginDescriptions.isEmpty())
+        {
+            errorMessage = "No plugin found in " + path;
+            return false;
+        }
+
+        description = *pluginDescriptions[0];
+
+        const juce::ScopedLock sl(lock);
+        entries[path] = {modificationTime, description};
+        save();
+        return true;
+    }
+
+    std::unique_ptr<juce::AudioPluginInstance> createInstance(const juce::PluginDescription &description,
+                                                              double sampleRate,
+                                                              int blockSize,
+                                                              juce::String &errorMessage)
+    {
+        // the format manager is not changed after the construction, so no lock is needed
+        return formatManager.createPluginInstance(description, sampleRate, blockSize, errorMessage);
+    }
+
+    JUCE_DECLARE_SINGLETON (PluginScanCache, false)
+
+private:
+    struct Entry
+    {
+        juce::int64 modificationTime;
+        juce::PluginDescription description;
+    };
+
+    static juce::File getCacheFile()
+    {
+        return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                .getChildFile("Ideator")
+                .getChildFile("PluginScanCache.xml");
+    }
+
+    static juce::int64 getModificationTime(const juce::String &path)
+    {
+        // VST3 and AU plugins are bundles, whose own time stamp doesn't always change
+        // when the plugin is updated, but the Info.plist inside does
+        juce::File file(path);
+        auto modificationTime = file.getLastModificationTime().toMilliseconds();
+        auto infoFile = file.getChildFile("Contents").getChildFile("Info.plist");
+        if (file.isDirectory() && infoFile.existsAsFile())
+            modificationTime = juce::jmax(modificationTime, infoFile.getLastModificationTime().toMilliseconds());
+        return modificationTime;
+    }
+
+    void load()
+    {
+        auto xmlCache = juce::XmlDocument::parse(getCacheFile());
+        if (!xmlCache || !xmlCache->hasTagName("PluginScanCache"))
+            return;
+
+        for (auto *xmlEntry : xmlCache->getChildWithTagNameIterator("Entry"))
+        {
+            Entry entry;
+            entry.modificationTime = xmlEntry->getStringAttribute("modificationTime").getLargeIntValue();
+            auto xmlDescription = xmlEntry->getFirstChildElement();
+            if (xmlDescription && entry.description.loadFromXml(*xmlDescription))
+                entries[xmlEntry->getStringAttribute("path")] = entry;
+        }
+    }
+
+    void save() const
+    {
+        juce::XmlElement xmlCache("PluginScanCache");
+        for (const auto &it : entries)
+        {
+            auto xmlEntry = xmlCache.createNewChildElement("Entry");
+            xmlEntry->setAttribute("path", it.first);
+            xmlEntry->setAttribute("modificationTime", juce::String(it.second.modificationTime));
+            xmlEntry->addChildElement(it.second.description.createXml().release());
+        }
+
+        auto cacheFile = getCacheFile();
+        if (!cacheFile.create().wasOk())
+            return;
+        xmlCache.writeTo(cacheFile);
+    }
+
+    juce::AudioPluginFormatManager formatManager;
+    juce::CriticalSection lock;
+    std::map<juce::String, Entry> entries;
+};
+
+JUCE_IMPLEMENT_SINGLETON (PluginScanCache)
+
+// ========================================
+// PluginLoader
+// ========================================
+
+bool PluginLoader::findDescription(const juce::String &path,
+                                   juce::PluginDescription &description,
+                                   juce::String &errorMessage)
+{
+    return PluginScanCache::getInstance()->findDescription(path, description, errorMessage);
+}
+
+std::unique_ptr<juce::AudioPluginInstance> PluginLoader::createInstance(const juce::String &path,
+                                                                        double sampleRate,
+                                                                        int blockSize,
+                                                                        juce::String &errorMessage)
+{
+    juce::PluginDescription description;
+    if (!findDescription(path, description, errorMessage))
+        return nullptr;
+
+    return PluginScanCache::getInstance()->createInstance(description, sampleRate, blockSize, errorMessage);
+}
+
+void PluginLoader::loadScanCache()
+{
+    PluginScanCache::getInstance();
+}
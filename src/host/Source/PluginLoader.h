@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    PluginLoader.h
+    Created: 17 Oct 2026 7:24:30pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+class PluginLoader
+{
+public:
+    /*!
+     * Finds the description of the plugin file. The description is taken from the scan cache if
+     * the file has not been modified since it was scanned, otherwise the file is scanned and the
+     * result is written to the cache.
+     * @param path the absolute path to the plugin
+     * @param description receives the description
+     * @param errorMessage set to the reason of the failure if the plugin cannot be found
+     * @return true if the description has been found
+     */
+    static bool findDescription(const juce::String &path,
+                                juce::PluginDescription &description,
+                                juce::String &errorMessage);
+
+    /*!
+     * Creates a new instance of the plugin file.
+     * This can be called from any thread. If the plugin format needs the message thread
+     * for instantiation, the calling thread will block until the message thread has
+     * created the instance, so never call this from a thread that blocks the message thread.
+     * @param path the absolute path to the plugin
+     * @param sampleRate the initial sample rate of the instance
+     * @param blockSize the initial block size of the instance
+     * @param errorMessage set to the reason of the failure if no instance can be created
+     * @return the new instance, or nullptr if it fails
+     */
+    static std::unique_ptr<juce::AudioPluginInstance> createInstance(const juce::String &path,
+                                                                     double sampleRate,
+                                                                     int blockSize,
+                                                                     juce::String &errorMessage);
+
+    /*!
+     * Loads the scan cache from disk, it's loaded on the first use if this is not called.
+     */
+    static void loadScanCache();
+};
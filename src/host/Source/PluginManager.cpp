@@ -10,21 +10,44 @@
 
 #include "PluginManager.h"
 #include "Config.h"
+#include "PluginLoader.h"
+#include "PresetCache.h"
+#include <algorithm>
 #include <sstream>
 
 PluginManager::PluginManager():
         plugin(nullptr),
+        warmPlugins(NUM_WARM_PLUGINS),
         initialSampleRate(44100.f),
         initialBufferSize(256),
         internSampleRate(initialSampleRate),
         internSamplesPerBlock(initialBufferSize),
+        numPresetSent(0),
         numPresetAnalyzed(0),
+        nextBufferId(0),
+        numLibraryPresetsIndexed(0),
+        analysisWindowSize(ANALYSIS_WINDOW_SIZE),
+        analysisBatchSize(ANALYSIS_BATCH_SIZE),
+        renderTimeBudgetMs(RENDER_TIME_BUDGET_MS),
+        streamTransport(LOCAL_ADDRESS, STREAM_PORT),
+        isStreamTransportEnabled(juce::SystemStats::getEnvironmentVariable(AUDIO_TRANSPORT_ENVIRONMENT_VARIABLE, "udp")
+                                         .equalsIgnoreCase("stream")),
         oscManager(nullptr)
 {
     presetAudio.clear();
+
+    // load the scan cache now, so the first plugin is loaded without a scan as well
+    PluginLoader::loadScanCache();
+
+    // without the encoder, the back-end encodes the log-mel spectrograms
+    if (LatentEncoder::getDefaultFile().existsAsFile())
+        loadLatentEncoder(LatentEncoder::getDefaultFile());
 }
 
-PluginManager::~PluginManager()= default;
+PluginManager::~PluginManager()
+{
+    saveLatentIndex();
+}
 
 
 void PluginManager::setOSCManager(OSCManager* oscManager)
@@ -35,42 +58,48 @@ void PluginManager::setOSCManager(OSCManager* oscManager)
 }
 
 /// Additional methods
-// https://github.com/fedden/RenderMan/blob/master/Source/RenderEngine.cpp
 bool PluginManager::loadPlugin(const juce::String& path)
 {
-    juce::OwnedArray<juce::PluginDescription> pluginDescriptions;
-    juce::KnownPluginList pluginList;
-    juce::AudioPluginFormatManager pluginFormatManager;
-
     if (path == pluginPath)
         return true;
 
-    // release resources before loading a new plugin
+    // Keep the current plugin warm instead of releasing it, so switching back to it is instant.
+    // Its instances stay prepared in the pool until they are the least recently used ones.
     if (plugin)
     {
-        plugin->releaseResources();
-        plugin.reset();
+        plugin->removeListener(this);
+        warmPlugins.release({pluginPath,
+                             std::move(plugin),
+                             std::move(offlinePlugin),
+                             internSampleRate,
+                             internSamplesPerBlock});
+        pluginPath = "";
     }
+    plugin.reset();
+    offlinePlugin.reset();
 
-    pluginFormatManager.addDefaultFormats();
-
-    for (int i = 0; i < pluginFormatManager.getNumFormats(); ++i)
+    PluginInstancePool::Entry warmPlugin;
+    if (warmPlugins.acquire(path, warmPlugin))
     {
-        pluginList.scanAndAddFile (path,
-                                   true,
-                                   pluginDescriptions,
-                                   *pluginFormatManager.getFormat(i));
-    }
+        plugin = std::move(warmPlugin.instance);
+        offlinePlugin = std::move(warmPlugin.offlineInstance);
 
-    // If there is a problem here first check the preprocessor definitions
-    // in the projucer are sensible - is it set up to scan for plugin's?
-    jassert (pluginDescriptions.size() > 0);
+        // only prepare it again if the audio settings have been changed in the meantime
+        if (warmPlugin.sampleRate != internSampleRate || warmPlugin.samplesPerBlock != internSamplesPerBlock)
+            plugin->prepareToPlay(internSampleRate, internSamplesPerBlock);
+        plugin->reset();
+        plugin->addListener(this);
+
+        pluginPath = path;
+        resetWhenParameterChanged();
+
+        DBG("Loaded a warm plugin: " << pluginPath);
+
+        return true;
+    }
 
     juce::String errorMessage;
-    plugin = pluginFormatManager.createPluginInstance (*pluginDescriptions[0],
-                                                       initialSampleRate,
-                                                       initialBufferSize,
-                                                       errorMessage);
+    plugin = PluginLoader::createInstance(path, initialSampleRate, initialBufferSize, errorMessage);
     if (plugin)
     {
         // Success so set up plugin, then set up features and get all available
@@ -151,76 +180,58 @@ void PluginManager::setPluginParameter(int parameterIndex, float newValue)
         param->setValueNotifyingHost(newValue);
 }
 
-void PluginManager::renderAudio()
+bool PluginManager::renderAudio()
 {
     if (!plugin)
-        return;
+        return false;
 
-    // initialize constants
-    const double audioLength = 3.; // 3 seconds of audio
-    const double noteLength = 2.;
-    const int renderSampleRate = 44100;
-    const int numSamples = static_cast<int>(renderSampleRate) * static_cast<int>(audioLength);
-    const int numNoteSamples = static_cast<int>(renderSampleRate) * static_cast<int>(noteLength);
-    const int blockSize = internSamplesPerBlock;
-    const int numChannels = plugin->getTotalNumOutputChannels(); // NOTE: The VST3 version of Helm returns 0 (don't know why)
-    const int midiNote = 60;
-    const uint8_t midiVelocity = 127;
-
-    // initialize audio buffers
-    juce::AudioBuffer<float> bufferToProcess(numChannels, blockSize);
-    presetAudio.setSize(numChannels, numSamples);
-
-    // create midi on and off messages
-    // The timestamp indicates the number of audio samples from the start of the midi buffer.
-    juce::MidiMessage onMessage;
-    onMessage = juce::MidiMessage::noteOn(1,
-                                          midiNote,
-                                          midiVelocity);
-    onMessage.setTimeStamp(0);
-    juce::MidiMessage offMessage;
-    offMessage = juce::MidiMessage::noteOff(1,
-                                            midiNote,
-                                            midiVelocity);
-
-    // add on message to the buffer
-    juce::MidiBuffer midiNoteBuffer;
-    midiNoteBuffer.addEvent(onMessage, onMessage.getTimeStamp());
-
-    // set plugin to non-realtime mode and process the block
-    plugin->setNonRealtime(true);
-    // must call prepareToPlay to enable the non-realtime setting
-    plugin->prepareToPlay(renderSampleRate, blockSize);
-
-    // process
-    bool hasNoteOff = false;
-    for (int currentSample=0, numSamplesToCopy=0; currentSample < numSamples; currentSample+=blockSize)
+    if (!prepareOfflinePlugin())
     {
-        if (currentSample >= numNoteSamples && !hasNoteOff)
-        {
-            offMessage.setTimeStamp(currentSample - numNoteSamples);
-            midiNoteBuffer.addEvent(offMessage, offMessage.getTimeStamp());
-            hasNoteOff = true;
-        }
+        // render silence rather than touching the instance of the audio callback, the buffer stays
+        // cleared, so the next request will try again
+        presetAudio.setSize(plugin->getTotalNumOutputChannels(), renderSpec.getNumSamples());
+        presetAudio.clear();
+        return false;
+    }
 
-        bufferToProcess.clear();
-        plugin->processBlock(bufferToProcess, midiNoteBuffer);
+    return OfflineRenderer::render(*offlinePlugin, renderSpec, presetAudio);
+}
 
-        numSamplesToCopy = numSamples - currentSample < blockSize ?
-                           numSamples - currentSample : blockSize;
+bool PluginManager::prepareOfflinePlugin()
+{
+    // the offline instance is created the first time it's needed
+    if (!offlinePlugin)
+    {
+        juce::String errorMessage;
+        offlinePlugin = PluginLoader::createInstance(pluginPath,
+                                                     renderSpec.sampleRate,
+                                                     renderSpec.blockSize,
+                                                     errorMessage);
+        if (!offlinePlugin)
+        {
+            DBG("PluginManager::prepareOfflinePlugin error: " << errorMessage);
+            return false;
+        }
 
-        for (int i=0; i<numChannels; ++i)
-            presetAudio.copyFrom(i,
-                                 currentSample,
-                                 bufferToProcess,
-                                 i,
-                                 0,
-                                 numSamplesToCopy);
+        OfflineRenderer::prepare(*offlinePlugin, renderSpec);
     }
 
-    // set the plugin state back to realtime mode
-    plugin->setNonRealtime(false);
-    plugin->prepareToPlay(internSampleRate, internSamplesPerBlock);
+    // sync the offline instance with the state of the live one
+    juce::MemoryBlock state;
+    plugin->getStateInformation(state);
+    offlinePlugin->setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+
+    // Not every plugin saves all of its parameters in its state, and the parameters
+    // are what the render cache is keyed by, so copy them as well.
+    const auto &parameters = plugin->getParameters();
+    const auto &offlineParameters = offlinePlugin->getParameters();
+    for (int i = 0; i < parameters.size(); ++i)
+        if (auto *param = offlineParameters[i])
+            param->setValue(parameters[i]->getValue());
+
+    // clear the internal buffer, otherwise there would be a tail from the previous sound
+    offlinePlugin->reset();
+    return true;
 }
 
 bool PluginManager::saveAudio(const juce::String &audioPath)
@@ -228,28 +239,10 @@ bool PluginManager::saveAudio(const juce::String &audioPath)
     if (!plugin)
         return false;
 
-    // A cleared presetAudio buffer means the patch has been changed, so we should update
-    // the buffer, otherwise there is no need to update.
-    if (presetAudio.hasBeenCleared())
-        renderAudio();
+    updatePresetAudio();
 
     // save to file
-    juce::WavAudioFormat format;
-    std::unique_ptr<juce::AudioFormatWriter> writer;
-    juce::File wavFile(audioPath);
-    if (!wavFile.create().wasOk())
-        return false;
-
-    writer.reset (format.createWriterFor (new juce::FileOutputStream (wavFile),
-                                          internSampleRate,
-                                          presetAudio.getNumChannels(),
-                                          24,
-                                          {},
-                                          0));
-    if (writer != nullptr)
-        writer->writeFromAudioSampleBuffer (presetAudio, 0, presetAudio.getNumSamples());
-
-    return true;
+    return OfflineRenderer::saveToWavFile(presetAudio, renderSpec.sampleRate, juce::File(audioPath));
 }
 
 void PluginManager::sendAudio()
@@ -257,49 +250,80 @@ void PluginManager::sendAudio()
     if (!plugin)
         return;
 
-    // A cleared presetAudio buffer means the patch has been changed, so we should update
-    // the buffer, otherwise there is no need to update.
-    if (presetAudio.hasBeenCleared())
-        renderAudio();
+    updatePresetAudio();
+    sendPresetBuffer(BufferContent::audio, nextBufferId++);
+}
+
+BufferContent PluginManager::updatePresetFeatures()
+{
+    // the features are cheap compared to the rendering, so they are not cached
+    if (!SEND_MEL_SPECTROGRAM || presetAudio.getNumChannels() == 0
+        || !melSpectrogram.compute(presetAudio.getReadPointer(0),
+                                   presetAudio.getNumSamples(),
+                                   renderSpec.sampleRate,
+                                   presetFeatures))
+        return BufferContent::audio;
+
+    if (latentEncoder.encode(presetFeatures.data(), static_cast<int>(presetFeatures.size()), presetLatent))
+        return BufferContent::latent;
+
+    return BufferContent::melSpectrogram;
+}
+
+void PluginManager::sendPresetBuffer(BufferContent content, int id)
+{
+    if (content == BufferContent::latent)
+        sendBuffer(presetLatent.data(), static_cast<int>(presetLatent.size()), id);
+    else if (content == BufferContent::melSpectrogram)
+        sendBuffer(presetFeatures.data(), static_cast<int>(presetFeatures.size()), id);
+    else
+        sendBuffer(presetAudio.getReadPointer(0), presetAudio.getNumSamples(), id);
+}
 
-    juce::DatagramSocket socket;
+void PluginManager::sendBuffer(const float* data, int size, int id)
+{
+    if (sharedMemoryTransport.sendBuffer(data, size, id))
+    {
+        DBG("PluginManager::sendBuffer: An audio buffer sent through the shared memory.");
+        return;
+    }
+
+    if (isStreamTransportEnabled
+        && streamTransport.sendBuffer(data, size, id))
+    {
+        DBG("PluginManager::sendBuffer: An audio buffer sent through the stream.");
+        return;
+    }
 
+    // the UDP messages are the fallback when the other transports are not available
     UdpManager udpManager(LOCAL_ADDRESS, UDP_SEND_PORT);
-    int writtenBytes = udpManager.sendBuffer(presetAudio.getReadPointer(0), presetAudio.getNumSamples());
+    int writtenBytes = udpManager.sendBuffer(data, size, id);
     if (writtenBytes == -1)
     {
-        DBG("PluginManager::sendAudio error.");
+        DBG("PluginManager::sendBuffer error.");
         return;
     }
 
-    DBG("PluginManager::sendAudio: An audio buffer sent.");
+    DBG("PluginManager::sendBuffer: An audio buffer sent.");
 }
 
 bool PluginManager::loadPreset(const juce::String &presetPath)
 {
     // We do not check if a plugin has been loaded here, because the function will
     // load the plugin if it is not loaded.
-    juce::File inputFile(presetPath);
-    auto xmlPreset = juce::XmlDocument::parse(inputFile);
-    if (!xmlPreset)
-        return false;
-
-    // parse the preset
-    juce::String newPluginPath;
-    std::unordered_set<juce::String> descriptors;
-    juce::Array<std::pair<int, float>> parameters;
-    auto isSuccessful = PresetManager::parse(*xmlPreset, parameters, newPluginPath, descriptors);
-    if (!isSuccessful)
+    // parse the preset, it's usually in the cache already
+    auto preset = PresetCache::getInstance().get(presetPath);
+    if (!preset)
         return false;
 
     // check the plugin path first, just return if it is invalid
-    if (pluginPath != newPluginPath)
-        loadPlugin(newPluginPath);
+    if (pluginPath != preset->pluginPath)
+        loadPlugin(preset->pluginPath);
 
     // set plugin parameters
     plugin->reset();  // clear the internal buffer, otherwise there would be a tail from the previous sound
-    for (const auto& parameter : parameters)
-        setPluginParameter(parameter.first, parameter.second);
+    for (size_t i = 0; i < preset->parameters.size(); ++i)
+        setPluginParameter(static_cast<int>(i), preset->parameters[i]);
 
     // the plugin will not notify the host when a preset is set in this way, so we should
     // call the callback manually
@@ -307,7 +331,7 @@ bool PluginManager::loadPreset(const juce::String &presetPath)
 
     // set meta data
     this->presetPath = presetPath;
-    timbreDescriptors = descriptors;
+    timbreDescriptors = preset->descriptors;
 
     return true;
 }
@@ -328,30 +352,27 @@ bool PluginManager::savePreset(const juce::String &presetPath)
 
 bool PluginManager::autoTag()
 {
-    if (!oscManager)
+    if (!oscManager || !plugin)
         return false;
 
-    oscManager->prepareToAutoTag();
-    sendAudio();
+    updatePresetAudio();
+    const auto content = updatePresetFeatures();
+    const int bufferId = nextBufferId++;
+    oscManager->prepareToAutoTag(content, bufferId);
+    sendPresetBuffer(content, bufferId);
 
     return true;
 }
 
 bool PluginManager::changeDescriptors(const juce::String &presetPath,
-                                      const std::unordered_set<juce::String> &newDescriptors)
+                                      const DescriptorSet &newDescriptors)
 {
-    // 1. update the preset file by changing the timbre descriptors in the file
-    juce::File inputFile(presetPath);
-
-    auto xmlPreset = juce::XmlDocument::parse(inputFile);
-    if (!xmlPreset)
+    if (!plugin)
         return false;
 
-    juce::String newPluginPath;
-    std::unordered_set<juce::String> descriptors;
-    juce::Array<std::pair<int, float>> parameters;
-    auto isSuccessful = PresetManager::parse(*xmlPreset, parameters, newPluginPath, descriptors);
-    if (!isSuccessful)
+    // 1. update the preset file by changing the timbre descriptors in the file
+    auto &presetCache = PresetCache::getInstance();
+    if (!presetCache.get(presetPath))
         return false;
 
     // TODO: I assume the user does not change the patch, so I simply use the current parameters
@@ -362,6 +383,18 @@ bool PluginManager::changeDescriptors(const juce::String &presetPath,
     if (!outputFile.create().wasOk())
         return false;
     newXmlPreset.writeTo(outputFile);
+    // the file may be rewritten within the resolution of its modification time
+    presetCache.remove(presetPath);
+
+    // The file has the current patch now, so it gets the latent features of the patch, which
+    // findSimilar and autoTag compute the same way. Without them it would be left out of the
+    // index until the next analysis, and findSimilar would ask the back-end until then.
+    updatePresetAudio();
+    if (updatePresetFeatures() == BufferContent::latent
+        && latentIndex.getEncoderId() == latentEncoder.getId())
+        addToLatentIndex(presetPath, presetLatent.data(), static_cast<int>(presetLatent.size()));
+    else
+        removeFromLatentIndex(presetPath);
 
     // 2. send the OSC message to notify the Python program to update its cache
     // sent the OSC message
@@ -370,7 +403,7 @@ bool PluginManager::changeDescriptors(const juce::String &presetPath,
     return true;
 }
 
-void PluginManager::setTimbreDescriptors(const std::unordered_set<juce::String> &timbreDescriptors)
+void PluginManager::setTimbreDescriptors(const DescriptorSet &timbreDescriptors)
 {
     if (!plugin)
         return;
@@ -378,7 +411,7 @@ void PluginManager::setTimbreDescriptors(const std::unordered_set<juce::String>
     this->timbreDescriptors = timbreDescriptors;
 }
 
-const std::unordered_set<juce::String>& PluginManager::getTimbreDescriptors() const
+const DescriptorSet& PluginManager::getTimbreDescriptors() const
 {
     return timbreDescriptors;
 }
@@ -398,38 +431,403 @@ const juce::String& PluginManager::getPluginPath() const
 
 bool PluginManager::analyzeLibrary(const juce::Array<juce::String>& presetPaths)
 {
+    if (!oscManager || presetPaths.isEmpty())
+        return false;
+
+    if (!renderPool)
+    {
+        renderPool = std::make_unique<RenderPool>(RENDER_POOL_NUM_WORKERS);
+        renderPool->resultReadyBroadcaster.addChangeListener(this);
+    }
+
+    renderPool->setTimeBudget(renderTimeBudgetMs);
+    renderPool->setLatentEncoder(latentEncoder);
+    if (latentEncoder.isLoaded())
+    {
+        // the index is cleared if it comes from another encoder
+        latentIndex.setEncoderId(latentEncoder.getId());
+        countIndexedLibraryPresets();
+    }
+
+    // the silent presets all have the latent features of silence, which the back-end computes
+    // the same way from the render spec
+    silenceLatent.clear();
+    if (latentEncoder.isLoaded())
+    {
+        const std::vector<float> silence((size_t) renderSpec.getNumSamples(), 0.0f);
+        std::vector<float> silenceFeatures;
+        if (!melSpectrogram.compute(silence.data(), static_cast<int>(silence.size()), renderSpec.sampleRate, silenceFeatures)
+            || !latentEncoder.encode(silenceFeatures.data(), static_cast<int>(silenceFeatures.size()), silenceLatent))
+            silenceLatent.clear();
+    }
+
     presetPathsInLibrary = presetPaths;
+    numPresetSent = 0;
     numPresetAnalyzed = 0;
-    // once this function is get called, a "loop" will start
-    // The C++ and the python programs will send messages back and forth until
-    // all the presets have been analyzed
-    return analyzeNextPresetInLibrary();
+    presetsInFlight.clear();
+    failedPresetPaths.clear();
+    analysisBatch = {};
+    batchedSequenceNumbers.clear();
+
+    // The presets are rendered by the render pool on its own plugin instances, and
+    // once this function is get called, a "loop" will start:
+    // the rendered presets are sent to the python program until the window is full,
+    // every reply of the python program frees a slot of the window, and then the next
+    // one is sent until all the presets have been analyzed
+    renderPool->start(presetPathsInLibrary, renderSpec);
+    startTimer(1000);
+    return true;
 }
 
-void PluginManager::findSimilar()
+void PluginManager::setAnalysisWindowSize(int numPresets)
 {
-    oscManager->prepareToFindSimilar();
-    sendAudio();
+    analysisWindowSize = juce::jmax(1, numPresets);
 }
 
-bool PluginManager::analyzeNextPresetInLibrary()
+void PluginManager::setAnalysisBatchSize(int numPresets)
 {
-    if (!oscManager)
+    analysisBatchSize = juce::jmax(1, numPresets);
+}
+
+void PluginManager::setRenderTimeBudget(int timeBudgetMs)
+{
+    renderTimeBudgetMs = timeBudgetMs;
+}
+
+void PluginManager::setStreamTransportEnabled(bool shouldUseStream)
+{
+    isStreamTransportEnabled = shouldUseStream;
+}
+
+bool PluginManager::loadLatentEncoder(const juce::File &file)
+{
+    juce::String errorMessage;
+    if (!latentEncoder.load(file, errorMessage))
+    {
+        DBG("PluginManager::loadLatentEncoder error: " << errorMessage);
         return false;
+    }
+    return true;
+}
+
+void PluginManager::setRenderSpec(const RenderSpec &spec)
+{
+    renderSpec = spec;
+
+    // the offline instance has been prepared with the old spec, and the current patch
+    // needs to be rendered again
+    offlinePlugin.reset();
+    if (!presetAudio.hasBeenCleared())
+        presetAudio.clear();
+}
+
+const RenderSpec& PluginManager::getRenderSpec() const
+{
+    return renderSpec;
+}
+
+bool PluginManager::isAnalyzingLibrary() const
+{
+    return !presetPathsInLibrary.isEmpty();
+}
+
+const std::unordered_set<juce::String>& PluginManager::getFailedPresetPaths() const
+{
+    return failedPresetPaths;
+}
+
+const juce::StringArray& PluginManager::getAnalyzedPresetPaths() const
+{
+    return analyzedPresetPaths;
+}
+
+void PluginManager::setLibraryDirectory(const juce::File &libraryDir)
+{
+    if (libraryDir == libraryDirectory)
+        return;
+
+    saveLatentIndex();
+    libraryDirectory = libraryDir;
+    libraryPresets.clear();
+    excludedPresetPaths.clear();
+    numLibraryPresetsIndexed = 0;
+    // the index is empty if the library has not been analyzed with the encoder yet
+    latentIndex.load(LatentIndex::getIndexFile(libraryDirectory));
+}
+
+void PluginManager::setLibraryPresets(const juce::StringArray &presetPaths, const juce::StringArray &outdatedPresetPaths)
+{
+    libraryPresets.clear();
+    libraryPresets.insert(presetPaths.begin(), presetPaths.end());
+    for (const auto &path : outdatedPresetPaths)
+        latentIndex.remove(path);
 
-    juce::String path = presetPathsInLibrary[numPresetAnalyzed];
+    // the presets that are gone from the library are not excluded anymore
+    for (auto it = excludedPresetPaths.begin(); it != excludedPresetPaths.end();)
+        it = libraryPresets.count(*it) > 0 ? std::next(it) : excludedPresetPaths.erase(it);
 
-    if (!loadPreset(path))
+    countIndexedLibraryPresets();
+}
+
+const juce::StringArray& PluginManager::getSimilarPresetPaths() const
+{
+    return similarPresetPaths;
+}
+
+void PluginManager::findSimilar()
+{
+    if (!plugin)
+        return;
+
+    updatePresetAudio();
+    const auto content = updatePresetFeatures();
+
+    // the host only knows the presets that have been analyzed with the same encoder
+    if (content == BufferContent::latent
+        && latentIndex.getDimension() == static_cast<int>(presetLatent.size())
+        && isLibraryIndexed())
+    {
+        findSimilarInLibrary();
+        return;
+    }
+
+    const int bufferId = nextBufferId++;
+    oscManager->prepareToFindSimilar(content, bufferId);
+    sendPresetBuffer(content, bufferId);
+}
+
+bool PluginManager::isLibraryIndexed() const
+{
+    // a partial index would only find the closest of the presets that happen to be in it
+    if (libraryDirectory == juce::File() || libraryPresets.empty()
+        || latentIndex.getEncoderId() != latentEncoder.getId())
         return false;
 
-    oscManager->prepareToAnalyzeAudio(path, timbreDescriptors);
-    sendAudio();
+    return numLibraryPresetsIndexed + static_cast<int>(excludedPresetPaths.size()) == static_cast<int>(libraryPresets.size());
+}
+
+void PluginManager::addToLatentIndex(const juce::String &presetPath, const float* latent, int size)
+{
+    // the index is cleared by latent features of another size
+    const bool isCleared = latentIndex.getDimension() != 0 && latentIndex.getDimension() != size;
+    const bool wasIndexed = latentIndex.contains(presetPath);
+    if (!latentIndex.add(presetPath, latent, size))
+        return;
+
+    if (isCleared)
+        countIndexedLibraryPresets();
+    else if (!wasIndexed && libraryPresets.count(presetPath) > 0)
+        ++numLibraryPresetsIndexed;
+    excludedPresetPaths.erase(presetPath);
+}
 
-    std::cout << "Analyzing " << numPresetAnalyzed+1 << "/" << presetPathsInLibrary.size() << std::endl;
+bool PluginManager::removeFromLatentIndex(const juce::String &presetPath)
+{
+    if (!latentIndex.remove(presetPath))
+        return false;
 
+    if (libraryPresets.count(presetPath) > 0)
+        --numLibraryPresetsIndexed;
     return true;
 }
 
+void PluginManager::excludeFromLatentIndex(const juce::String &presetPath)
+{
+    // a preset that cannot get latent features must not keep findSimilar from searching in the host
+    if (libraryPresets.count(presetPath) > 0 && !latentIndex.contains(presetPath))
+        excludedPresetPaths.insert(presetPath);
+}
+
+void PluginManager::countIndexedLibraryPresets()
+{
+    numLibraryPresetsIndexed = 0;
+    for (const auto &path : libraryPresets)
+        if (latentIndex.contains(path))
+            ++numLibraryPresetsIndexed;
+}
+
+void PluginManager::findSimilarInLibrary()
+{
+    // the presets that have been deleted since they were analyzed are dropped from the index on the way
+    bool hasMissingPresets = true;
+    while (hasMissingPresets)
+    {
+        hasMissingPresets = false;
+        similarPresetPaths.clearQuick();
+        for (const auto &match : latentIndex.search(presetLatent.data(), static_cast<int>(presetLatent.size()), NUM_SIMILAR_PRESETS))
+        {
+            if (juce::File(match.presetPath).existsAsFile())
+                similarPresetPaths.add(match.presetPath);
+            else if (removeFromLatentIndex(match.presetPath))
+            {
+                libraryPresets.erase(match.presetPath);
+                hasMissingPresets = true;
+            }
+        }
+    }
+
+    similarPresetsFoundBroadcaster.sendChangeMessage();
+}
+
+void PluginManager::saveLatentIndex()
+{
+    if (libraryDirectory == juce::File() || !latentIndex.hasChanged())
+        return;
+
+    if (!latentIndex.save(LatentIndex::getIndexFile(libraryDirectory)))
+        DBG("PluginManager::saveLatentIndex error: cannot write " << LatentIndex::getIndexFile(libraryDirectory).getFullPathName());
+}
+
+void PluginManager::fillAnalysisWindow()
+{
+    if (!oscManager || !renderPool || presetPathsInLibrary.isEmpty())
+        return;
+
+    // one batch can be filled while the other one is being encoded
+    const int windowSize = juce::jmax(analysisWindowSize, 2 * analysisBatchSize);
+
+    RenderPool::Result result;
+    while ((int) presetsInFlight.size() + analysisBatch.sequenceNumbers.size() < windowSize
+           && numPresetSent < presetPathsInLibrary.size()
+           && renderPool->popResult(numPresetSent, result))
+    {
+        // The sequence number is also the id of the buffer. The ids are never reused, so neither a
+        // buffer nor a reply that arrives late can be taken for that of another request.
+        const int sequenceNumber = nextBufferId++;
+        ++numPresetSent;
+
+        // skip the preset if it cannot be rendered
+        if (result.failed)
+        {
+            std::cout << "Skipped " << result.presetPath << ": " << result.errorMessage << std::endl;
+            failedPresetPaths.insert(result.presetPath);
+            excludeFromLatentIndex(result.presetPath);
+            ++numPresetAnalyzed;
+            continue;
+        }
+
+        // there is nothing to encode for a preset that doesn't make any sound
+        if (result.silent)
+        {
+            if (!silenceLatent.empty())
+                addToLatentIndex(result.presetPath, silenceLatent.data(), static_cast<int>(silenceLatent.size()));
+            else if (latentEncoder.isLoaded())
+                excludeFromLatentIndex(result.presetPath);
+
+            oscManager->analyzeSilentPreset(result.presetPath, result.descriptors, sequenceNumber,
+                                            renderSpec.sampleRate, renderSpec.getNumSamples());
+            presetsInFlight[sequenceNumber] = { result.presetPath, juce::Time::getMillisecondCounter() };
+            continue;
+        }
+
+        addToAnalysisBatch(result, sequenceNumber);
+    }
+
+    // A batch that isn't full is only sent if no more presets are coming, or the back-end
+    // would be idle while waiting for the rest of it.
+    if (!analysisBatch.sequenceNumbers.isEmpty()
+        && (numPresetSent == presetPathsInLibrary.size() || presetsInFlight.empty()))
+        sendAnalysisBatch();
+
+    // the rest will be sent once they have been rendered and the window has free slots
+    if (numPresetAnalyzed == presetPathsInLibrary.size())
+    {
+        stopTimer();
+        oscManager->finishAnalyzeAudio();
+        analyzedPresetPaths.clear();
+        for (const auto &path : presetPathsInLibrary)
+            if (failedPresetPaths.count(path) == 0)
+                analyzedPresetPaths.add(path);
+        presetPathsInLibrary.clear();
+        saveLatentIndex();
+        libraryAnalyzedBroadcaster.sendChangeMessage();
+        renderCache.trim(RENDER_CACHE_MAX_SIZE_MB * 1024 * 1024);
+    }
+}
+
+void PluginManager::addToAnalysisBatch(const RenderPool::Result &result, int sequenceNumber)
+{
+    // the most compact form of the preset that is available
+    BufferContent content = BufferContent::audio;
+    const float* data = result.audio.getReadPointer(0);
+    int size = result.audio.getNumSamples();
+    if (!result.latent.empty())
+    {
+        content = BufferContent::latent;
+        data = result.latent.data();
+        size = static_cast<int>(result.latent.size());
+        // the host finds the similar presets itself once it has their latent features
+        addToLatentIndex(result.presetPath, data, size);
+    }
+    else if (latentEncoder.isLoaded())
+    {
+        excludeFromLatentIndex(result.presetPath);
+    }
+    else if (!result.features.empty())
+    {
+        content = BufferContent::melSpectrogram;
+        data = result.features.data();
+        size = static_cast<int>(result.features.size());
+    }
+
+    const auto descriptorString = result.descriptors.toString();
+    const int messageSize = static_cast<int>(result.presetPath.getNumBytesAsUTF8() + descriptorString.getNumBytesAsUTF8()) + 16;
+
+    // the buffers of a batch are split evenly by the back-end, so they must be of the same kind and size
+    auto &batch = analysisBatch;
+    if (!batch.sequenceNumbers.isEmpty()
+        && (batch.content != content
+            || (int) batch.buffer.size() != size * batch.sequenceNumbers.size()
+            || (int) batch.buffer.size() + size > ANALYSIS_BATCH_MAX_NUM_SAMPLES
+            || batch.messageSize + messageSize > OSC_MAX_MESSAGE_SIZE))
+        sendAnalysisBatch();
+
+    batch.content = content;
+    batch.sequenceNumbers.add(sequenceNumber);
+    batch.presetPaths.add(result.presetPath);
+    batch.descriptorStrings.add(descriptorString);
+    batch.buffer.insert(batch.buffer.end(), data, data + size);
+    batch.messageSize += messageSize;
+
+    if (batch.sequenceNumbers.size() >= analysisBatchSize)
+        sendAnalysisBatch();
+}
+
+void PluginManager::sendAnalysisBatch()
+{
+    auto &batch = analysisBatch;
+
+    // the sequence numbers are never reused, so the first one is a unique id for the batch and its buffer
+    const int batchId = batch.sequenceNumbers.getFirst();
+    oscManager->analyzeBatch(batchId, batch.content, batch.presetPaths, batch.descriptorStrings);
+    sendBuffer(batch.buffer.data(), static_cast<int>(batch.buffer.size()), batchId);
+
+    const auto sentTime = juce::Time::getMillisecondCounter();
+    for (int i = 0; i < batch.sequenceNumbers.size(); ++i)
+    {
+        presetsInFlight[batch.sequenceNumbers[i]] = { batch.presetPaths[i], sentTime };
+        batchedSequenceNumbers[batch.presetPaths[i]] = batch.sequenceNumbers[i];
+    }
+
+    // the buffer keeps its memory for the next batch
+    batch.sequenceNumbers.clearQuick();
+    batch.presetPaths.clearQuick();
+    batch.descriptorStrings.clearQuick();
+    batch.buffer.clear();
+    batch.messageSize = 0;
+}
+
+void PluginManager::finishAnalyzingPreset(int sequenceNumber)
+{
+    auto it = presetsInFlight.find(sequenceNumber);
+    if (it == presetsInFlight.end())
+        return;
+
+    presetsInFlight.erase(it);
+    ++numPresetAnalyzed;
+    std::cout << "Analyzed " << numPresetAnalyzed << "/" << presetPathsInLibrary.size() << std::endl;
+}
+
 // ==================================================
 // AudioProcessorListener
 // ==================================================
@@ -442,8 +840,7 @@ void PluginManager::resetWhenParameterChanged()
     if (presetPath != "")
         presetPath = "";
 
-    if (!timbreDescriptors.empty())
-        timbreDescriptors.clear();
+    timbreDescriptors.clear();
 
     // Any parameter change might lead to preset audio change, so we should clear it out
     if (!presetAudio.hasBeenCleared())
@@ -451,6 +848,23 @@ void PluginManager::resetWhenParameterChanged()
 
 }
 
+void PluginManager::updatePresetAudio()
+{
+    // A cleared presetAudio buffer means the patch has been changed, so we should update
+    // the buffer, otherwise there is no need to update.
+    if (!plugin || !presetAudio.hasBeenCleared())
+        return;
+
+    // the same patch might have been rendered before
+    auto cacheKey = RenderCache::computeKey(*plugin, pluginPath, renderSpec);
+    if (renderCache.load(cacheKey, presetAudio))
+        return;
+
+    // the silence of a failed render must not be served for this patch later on
+    if (renderAudio())
+        renderCache.store(cacheKey, presetAudio, renderSpec.sampleRate);
+}
+
 void PluginManager::audioProcessorParameterChanged (juce::AudioProcessor *processor, int parameterIndex, float newValue)
 {
     // This function will be called whenever a parameter is directly changed
@@ -476,10 +890,55 @@ void PluginManager::changeListenerCallback(juce::ChangeBroadcaster *source)
 
     if (source == &oscManager->analysisFinishedBroadcaster)
     {
-        ++numPresetAnalyzed;
-        if (numPresetAnalyzed < presetPathsInLibrary.size())
-            analyzeNextPresetInLibrary();
-        else
-            oscManager->finishAnalyzeAudio();
+        // the acknowledgements can arrive in any order
+        for (auto sequenceNumber : oscManager->popAnalyzedSequenceNumbers())
+            finishAnalyzingPreset(sequenceNumber);
+
+        for (const auto &preset : oscManager->popAnalyzedPresets())
+        {
+            auto it = batchedSequenceNumbers.find(preset.presetPath);
+            if (it == batchedSequenceNumbers.end())
+                continue;
+
+            if (!preset.isAnalyzed && presetsInFlight.count(it->second) > 0)
+            {
+                std::cout << "Skipped " << preset.presetPath << ": the back-end has not received it" << std::endl;
+                failedPresetPaths.insert(preset.presetPath);
+            }
+            finishAnalyzingPreset(it->second);
+            batchedSequenceNumbers.erase(it);
+        }
+
+        fillAnalysisWindow();
     }
+    else if (renderPool && source == &renderPool->resultReadyBroadcaster)
+    {
+        fillAnalysisWindow();
+    }
+}
+
+void PluginManager::timerCallback()
+{
+    // A lost OSC message or buffer would keep its presets in flight forever, and the analysis
+    // would never finish, so they are skipped once the back-end has had enough time for them.
+    const auto now = juce::Time::getMillisecondCounter();
+    juce::Array<int> expiredSequenceNumbers;
+    for (const auto &entry : presetsInFlight)
+        if (now - entry.second.sentTime > (juce::uint32) ANALYSIS_REPLY_TIMEOUT_MS)
+            expiredSequenceNumbers.add(entry.first);
+
+    if (expiredSequenceNumbers.isEmpty())
+        return;
+
+    for (auto sequenceNumber : expiredSequenceNumbers)
+    {
+        // a reply that still arrives is ignored, the preset is not in flight anymore
+        const auto presetPath = presetsInFlight[sequenceNumber].presetPath;
+        std::cout << "Skipped " << presetPath << ": the back-end has not replied in time" << std::endl;
+        failedPresetPaths.insert(presetPath);
+        batchedSequenceNumbers.erase(presetPath);
+        finishAnalyzingPreset(sequenceNumber);
+    }
+
+    fillAnalysisWindow();
 }
\ No newline at end of file
@@ -10,12 +10,25 @@
 
 #pragma once
 #include <JuceHeader.h>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include "PluginManagerIf.h"
 #include "Utils.h"
+#include "OfflineRenderer.h"
+#include "RenderPool.h"
+#include "RenderCache.h"
+#include "PluginInstancePool.h"
+#include "SharedMemoryTransport.h"
+#include "StreamTransport.h"
+#include "MelSpectrogram.h"
+#include "LatentEncoder.h"
+#include "LatentIndex.h"
 
 class PluginManager : public PluginManagerIf,
                       private juce::AudioProcessorListener,
-                      private juce::ChangeListener
+                      private juce::ChangeListener,
+                      private juce::Timer
 {
 public:
     PluginManager();
@@ -30,23 +43,119 @@ public:
     juce::PluginDescription getPluginDescription() const override;
     const juce::Array<juce::AudioProcessorParameter*>& getPluginParameters() const override;
     void setPluginParameter(int parameterIndex, float newValue) override;
-    void renderAudio() override;
+    bool renderAudio() override;
     bool saveAudio(const juce::String &audioPath) override;
     void sendAudio() override;
     bool loadPreset(const juce::String &presetPath) override;
     bool savePreset(const juce::String &presetPath) override;
     bool autoTag() override;
     bool changeDescriptors(const juce::String &presetPath,
-                           const std::unordered_set<juce::String> &newDescriptors) override;
-    void setTimbreDescriptors(const std::unordered_set<juce::String> &timbreDescriptors) override;
-    const std::unordered_set<juce::String>& getTimbreDescriptors() const override;
+                           const DescriptorSet &newDescriptors) override;
+    void setTimbreDescriptors(const DescriptorSet &timbreDescriptors) override;
+    const DescriptorSet& getTimbreDescriptors() const override;
     void setPresetPath(const juce::String &path) override;
     const juce::String& getPresetPath() const override;
     bool analyzeLibrary(const juce::Array<juce::String>& presetPaths) override;
     void findSimilar() override;
 
+    /*!
+     * Sets how many presets can be waiting for the back-end during the library analysis.
+     * @param numPresets the size of the window, 1 means sending a preset only when the last one has been analyzed
+     */
+    void setAnalysisWindowSize(int numPresets);
+
+    /*!
+     * Sets how many presets are sent to the back-end in one message, which encodes them in one pass.
+     * The window is widened to two batches if it's smaller, so one batch can be filled while the
+     * other one is being encoded.
+     * @param numPresets the size of a batch, 1 means sending every preset on its own
+     */
+    void setAnalysisBatchSize(int numPresets);
+
+    /*!
+     * Sets the time the library analysis may spend on rendering one preset, see RenderPool::setTimeBudget.
+     * @param timeBudgetMs the time budget in milliseconds, 0 means no limit
+     */
+    void setRenderTimeBudget(int timeBudgetMs);
+
+    /*!
+     * Chooses between the TCP connection and the UDP messages for sending audio buffers,
+     * the shared memory is preferred over both when it's available. The initial choice
+     * comes from the environment variable IDEATOR_AUDIO_TRANSPORT ("stream" or "udp").
+     * @param shouldUseStream true to use the TCP connection, the UDP messages are still used when it fails
+     */
+    void setStreamTransportEnabled(bool shouldUseStream);
+
+    /*!
+     * Loads the encoder exported by export_encoder.py, so the presets are encoded in the host and
+     * only their latent features are sent to the back-end. The default file is loaded on construction
+     * if it exists.
+     * @param file the exported encoder
+     * @return false if the file cannot be loaded, the previous encoder is kept then
+     */
+    bool loadLatentEncoder(const juce::File &file);
+
+    /*!
+     * Sets how the presets are rendered, it affects the following renderings.
+     * @param spec the render spec
+     */
+    void setRenderSpec(const RenderSpec &spec);
+    const RenderSpec& getRenderSpec() const;
+
+    /*!
+     * Checks if a library analysis started by analyzeLibrary is still running.
+     * @return true if some presets have not been analyzed
+     */
+    bool isAnalyzingLibrary() const;
+
+    /*!
+     * Returns the presets of the last library analysis that could not be rendered.
+     * @return the paths to the presets
+     */
+    const std::unordered_set<juce::String>& getFailedPresetPaths() const;
+
+    /*!
+     * Returns the presets of the last library analysis that the back-end has analyzed.
+     * @return the paths to the presets
+     */
+    const juce::StringArray& getAnalyzedPresetPaths() const;
+
+    /*!
+     * Sets the library that findSimilar searches in the host. Its LatentIndex is loaded, and the one
+     * of the previous library is saved. The presets get into the index when they are analyzed with
+     * the encoder, findSimilar asks the back-end until all of them are, see setLibraryPresets.
+     * @param libraryDir the directory of the library
+     */
+    void setLibraryDirectory(const juce::File &libraryDir);
+
+    /*!
+     * Sets the presets that a scan has found in the library. findSimilar only searches in the host
+     * if every one of them is in the LatentIndex, with the latent features of the current encoder,
+     * otherwise the closest presets could be among the ones the host doesn't know. The presets that
+     * have failed to render are left out until they are analyzed.
+     * @param presetPaths the presets that can be parsed, none if the scan has been cancelled
+     * @param outdatedPresetPaths the ones that have been added or changed since they were analyzed,
+     *                            their latent features are dropped
+     */
+    void setLibraryPresets(const juce::StringArray &presetPaths, const juce::StringArray &outdatedPresetPaths);
+
+    /*!
+     * Returns the presets that the last findSimilar has found in the host.
+     * @return the paths to the presets, the closest first
+     */
+    const juce::StringArray& getSimilarPresetPaths() const;
+
+    // broadcasts when a library analysis has finished, other classes should only call addListener
+    juce::ChangeBroadcaster libraryAnalyzedBroadcaster;
+    // broadcasts when findSimilar has found the presets in the host, other classes should only call addListener
+    juce::ChangeBroadcaster similarPresetsFoundBroadcaster;
+
 protected:
     std::unique_ptr<juce::AudioPluginInstance> plugin;
+    // a second instance of the same plugin for the offline rendering, so the one that is
+    // used by the audio callback is never reconfigured
+    std::unique_ptr<juce::AudioPluginInstance> offlinePlugin;
+    PluginInstancePool warmPlugins;
     juce::MidiBuffer midiBuffer;
 
     // NOTE: the values of these two variables are hard-coded in the constructor
@@ -57,22 +166,93 @@ protected:
     int internSamplesPerBlock;
 
     juce::AudioBuffer<float> presetAudio; // audio buffer for saving the rendered audio
+    std::vector<float> presetFeatures; // the log-mel spectrogram of presetAudio
+    std::vector<float> presetLatent;   // the latent features of presetFeatures
+    MelSpectrogram melSpectrogram;
+    LatentEncoder latentEncoder;
+    RenderSpec renderSpec;
+    RenderCache renderCache;
 
     // extra states
-    std::unordered_set<juce::String> timbreDescriptors;
+    DescriptorSet timbreDescriptors;
     juce::String presetPath; // empty string means the preset has not been saved
     juce::String pluginPath;
 
 private:
     void resetWhenParameterChanged();
+    void updatePresetAudio();
+    bool prepareOfflinePlugin();
     void audioProcessorParameterChanged (juce::AudioProcessor *processor, int parameterIndex, float newValue) override;
     void audioProcessorChanged (juce::AudioProcessor *processor, const ChangeDetails& details) override;
 
     void changeListenerCallback (juce::ChangeBroadcaster *source) override;
-    bool analyzeNextPresetInLibrary();
+    // gives up the presets whose replies haven't arrived in time
+    void timerCallback() override;
+    void fillAnalysisWindow();
+    void addToAnalysisBatch(const RenderPool::Result &result, int sequenceNumber);
+    void sendAnalysisBatch();
+    void finishAnalyzingPreset(int sequenceNumber);
+    void sendBuffer(const float* data, int size, int id);
+    BufferContent updatePresetFeatures();
+    void sendPresetBuffer(BufferContent content, int id);
+    // true if the LatentIndex has every preset of the library, see setLibraryPresets
+    bool isLibraryIndexed() const;
+    // these keep numLibraryPresetsIndexed up to date
+    void addToLatentIndex(const juce::String &presetPath, const float* latent, int size);
+    bool removeFromLatentIndex(const juce::String &presetPath);
+    void excludeFromLatentIndex(const juce::String &presetPath);
+    void countIndexedLibraryPresets();
+    void findSimilarInLibrary();
+    void saveLatentIndex();
 
     juce::Array<juce::String> presetPathsInLibrary;
-    int numPresetAnalyzed;
+    int numPresetSent;     // also the index of the next preset in the render pool
+    int numPresetAnalyzed; // including the presets that have been skipped
+    // the id of the next buffer that is sent to the back-end, it's never reset
+    int nextBufferId;
+    // the presets that have been sent to the back-end and haven't been replied to, by sequence number
+    struct PresetInFlight
+    {
+        juce::String presetPath;
+        juce::uint32 sentTime;
+    };
+    std::map<int, PresetInFlight> presetsInFlight;
+    std::unordered_set<juce::String> failedPresetPaths;
+    juce::StringArray analyzedPresetPaths;
+    int analysisWindowSize;
+    int analysisBatchSize;
+
+    // the presets that have been rendered but not sent yet, their buffers are concatenated
+    struct AnalysisBatch
+    {
+        BufferContent content = BufferContent::audio;
+        juce::Array<int> sequenceNumbers;
+        juce::StringArray presetPaths;
+        juce::StringArray descriptorStrings;
+        std::vector<float> buffer;
+        int messageSize = 0;
+    };
+    AnalysisBatch analysisBatch;
+    // the replies to a batch come by preset path
+    std::unordered_map<juce::String, int> batchedSequenceNumbers;
+    int renderTimeBudgetMs;
+    std::unique_ptr<RenderPool> renderPool;
+    SharedMemoryTransport sharedMemoryTransport;
+    StreamTransport streamTransport;
+    bool isStreamTransportEnabled;
+
+    // the latent features of the analyzed presets of the library
+    LatentIndex latentIndex;
+    juce::File libraryDirectory;
+    // the presets the last scan has found, see setLibraryPresets
+    std::unordered_set<juce::String> libraryPresets;
+    // the presets of the library that cannot be analyzed, they aren't expected in the index
+    std::unordered_set<juce::String> excludedPresetPaths;
+    // the number of presets of the library that are in the index, so isLibraryIndexed doesn't look them up
+    int numLibraryPresetsIndexed;
+    // the latent features of the silent presets, computed once per analysis
+    std::vector<float> silenceLatent;
+    juce::StringArray similarPresetPaths;
 
     OSCManager* oscManager;
 };
\ No newline at end of file
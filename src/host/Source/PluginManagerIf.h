@@ -10,7 +10,6 @@
 
 #pragma once
 #include <JuceHeader.h>
-#include <unordered_set>
 #include "Utils.h"
 
 class PluginManagerIf
@@ -70,8 +69,9 @@ public:
 
     /*!
      * Renders the audio by using the current synth setting and save it into the buffer.
+     * @return false if the plugin could not render, the buffer is silent then
      */
-    virtual void renderAudio() = 0;
+    virtual bool renderAudio() = 0;
 
     /*!
      * Saves the current preset sound as an audio file.
@@ -101,15 +101,15 @@ public:
 
     /*!
      * Sets the timbre descriptors.
-     * @param timbreDescriptors an unordered_set of descriptors
+     * @param timbreDescriptors the descriptors
      */
-    virtual void setTimbreDescriptors(const std::unordered_set<juce::String> &timbreDescriptors) = 0;
+    virtual void setTimbreDescriptors(const DescriptorSet &timbreDescriptors) = 0;
 
     /*!
      * Returns the timbre descriptors of the current preset.
-     * @return an unordered_set of descriptors
+     * @return the descriptors
      */
-    virtual const std::unordered_set<juce::String>& getTimbreDescriptors() const = 0;
+    virtual const DescriptorSet& getTimbreDescriptors() const = 0;
 
     /*!
      * Sets the path to the current preset.
@@ -153,6 +153,6 @@ public:
      * @return
      */
     virtual bool changeDescriptors(const juce::String &presetPath,
-                                   const std::unordered_set<juce::String> &newDescriptors) = 0;
+                                   const DescriptorSet &newDescriptors) = 0;
 };
 
@@ -153,9 +153,8 @@ void PluginProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::Midi
 
     if (plugin)
     {
-        // not to process if audio rendering is happening in the plugin manager
-        if (plugin->isNonRealtime())
-            return;
+        // The offline rendering happens on other instances of the plugin, so this
+        // instance is always ready for the audio callback.
 
         // only process the internal midi buffer when the incoming midi buffer is empty
         if (midiMessages.isEmpty())
@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    PresetCache.cpp
+    Created: 17 Oct 2026 8:02:06pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#include "PresetCache.h"
+#include "Config.h"
+#include "Utils.h"
+
+PresetCache& PresetCache::getInstance()
+{
+    static PresetCache instance;
+    return instance;
+}
+
+PresetCache::PresetCache():
+        maxNumBytes(PRESET_CACHE_MAX_SIZE_MB * 1024 * 1024)
+{
+}
+
+PresetCache::PresetPtr PresetCache::get(const juce::String &presetPath)
+{
+    const juce::File file(presetPath);
+    const auto fileSize = file.getSize();
+    const auto modificationTime = file.getLastModificationTime().toMilliseconds();
+
+    {
+        const juce::ScopedLock sl(lock);
+        auto it = entryMap.find(presetPath);
+        if (it != entryMap.end())
+        {
+            auto entry = it->second;
+            if (entry->fileSize == fileSize && entry->modificationTime == modificationTime)
+            {
+                entries.splice(entries.begin(), entries, entry);
+                return entry->preset;
+            }
+
+            numBytes -= entry->numBytes;
+            entries.erase(entry);
+            entryMap.erase(it);
+        }
+    }
+
+    // the file is parsed without holding the lock, so the other threads aren't blocked by it
+    auto preset = std::make_shared<Preset>();
+    if (!PresetManager::parse(file, preset->parameters, preset->pluginPath, preset->descriptors))
+        return nullptr;
+
+    Entry newEntry;
+    newEntry.presetPath = presetPath;
+    newEntry.preset = preset;
+    newEntry.fileSize = fileSize;
+    newEntry.modificationTime = modificationTime;
+    newEntry.numBytes = estimateSize(presetPath, *preset);
+
+    const juce::ScopedLock sl(lock);
+    // another thread may have parsed the same file in the meantime
+    auto it = entryMap.find(presetPath);
+    if (it != entryMap.end())
+    {
+        numBytes -= it->second->numBytes;
+        entries.erase(it->second);
+        entryMap.erase(it);
+    }
+
+    numBytes += newEntry.numBytes;
+    entries.push_front(std::move(newEntry));
+    entryMap[presetPath] = entries.begin();
+    trim();
+
+    return preset;
+}
+
+void PresetCache::remove(const juce::String &presetPath)
+{
+    const juce::ScopedLock sl(lock);
+    auto it = entryMap.find(presetPath);
+    if (it == entryMap.end())
+        return;
+
+    numBytes -= it->second->numBytes;
+    entries.erase(it->second);
+    entryMap.erase(it);
+}
+
+void PresetCache::clear()
+{
+    const juce::ScopedLock sl(lock);
+    entries.clear();
+    entryMap.clear();
+    numBytes = 0;
+}
+
+void PresetCache::setMaxSize(juce::int64 newMaxNumBytes)
+{
+    const juce::ScopedLock sl(lock);
+    maxNumBytes = juce::jmax((juce::int64) 0, newMaxNumBytes);
+    trim();
+}
+
+juce::int64 PresetCache::estimateSize(const juce::String &presetPath, const Preset &preset)
+{
+    // the list and map nodes are only estimated, the parameters take most of the space
+    juce::int64 size = sizeof(Entry) + sizeof(Preset) + 2 * sizeof(void*) * 4;
+    size += presetPath.getNumBytesAsUTF8() + preset.pluginPath.getNumBytesAsUTF8();
+    size += static_cast<juce::int64>(preset.parameters.capacity() * sizeof(float));
+    return size;
+}
+
+void PresetCache::trim()
+{
+    // the most recent entry is always kept, even if it alone is larger than the limit
+    while (entries.size() > 1 && numBytes > maxNumBytes)
+    {
+        numBytes -= entries.back().numBytes;
+        entryMap.erase(entries.back().presetPath);
+        entries.pop_back();
+    }
+}
@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    PresetCache.h
+    Created: 17 Oct 2026 8:02:06pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <unordered_map>
+#include <vector>
+#include <list>
+#include <memory>
+#include "DescriptorRegistry.h"
+
+// Keeps the presets that have been parsed, so showing search results, undoing and loading a
+// preset don't parse the same files again. An entry is parsed again when the size or the
+// modification time of its file has changed. The least recently used entries are dropped
+// once the cache gets too large. There is one cache per process, it's safe to use from several threads.
+class PresetCache
+{
+public:
+    struct Preset
+    {
+        juce::String pluginPath;
+        DescriptorSet descriptors;
+        std::vector<float> parameters;
+    };
+
+    // the entries are immutable, so a preset stays valid after it has been dropped or parsed again
+    using PresetPtr = std::shared_ptr<const Preset>;
+
+    static PresetCache& getInstance();
+
+    /*!
+     * Gets a preset, it's parsed if it's not in the cache or its file has changed.
+     * @param presetPath the full path to the preset
+     * @return the preset, nullptr if the file cannot be parsed
+     */
+    PresetPtr get(const juce::String &presetPath);
+
+    // should be called after writing a preset, in case its size and modification time haven't changed
+    void remove(const juce::String &presetPath);
+
+    void clear();
+
+    /*!
+     * @param maxNumBytes the estimated memory the entries may take, the least recently used ones are dropped beyond it
+     */
+    void setMaxSize(juce::int64 maxNumBytes);
+
+private:
+    struct Entry
+    {
+        juce::String presetPath;
+        PresetPtr preset;
+        juce::int64 fileSize = 0;
+        juce::int64 modificationTime = 0;
+        juce::int64 numBytes = 0;
+    };
+
+    PresetCache();
+
+    static juce::int64 estimateSize(const juce::String &presetPath, const Preset &preset);
+    // the caller has to hold the lock
+    void trim();
+
+    juce::CriticalSection lock;
+    std::list<Entry> entries; // the most recently used entry is at the front
+    std::unordered_map<juce::String, std::list<Entry>::iterator> entryMap;
+    juce::int64 numBytes = 0;
+    juce::int64 maxNumBytes;
+
+    JUCE_DECLARE_NON_COPYABLE (PresetCache)
+};
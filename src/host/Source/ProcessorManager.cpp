@@ -82,9 +82,9 @@ void ProcessorManager::setPluginParameter(int parameterIndex, float newValue)
     audioProcessor.setPluginParameter(parameterIndex, newValue);
 }
 
-void ProcessorManager::renderAudio()
+bool ProcessorManager::renderAudio()
 {
-    audioProcessor.renderAudio();
+    return audioProcessor.renderAudio();
 }
 
 bool ProcessorManager::saveAudio(const juce::String &audioPath)
@@ -107,12 +107,12 @@ bool ProcessorManager::savePreset(const juce::String &presetPath)
     return audioProcessor.savePreset(presetPath);
 }
 
-void ProcessorManager::setTimbreDescriptors(const std::unordered_set<juce::String> &timbreDescriptors)
+void ProcessorManager::setTimbreDescriptors(const DescriptorSet &timbreDescriptors)
 {
     audioProcessor.setTimbreDescriptors(timbreDescriptors);
 }
 
-const std::unordered_set<juce::String>& ProcessorManager::getTimbreDescriptors() const
+const DescriptorSet& ProcessorManager::getTimbreDescriptors() const
 {
     return audioProcessor.getTimbreDescriptors();
 }
@@ -148,7 +148,38 @@ bool ProcessorManager::autoTag()
 }
 
 bool ProcessorManager::changeDescriptors(const juce::String &presetPath,
-                                         const std::unordered_set<juce::String> &newDescriptors)
+                                         const DescriptorSet &newDescriptors)
 {
     return audioProcessor.changeDescriptors(presetPath, newDescriptors);
+}
+
+juce::ChangeBroadcaster& ProcessorManager::getLibraryAnalyzedBroadcaster()
+{
+    return audioProcessor.libraryAnalyzedBroadcaster;
+}
+
+const juce::StringArray& ProcessorManager::getAnalyzedPresetPaths() const
+{
+    return audioProcessor.getAnalyzedPresetPaths();
+}
+
+void ProcessorManager::setLibraryDirectory(const juce::File &libraryDir)
+{
+    audioProcessor.setLibraryDirectory(libraryDir);
+}
+
+void ProcessorManager::setLibraryPresets(const juce::StringArray &presetPaths,
+                                         const juce::StringArray &outdatedPresetPaths)
+{
+    audioProcessor.setLibraryPresets(presetPaths, outdatedPresetPaths);
+}
+
+juce::ChangeBroadcaster& ProcessorManager::getSimilarPresetsFoundBroadcaster()
+{
+    return audioProcessor.similarPresetsFoundBroadcaster;
+}
+
+const juce::StringArray& ProcessorManager::getSimilarPresetPaths() const
+{
+    return audioProcessor.getSimilarPresetPaths();
 }
\ No newline at end of file
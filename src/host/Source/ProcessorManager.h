@@ -41,13 +41,13 @@ public:
     juce::PluginDescription getPluginDescription() const override;
     const juce::Array<juce::AudioProcessorParameter*>& getPluginParameters() const override;
     void setPluginParameter(int parameterIndex, float newValue) override;
-    void renderAudio() override;
+    bool renderAudio() override;
     bool saveAudio(const juce::String &audioPath) override;
     void sendAudio() override;
     bool loadPreset(const juce::String &presetPath) override;
     bool savePreset(const juce::String &presetPath) override;
-    void setTimbreDescriptors(const std::unordered_set<juce::String> &timbreDescriptors) override;
-    const std::unordered_set<juce::String>& getTimbreDescriptors() const override;
+    void setTimbreDescriptors(const DescriptorSet &timbreDescriptors) override;
+    const DescriptorSet& getTimbreDescriptors() const override;
     void setPresetPath(const juce::String &path) override;
     const juce::String& getPresetPath() const override;
     bool analyzeLibrary(const juce::Array<juce::String>& presetPaths) override;
@@ -55,7 +55,18 @@ public:
     void findSimilar() override;
     bool autoTag() override;
     bool changeDescriptors(const juce::String &presetPath,
-                           const std::unordered_set<juce::String> &newDescriptors) override;
+                           const DescriptorSet &newDescriptors) override;
+
+    // see PluginManager::libraryAnalyzedBroadcaster and PluginManager::getAnalyzedPresetPaths
+    juce::ChangeBroadcaster& getLibraryAnalyzedBroadcaster();
+    const juce::StringArray& getAnalyzedPresetPaths() const;
+
+    // see PluginManager::setLibraryDirectory, PluginManager::setLibraryPresets,
+    // PluginManager::similarPresetsFoundBroadcaster and PluginManager::getSimilarPresetPaths
+    void setLibraryDirectory(const juce::File &libraryDir);
+    void setLibraryPresets(const juce::StringArray &presetPaths, const juce::StringArray &outdatedPresetPaths);
+    juce::ChangeBroadcaster& getSimilarPresetsFoundBroadcaster();
+    const juce::StringArray& getSimilarPresetPaths() const;
 
 private:
 #ifdef IDEATOR_APP
@@ -0,0 +1,204 @@
+/*
+  ==============================================================================
+
+    RenderCache.cpp
+    Created: 17 Oct 2026 7:26:46pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#include "RenderCache.h"
+#include <algorithm>
+
+// The layout of the header of an entry file, it's followed by the samples of every channel.
+struct RenderCacheHeader
+{
+    char magic[4];
+    juce::int32 version;
+    juce::int32 numChannels;
+    juce::int32 numSamples;
+    double sampleRate;
+};
+
+static const char renderCacheMagic[4] = {'I', 'D', 'R', 'C'};
+// Bump it whenever the rendering changes, the entries of another version are never loaded.
+// 2: the note-on isn't repeated, the note-off is sample-accurate, the silent presets are heard to the note-off
+static const juce::int32 renderCacheVersion = 2;
+
+// 64-bit FNV-1a, two of them with different offset bases form the 128-bit key
+class KeyHasher
+{
+public:
+    void add(const void *data, size_t numBytes)
+    {
+        auto bytes = static_cast<const juce::uint8*>(data);
+        for (size_t i = 0; i < numBytes; ++i)
+        {
+            hashA = (hashA ^ bytes[i]) * prime;
+            hashB = (hashB ^ bytes[i]) * prime;
+        }
+    }
+
+    void add(const juce::String &string)
+    {
+        add(string.toRawUTF8(), string.getNumBytesAsUTF8() + 1);
+    }
+
+    template <typename T>
+    void addValue(T value)
+    {
+        add(&value, sizeof(T));
+    }
+
+    juce::String toString() const
+    {
+        return juce::String::toHexString((juce::int64) hashA).paddedLeft('0', 16)
+               + juce::String::toHexString((juce::int64) hashB).paddedLeft('0', 16);
+    }
+
+private:
+    static constexpr juce::uint64 prime = 0x100000001b3ULL;
+    juce::uint64 hashA = 0xcbf29ce484222325ULL;
+    juce::uint64 hashB = 0x84222325cbf29ce4ULL;
+};
+
+RenderCache::RenderCache(juce::File directory):
+        directory(std::move(directory))
+{
+}
+
+juce::String RenderCache::computeKey(const juce::AudioPluginInstance &instance,
+                                     const juce::String &pluginPath,
+                                     const RenderSpec &spec)
+{
+    KeyHasher hasher;
+    // the entries of an older version get other names, so they are trimmed instead of being overwritten
+    hasher.addValue(renderCacheVersion);
+    hasher.add(pluginPath);
+    hasher.add(instance.getPluginDescription().version);
+
+    const auto &parameters = instance.getParameters();
+    hasher.addValue(parameters.size());
+    for (auto *parameter : parameters)
+        hasher.addValue(parameter->getValue());
+
+    hasher.addValue(spec.sampleRate);
+    // some plugins sound different at other block sizes, which is what --block-size is for
+    hasher.addValue(spec.blockSize);
+    hasher.addValue(spec.audioLength);
+    hasher.addValue(spec.noteLength);
+    hasher.addValue(spec.midiNote);
+    hasher.addValue(spec.midiVelocity);
+    hasher.addValue(spec.stopOnSilence);
+    hasher.addValue(spec.silenceThreshold);
+    hasher.addValue(spec.silenceHoldTime);
+    hasher.addValue(spec.silentPresetHoldTime);
+
+    return hasher.toString();
+}
+
+bool RenderCache::load(const juce::String &key, juce::AudioBuffer<float> &buffer) const
+{
+    auto entryFile = getEntryFile(key);
+    if (!entryFile.existsAsFile())
+        return false;
+
+    juce::MemoryMappedFile mappedFile(entryFile, juce::MemoryMappedFile::readOnly);
+    if (mappedFile.getData() == nullptr || mappedFile.getSize() < sizeof(RenderCacheHeader))
+        return false;
+
+    auto header = static_cast<const RenderCacheHeader*>(mappedFile.getData());
+    if (memcmp(header->magic, renderCacheMagic, sizeof(renderCacheMagic)) != 0
+        || header->version != renderCacheVersion
+        || header->numChannels < 0
+        || header->numSamples < 0)
+        return false;
+
+    const size_t numChannelBytes = sizeof(float) * (size_t) header->numSamples;
+    if (mappedFile.getSize() != sizeof(RenderCacheHeader) + numChannelBytes * (size_t) header->numChannels)
+        return false;
+
+    auto samples = reinterpret_cast<const float*>(header + 1);
+    buffer.setSize(header->numChannels, header->numSamples, false, false, true);
+    for (int i = 0; i < header->numChannels; ++i)
+        juce::FloatVectorOperations::copy(buffer.getWritePointer(i),
+                                          samples + (size_t) i * (size_t) header->numSamples,
+                                          header->numSamples);
+
+    // the access time decides which entries are removed first when the cache is trimmed
+    entryFile.setLastAccessTime(juce::Time::getCurrentTime());
+    return true;
+}
+
+bool RenderCache::store(const juce::String &key, const juce::AudioBuffer<float> &buffer, double sampleRate) const
+{
+    if (!directory.createDirectory().wasOk())
+        return false;
+
+    RenderCacheHeader header {};
+    memcpy(header.magic, renderCacheMagic, sizeof(renderCacheMagic));
+    header.version = renderCacheVersion;
+    header.numChannels = buffer.getNumChannels();
+    header.numSamples = buffer.getNumSamples();
+    header.sampleRate = sampleRate;
+
+    // write to a temporary file first, so the other threads never see a partial entry
+    auto entryFile = getEntryFile(key);
+    juce::TemporaryFile temporaryFile(entryFile);
+    {
+        juce::FileOutputStream outputStream(temporaryFile.getFile());
+        if (outputStream.failedToOpen())
+            return false;
+
+        outputStream.write(&header, sizeof(header));
+        for (int i = 0; i < buffer.getNumChannels(); ++i)
+            outputStream.write(buffer.getReadPointer(i), sizeof(float) * (size_t) buffer.getNumSamples());
+
+        outputStream.flush();
+        if (outputStream.getStatus().failed())
+            return false;
+    }
+
+    return temporaryFile.overwriteTargetFileWithTemporary();
+}
+
+void RenderCache::trim(juce::int64 maxNumBytes) const
+{
+    auto entryFiles = directory.findChildFiles(juce::File::TypesOfFileToFind::findFiles, false, "*.render");
+
+    juce::int64 totalNumBytes = 0;
+    for (const auto &file : entryFiles)
+        totalNumBytes += file.getSize();
+
+    if (totalNumBytes <= maxNumBytes)
+        return;
+
+    // remove the least recently used entries first
+    std::sort(entryFiles.begin(), entryFiles.end(), [] (const juce::File &a, const juce::File &b)
+    {
+        return a.getLastAccessTime() < b.getLastAccessTime();
+    });
+
+    for (const auto &file : entryFiles)
+    {
+        if (totalNumBytes <= maxNumBytes)
+            break;
+
+        const auto fileSize = file.getSize();
+        if (file.deleteFile())
+            totalNumBytes -= fileSize;
+    }
+}
+
+juce::File RenderCache::getDefaultDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+            .getChildFile("Ideator")
+            .getChildFile("RenderCache");
+}
+
+juce::File RenderCache::getEntryFile(const juce::String &key) const
+{
+    return directory.getChildFile(key + ".render");
+}
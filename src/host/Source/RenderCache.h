@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    RenderCache.h
+    Created: 17 Oct 2026 7:26:46pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+
+// Keeps rendered audio on disk. Every entry is addressed by a hash of everything that
+// affects the rendering (plugin, plugin version, parameter values and render spec), so an
+// entry never needs to be invalidated. It's safe to use the cache from several threads.
+class RenderCache
+{
+public:
+    explicit RenderCache(juce::File directory = getDefaultDirectory());
+
+    /*!
+     * Computes the key of the sound that the instance would render with its current parameters.
+     * @param instance the plugin instance
+     * @param pluginPath the path to the plugin of the instance
+     * @param spec the render spec
+     * @return the key
+     */
+    static juce::String computeKey(const juce::AudioPluginInstance &instance,
+                                   const juce::String &pluginPath,
+                                   const RenderSpec &spec);
+
+    /*!
+     * Reads an entry by memory-mapping its file.
+     * @param key the key of the entry
+     * @param buffer receives the audio, it will be resized
+     * @return false if there is no such entry
+     */
+    bool load(const juce::String &key, juce::AudioBuffer<float> &buffer) const;
+
+    /*!
+     * Writes an entry, an existing entry with the same key will be replaced.
+     * @param key the key of the entry
+     * @param buffer the rendered audio
+     * @param sampleRate the sample rate of the audio
+     * @return true if the entry has been written
+     */
+    bool store(const juce::String &key, const juce::AudioBuffer<float> &buffer, double sampleRate) const;
+
+    /*!
+     * Removes the least recently used entries until the cache fits into the size limit.
+     * @param maxNumBytes the size limit
+     */
+    void trim(juce::int64 maxNumBytes) const;
+
+    static juce::File getDefaultDirectory();
+
+private:
+    juce::File getEntryFile(const juce::String &key) const;
+
+    const juce::File directory;
+};
@@ -0,0 +1,455 @@
+/*
+  ==============================================================================
+
+    RenderPool.cpp
+    Created: 17 Oct 2026 7:24:30pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#include "RenderPool.h"
+#include "PluginLoader.h"
+#include "Utils.h"
+
+// ========================================
+// Worker
+// ========================================
+
+class RenderPool::Worker : public juce::Thread
+{
+public:
+    explicit Worker(RenderPool &pool):
+            juce::Thread("Ideator Render Worker"),
+            pool(pool),
+            renderCache(pool.renderCache)
+    {
+    }
+
+    ~Worker() override
+    {
+        // a worker is only deleted once it has returned, its thread is never killed under its instance
+        jassert (!isThreadRunning());
+    }
+
+    void run() override
+    {
+        // Everything a render needs is copied out of the pool first, so a worker that is
+        // abandoned in a plugin call doesn't touch the pool after it returns, the pool
+        // might be gone by then. The weights are shared, only the buffers are the worker's own.
+        renderSpec = pool.renderSpec;
+        timeBudgetMs = pool.timeBudgetMs;
+        latentEncoder = pool.latentEncoder;
+
+        // the spec might have been changed since the last job
+        if (instance)
+            OfflineRenderer::prepare(*instance, renderSpec);
+        if (threadShouldExit())
+            return;
+
+        int index;
+        while (pool.claimNextIndex(index, *this))
+        {
+            taskStartTime = juce::Time::getMillisecondCounter();
+            taskIndex = index;
+
+            auto result = renderPreset(index, pool.presetPaths[index]);
+
+            // The watchdog has taken the preset away, which means this worker has been
+            // replaced, so the instance that hung is dropped and the thread quits.
+            int expectedIndex = index;
+            if (!taskIndex.compare_exchange_strong(expectedIndex, -1))
+            {
+                instance.reset();
+                return;
+            }
+
+            pool.addResult(std::move(result));
+        }
+    }
+
+    /*!
+     * Takes the current preset away from the worker if the plugin has not returned for too long.
+     * @param timeoutMs the time after which the worker is considered hung, PLUGIN_LOAD_TIMEOUT_MS while it's loading the plugin
+     * @param index receives the index of the preset the worker hangs on
+     * @param elapsedMs receives the time that has been spent on the preset
+     * @param wasLoading receives whether the worker hangs on loading the plugin
+     * @return true if the worker has been abandoned
+     */
+    bool abandonIfHung(int timeoutMs, int &index, juce::uint32 &elapsedMs, bool &wasLoading)
+    {
+        // read the flag first, the start time is reset before the flag is cleared
+        wasLoading = isLoadingPlugin;
+        index = taskIndex;
+        elapsedMs = getElapsedTime();
+        if (wasLoading)
+            timeoutMs = PLUGIN_LOAD_TIMEOUT_MS;
+        if (index < 0 || elapsedMs < (juce::uint32) timeoutMs)
+            return false;
+
+        if (!taskIndex.compare_exchange_strong(index, -1))
+            return false;
+
+        signalThreadShouldExit();
+        return true;
+    }
+
+    /*!
+     * Takes the current preset away from the worker, if it has one, and tells it to quit.
+     * Used when the worker doesn't stop in time, because it hangs in a plugin call.
+     */
+    void abandon()
+    {
+        taskIndex = -1;
+        signalThreadShouldExit();
+    }
+
+private:
+    juce::uint32 getElapsedTime() const
+    {
+        return juce::Time::getMillisecondCounter() - taskStartTime;
+    }
+
+    bool isWithinTimeBudget() const
+    {
+        return timeBudgetMs <= 0 || getElapsedTime() < (juce::uint32) timeBudgetMs;
+    }
+
+    Result renderPreset(int index, const juce::String &presetPath)
+    {
+        Result result;
+        result.index = index;
+        result.presetPath = presetPath;
+
+        juce::String pluginPath;
+        if (!PresetManager::parse(juce::File(result.presetPath), parameters, pluginPath, result.descriptors))
+        {
+            result.failed = true;
+            result.errorMessage = "Cannot parse the preset";
+            return result;
+        }
+
+        // every worker keeps its instance until it meets a preset of another plugin
+        if (!instance || pluginPath != instancePluginPath)
+        {
+            instance.reset();
+            instancePluginPath = "";
+
+            // loading a plugin can take a while, which shouldn't count against the preset,
+            // so the watchdog gives it PLUGIN_LOAD_TIMEOUT_MS instead of the time budget
+            taskStartTime = juce::Time::getMillisecondCounter();
+            isLoadingPlugin = true;
+
+            juce::String errorMessage;
+            instance = PluginLoader::createInstance(pluginPath,
+                                                    renderSpec.sampleRate,
+                                                    renderSpec.blockSize,
+                                                    errorMessage);
+            if (instance)
+                OfflineRenderer::prepare(*instance, renderSpec);
+
+            taskStartTime = juce::Time::getMillisecondCounter();
+            isLoadingPlugin = false;
+
+            if (!instance)
+            {
+                result.failed = true;
+                result.errorMessage = errorMessage;
+                return result;
+            }
+
+            instancePluginPath = pluginPath;
+        }
+
+        // clear the internal buffer, otherwise there would be a tail from the previous sound
+        instance->reset();
+        const auto &instanceParameters = instance->getParameters();
+        for (size_t i = 0; i < parameters.size(); ++i)
+            if (auto *param = instanceParameters[static_cast<int>(i)])
+                param->setValue(parameters[i]);
+
+        // an unchanged preset is loaded from the cache instead of being rendered again
+        auto cacheKey = RenderCache::computeKey(*instance, pluginPath, renderSpec);
+        if (!renderCache.load(cacheKey, result.audio))
+        {
+            const bool isRendered = OfflineRenderer::render(*instance,
+                                                            renderSpec,
+                                                            result.audio,
+                                                            [this] {
+                                                                return isWithinTimeBudget()
+                                                                       && taskIndex >= 0
+                                                                       && !threadShouldExit();
+                                                            });
+            if (!isRendered)
+            {
+                // the instance might be left in a bad state, so the next preset gets a new one
+                instance.reset();
+                instancePluginPath = "";
+
+                result.failed = true;
+                result.errorMessage = threadShouldExit() ?
+                                      "Rendering has been cancelled" :
+                                      "Rendering took longer than the time budget ("
+                                      + juce::String(getElapsedTime()) + " ms, budget "
+                                      + juce::String(timeBudgetMs) + " ms)";
+                result.audio.setSize(0, 0);
+                return result;
+            }
+
+            renderCache.store(cacheKey, result.audio, renderSpec.sampleRate);
+        }
+
+        result.silent = OfflineRenderer::isSilent(result.audio, renderSpec);
+
+        // the features are computed here, so the workers share the work
+        if (SEND_MEL_SPECTROGRAM && !result.silent && result.audio.getNumChannels() > 0
+            && !melSpectrogram.compute(result.audio.getReadPointer(0),
+                                       result.audio.getNumSamples(),
+                                       renderSpec.sampleRate,
+                                       result.features))
+            result.features.clear();
+
+        if (!result.features.empty() && latentEncoder.isLoaded())
+            latentEncoder.encode(result.features.data(), static_cast<int>(result.features.size()), result.latent);
+
+        return result;
+    }
+
+    RenderPool &pool;
+    // the worker's copies of the job, see run()
+    RenderSpec renderSpec;
+    int timeBudgetMs = 0;
+    const RenderCache renderCache;
+    std::unique_ptr<juce::AudioPluginInstance> instance;
+    juce::String instancePluginPath;
+    MelSpectrogram melSpectrogram;
+    LatentEncoder latentEncoder;
+    // the parameters of the preset, reused so parsing doesn't allocate
+    std::vector<float> parameters;
+
+    // the index of the preset that is being rendered, -1 if the worker is idle
+    std::atomic<int> taskIndex { -1 };
+    std::atomic<juce::uint32> taskStartTime { 0 };
+    std::atomic<bool> isLoadingPlugin { false };
+};
+
+// ========================================
+// Watchdog
+// ========================================
+
+class RenderPool::Watchdog : public juce::Thread
+{
+public:
+    explicit Watchdog(RenderPool &pool):
+            juce::Thread("Ideator Render Watchdog"),
+            pool(pool)
+    {
+    }
+
+    ~Watchdog() override
+    {
+        stopThread(1000);
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            pool.checkWorkers();
+            wait(200);
+        }
+    }
+
+private:
+    RenderPool &pool;
+};
+
+// ========================================
+// RenderPool
+// ========================================
+
+static int getNumWorkersToCreate(int numWorkers)
+{
+    // leave one core for the GUI and the audio callback
+    return numWorkers > 0 ? numWorkers : juce::jmax(1, juce::SystemStats::getNumCpus() - 1);
+}
+
+RenderPool::RenderPool(int numWorkers):
+        maxPendingResults(getNumWorkersToCreate(numWorkers) * 2),
+        timeBudgetMs(RENDER_TIME_BUDGET_MS),
+        nextIndex(0),
+        numPopped(0)
+{
+    for (int i = 0; i < getNumWorkersToCreate(numWorkers); ++i)
+        workers.add(new Worker(*this));
+    watchdog = std::make_unique<Watchdog>(*this);
+}
+
+RenderPool::~RenderPool()
+{
+    stop();
+
+    // Killing a worker that still hangs in a plugin call would destroy its instance under it,
+    // so it is left running and leaked instead. It doesn't touch the pool once it returns.
+    const juce::ScopedLock sl(workersLock);
+    for (int i = abandonedWorkers.size(); --i >= 0;)
+    {
+        if (abandonedWorkers[i]->isThreadRunning())
+        {
+            DBG("RenderPool::~RenderPool: a worker still hangs in a plugin call, it is leaked");
+            abandonedWorkers.removeObject(abandonedWorkers[i], false);
+        }
+    }
+    abandonedWorkers.clear();
+}
+
+void RenderPool::start(const juce::Array<juce::String> &presetPaths, const RenderSpec &spec)
+{
+    stop();
+
+    this->presetPaths = presetPaths;
+    renderSpec = spec;
+    nextIndex = 0;
+    numPopped = 0;
+    {
+        const juce::ScopedLock sl(resultLock);
+        results.clear();
+    }
+
+    {
+        const juce::ScopedLock sl(workersLock);
+        for (auto *worker : workers)
+            worker->startThread();
+    }
+
+    if (timeBudgetMs > 0)
+        watchdog->startThread();
+}
+
+void RenderPool::stop()
+{
+    watchdog->stopThread(1000);
+
+    const juce::ScopedLock sl(workersLock);
+    for (auto *worker : workers)
+        worker->signalThreadShouldExit();
+    slotFreed.signal();
+
+    // a worker that doesn't stop in time hangs in a plugin call, it is abandoned
+    // and replaced like a hung worker instead of being killed
+    for (int i = workers.size(); --i >= 0;)
+    {
+        if (workers[i]->waitForThreadToExit(4000))
+            continue;
+
+        workers[i]->abandon();
+        abandonedWorkers.add(workers.removeAndReturn(i));
+        workers.add(new Worker(*this));
+    }
+}
+
+bool RenderPool::popResult(int index, Result &result)
+{
+    {
+        const juce::ScopedLock sl(resultLock);
+        auto it = results.find(index);
+        if (it == results.end())
+            return false;
+        result = std::move(it->second);
+        results.erase(it);
+    }
+
+    {
+        const juce::ScopedLock sl(indexLock);
+        ++numPopped;
+    }
+    slotFreed.signal();
+    return true;
+}
+
+int RenderPool::getNumWorkers() const
+{
+    const juce::ScopedLock sl(workersLock);
+    return workers.size();
+}
+
+void RenderPool::setTimeBudget(int timeBudgetMs)
+{
+    this->timeBudgetMs = timeBudgetMs;
+}
+
+void RenderPool::setLatentEncoder(const LatentEncoder &encoder)
+{
+    latentEncoder = encoder;
+}
+
+bool RenderPool::claimNextIndex(int &index, juce::Thread &thread)
+{
+    while (!thread.threadShouldExit())
+    {
+        {
+            const juce::ScopedLock sl(indexLock);
+            if (nextIndex >= presetPaths.size())
+                return false;
+
+            // don't run too far ahead of the consumer, otherwise the rendered audio
+            // of a large library would pile up in memory
+            if (nextIndex - numPopped < maxPendingResults)
+            {
+                index = nextIndex++;
+                return true;
+            }
+        }
+        slotFreed.wait(50);
+    }
+
+    return false;
+}
+
+void RenderPool::addResult(Result &&result)
+{
+    {
+        const juce::ScopedLock sl(resultLock);
+        const int index = result.index;
+        results[index] = std::move(result);
+    }
+    resultReadyBroadcaster.sendChangeMessage();
+}
+
+void RenderPool::checkWorkers()
+{
+    const juce::ScopedLock sl(workersLock);
+
+    // the abandoned workers that have returned from the plugin can be deleted now
+    for (int i = abandonedWorkers.size(); --i >= 0;)
+        if (!abandonedWorkers[i]->isThreadRunning())
+            abandonedWorkers.remove(i);
+
+    // A render that goes over the budget is normally stopped by its worker between two blocks,
+    // so a worker is only considered hung once a single plugin call blocks for twice as long.
+    for (int i = workers.size(); --i >= 0;)
+    {
+        int index;
+        juce::uint32 elapsedMs;
+        bool wasLoading;
+        if (!workers[i]->abandonIfHung(timeBudgetMs * 2, index, elapsedMs, wasLoading))
+            continue;
+
+        Result result;
+        result.index = index;
+        result.presetPath = presetPaths[index];
+        result.failed = true;
+        result.errorMessage = wasLoading ?
+                              "The plugin took too long to load (" + juce::String(elapsedMs) + " ms)" :
+                              "The plugin stopped responding ("
+                              + juce::String(elapsedMs) + " ms, budget "
+                              + juce::String(timeBudgetMs) + " ms)";
+        addResult(std::move(result));
+
+        // the worker keeps its instance until the call returns, a new worker with
+        // a new instance takes its place
+        abandonedWorkers.add(workers.removeAndReturn(i));
+        auto *replacement = workers.add(new Worker(*this));
+        replacement->startThread();
+    }
+}
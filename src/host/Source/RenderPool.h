@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    RenderPool.h
+    Created: 17 Oct 2026 7:24:30pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <map>
+#include <atomic>
+#include "OfflineRenderer.h"
+#include "RenderCache.h"
+#include "MelSpectrogram.h"
+#include "LatentEncoder.h"
+#include "DescriptorRegistry.h"
+
+// Renders the presets of a library concurrently. Every worker thread owns its own instance
+// of the plugin, so the instance that is used by the GUI and the audio callback is never touched.
+// A watchdog makes sure that a preset or a plugin that hangs cannot stall the whole job.
+class RenderPool
+{
+public:
+    struct Result
+    {
+        int index = -1;
+        juce::String presetPath;
+        DescriptorSet descriptors;
+        juce::AudioBuffer<float> audio;
+        bool failed = false;
+        juce::String errorMessage;
+        // the preset doesn't make any sound, the audio is all zeros
+        bool silent = false;
+        // the log-mel spectrogram of the audio, empty if it cannot be computed
+        std::vector<float> features;
+        // the latent features of the log-mel spectrogram, empty if there is no encoder
+        std::vector<float> latent;
+    };
+
+    /*!
+     * @param numWorkers the number of worker threads (and plugin instances), 0 means one per spare CPU core
+     */
+    explicit RenderPool(int numWorkers = 0);
+    ~RenderPool();
+
+    /*!
+     * Starts rendering the presets in the background. Any running job will be stopped first.
+     * @param presetPaths the paths to the presets that need to be rendered
+     * @param spec the render spec
+     */
+    void start(const juce::Array<juce::String> &presetPaths, const RenderSpec &spec);
+
+    /*!
+     * Stops all the workers. The plugin instances are kept for the next job, except for those
+     * of the workers that don't stop in time, which are abandoned and replaced.
+     */
+    void stop();
+
+    /*!
+     * Takes the result of a preset out of the pool. Results should be taken in the order of
+     * their indices, because the workers will not run too far ahead of the consumer.
+     * @param index the index of the preset in the array passed to start()
+     * @param result receives the result
+     * @return false if the preset has not been rendered yet
+     */
+    bool popResult(int index, Result &result);
+
+    int getNumWorkers() const;
+
+    /*!
+     * Sets the time a worker may spend on one preset. A render that goes over it is stopped
+     * and the preset is marked as failed. A worker whose plugin doesn't return from a call for
+     * twice as long is abandoned together with its instance and replaced with a new one.
+     * Should be called before start().
+     * @param timeBudgetMs the time budget in milliseconds, 0 means no limit
+     */
+    void setTimeBudget(int timeBudgetMs);
+
+    /*!
+     * Lets the workers encode the log-mel spectrograms as well. Should be called before start().
+     * @param encoder a loaded encoder, or one that isn't loaded to leave the encoding to the back-end
+     */
+    void setLatentEncoder(const LatentEncoder &encoder);
+
+    // broadcasts once new results are available, other classes should only call addListener
+    juce::ChangeBroadcaster resultReadyBroadcaster;
+
+private:
+    class Worker;
+    class Watchdog;
+
+    bool claimNextIndex(int &index, juce::Thread &thread);
+    void addResult(Result &&result);
+    void checkWorkers();
+
+    juce::CriticalSection workersLock;
+    juce::OwnedArray<Worker> workers;
+    // the workers that hang in a plugin call, they are deleted once they return,
+    // the ones that still hang when the pool is destroyed are leaked
+    juce::OwnedArray<Worker> abandonedWorkers;
+    std::unique_ptr<Watchdog> watchdog;
+    const int maxPendingResults;
+    int timeBudgetMs;
+    LatentEncoder latentEncoder;
+    RenderCache renderCache;
+
+    // these two are only changed when the workers are stopped
+    juce::Array<juce::String> presetPaths;
+    RenderSpec renderSpec;
+
+    juce::CriticalSection indexLock;
+    int nextIndex;
+    int numPopped;
+    juce::WaitableEvent slotFreed;
+
+    juce::CriticalSection resultLock;
+    std::map<int, Result> results;
+
+    JUCE_DECLARE_NON_COPYABLE (RenderPool)
+};
@@ -0,0 +1,367 @@
+/*
+  ==============================================================================
+
+    RoaringBitmap.cpp
+    Created: 17 Oct 2026 8:08:28pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#include "RoaringBitmap.h"
+#include <algorithm>
+#include <iterator>
+
+// ========================================
+// Container
+// ========================================
+
+bool RoaringBitmap::Container::contains(juce::uint16 low) const
+{
+    if (isBitset())
+        return (bitset[low >> 6] >> (low & 63) & 1) != 0;
+    return std::binary_search(array.begin(), array.end(), low);
+}
+
+void RoaringBitmap::Container::add(juce::uint16 low)
+{
+    if (isBitset())
+    {
+        auto &word = bitset[low >> 6];
+        const auto bit = juce::uint64(1) << (low & 63);
+        if ((word & bit) == 0)
+        {
+            word |= bit;
+            ++cardinality;
+        }
+        return;
+    }
+
+    // appending is the common case
+    if (array.empty() || array.back() < low)
+        array.push_back(low);
+    else
+    {
+        auto it = std::lower_bound(array.begin(), array.end(), low);
+        if (*it == low)
+            return;
+        array.insert(it, low);
+    }
+    ++cardinality;
+
+    if (cardinality > maxArraySize)
+        toBitset();
+}
+
+void RoaringBitmap::Container::toBitset()
+{
+    if (isBitset())
+        return;
+
+    bitset.assign(bitsetNumWords, 0);
+    for (auto low : array)
+        bitset[low >> 6] |= juce::uint64(1) << (low & 63);
+    array.clear();
+    array.shrink_to_fit();
+}
+
+void RoaringBitmap::Container::shrink()
+{
+    if (!isBitset() || cardinality > maxArraySize)
+        return;
+
+    array.clear();
+    array.reserve(static_cast<size_t>(cardinality));
+    for (size_t i = 0; i < bitsetNumWords; ++i)
+        for (auto word = bitset[i]; word != 0; word &= word - 1)
+            array.push_back(static_cast<juce::uint16>(i * 64 + countTrailingZeros(word)));
+    bitset.clear();
+    bitset.shrink_to_fit();
+}
+
+RoaringBitmap::Container RoaringBitmap::intersect(const Container &a, const Container &b)
+{
+    Container result;
+    result.key = a.key;
+
+    if (a.isBitset() && b.isBitset())
+    {
+        result.bitset.resize(bitsetNumWords);
+        for (size_t i = 0; i < bitsetNumWords; ++i)
+        {
+            result.bitset[i] = a.bitset[i] & b.bitset[i];
+            result.cardinality += juce::countNumberOfBits(result.bitset[i]);
+        }
+        result.shrink();
+    }
+    else if (a.isBitset() || b.isBitset())
+    {
+        // the result is never larger than the array
+        const auto &arrayContainer = a.isBitset() ? b : a;
+        const auto &bitsetContainer = a.isBitset() ? a : b;
+        for (auto low : arrayContainer.array)
+            if (bitsetContainer.contains(low))
+                result.array.push_back(low);
+        result.cardinality = static_cast<int>(result.array.size());
+    }
+    else
+    {
+        std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                              std::back_inserter(result.array));
+        result.cardinality = static_cast<int>(result.array.size());
+    }
+    return result;
+}
+
+RoaringBitmap::Container RoaringBitmap::unite(const Container &a, const Container &b)
+{
+    Container result;
+    result.key = a.key;
+
+    if (!a.isBitset() && !b.isBitset() && a.cardinality + b.cardinality <= maxArraySize)
+    {
+        std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                       std::back_inserter(result.array));
+        result.cardinality = static_cast<int>(result.array.size());
+        return result;
+    }
+
+    result.bitset.assign(bitsetNumWords, 0);
+    for (const auto* container : { &a, &b })
+    {
+        if (container->isBitset())
+            for (size_t i = 0; i < bitsetNumWords; ++i)
+                result.bitset[i] |= container->bitset[i];
+        else
+            for (auto low : container->array)
+                result.bitset[low >> 6] |= juce::uint64(1) << (low & 63);
+    }
+    for (auto word : result.bitset)
+        result.cardinality += juce::countNumberOfBits(word);
+    result.shrink();
+    return result;
+}
+
+RoaringBitmap::Container RoaringBitmap::subtract(const Container &a, const Container &b)
+{
+    Container result;
+    result.key = a.key;
+
+    if (!a.isBitset())
+    {
+        if (b.isBitset())
+        {
+            for (auto low : a.array)
+                if (!b.contains(low))
+                    result.array.push_back(low);
+        }
+        else
+        {
+            std::set_difference(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                                std::back_inserter(result.array));
+        }
+        result.cardinality = static_cast<int>(result.array.size());
+        return result;
+    }
+
+    result.bitset = a.bitset;
+    if (b.isBitset())
+        for (size_t i = 0; i < bitsetNumWords; ++i)
+            result.bitset[i] &= ~b.bitset[i];
+    else
+        for (auto low : b.array)
+            result.bitset[low >> 6] &= ~(juce::uint64(1) << (low & 63));
+    for (auto word : result.bitset)
+        result.cardinality += juce::countNumberOfBits(word);
+    result.shrink();
+    return result;
+}
+
+int RoaringBitmap::getIntersectionCardinality(const Container &a, const Container &b)
+{
+    int cardinality = 0;
+    if (a.isBitset() && b.isBitset())
+    {
+        for (size_t i = 0; i < bitsetNumWords; ++i)
+            cardinality += juce::countNumberOfBits(a.bitset[i] & b.bitset[i]);
+    }
+    else if (a.isBitset() || b.isBitset())
+    {
+        const auto &arrayContainer = a.isBitset() ? b : a;
+        const auto &bitsetContainer = a.isBitset() ? a : b;
+        for (auto low : arrayContainer.array)
+            if (bitsetContainer.contains(low))
+                ++cardinality;
+    }
+    else
+    {
+        auto itA = a.array.begin();
+        auto itB = b.array.begin();
+        while (itA != a.array.end() && itB != b.array.end())
+        {
+            if (*itA < *itB)
+                ++itA;
+            else if (*itB < *itA)
+                ++itB;
+            else
+            {
+                ++cardinality;
+                ++itA;
+                ++itB;
+            }
+        }
+    }
+    return cardinality;
+}
+
+// ========================================
+// RoaringBitmap
+// ========================================
+
+void RoaringBitmap::add(juce::uint32 value)
+{
+    const auto key = static_cast<juce::uint16>(value >> 16);
+    const auto low = static_cast<juce::uint16>(value & 0xffff);
+
+    if (containers.empty() || containers.back().key < key)
+    {
+        containers.emplace_back();
+        containers.back().key = key;
+        containers.back().add(low);
+        return;
+    }
+
+    auto it = std::lower_bound(containers.begin(), containers.end(), key,
+                               [] (const Container &container, juce::uint16 k) { return container.key < k; });
+    if (it == containers.end() || it->key != key)
+    {
+        it = containers.insert(it, Container());
+        it->key = key;
+    }
+    it->add(low);
+}
+
+void RoaringBitmap::addRange(juce::uint32 begin, juce::uint32 end)
+{
+    for (auto value = begin; value < end; ++value)
+        add(value);
+}
+
+bool RoaringBitmap::contains(juce::uint32 value) const
+{
+    auto container = findContainer(static_cast<juce::uint16>(value >> 16));
+    return container != nullptr && container->contains(static_cast<juce::uint16>(value & 0xffff));
+}
+
+void RoaringBitmap::clear()
+{
+    containers.clear();
+}
+
+int RoaringBitmap::getCardinality() const
+{
+    int cardinality = 0;
+    for (const auto &container : containers)
+        cardinality += container.cardinality;
+    return cardinality;
+}
+
+bool RoaringBitmap::isEmpty() const
+{
+    return containers.empty();
+}
+
+size_t RoaringBitmap::getSizeInBytes() const
+{
+    size_t size = sizeof(RoaringBitmap);
+    for (const auto &container : containers)
+        size += sizeof(Container) + container.array.capacity() * sizeof(juce::uint16)
+                + container.bitset.capacity() * sizeof(juce::uint64);
+    return size;
+}
+
+RoaringBitmap RoaringBitmap::intersect(const RoaringBitmap &a, const RoaringBitmap &b)
+{
+    RoaringBitmap result;
+    auto itA = a.containers.begin();
+    auto itB = b.containers.begin();
+    while (itA != a.containers.end() && itB != b.containers.end())
+    {
+        if (itA->key < itB->key)
+            ++itA;
+        else if (itB->key < itA->key)
+            ++itB;
+        else
+        {
+            auto container = intersect(*itA, *itB);
+            if (container.cardinality > 0)
+                result.containers.push_back(std::move(container));
+            ++itA;
+            ++itB;
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::unite(const RoaringBitmap &a, const RoaringBitmap &b)
+{
+    RoaringBitmap result;
+    auto itA = a.containers.begin();
+    auto itB = b.containers.begin();
+    while (itA != a.containers.end() || itB != b.containers.end())
+    {
+        if (itB == b.containers.end() || (itA != a.containers.end() && itA->key < itB->key))
+            result.containers.push_back(*itA++);
+        else if (itA == a.containers.end() || itB->key < itA->key)
+            result.containers.push_back(*itB++);
+        else
+            result.containers.push_back(unite(*itA++, *itB++));
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::subtract(const RoaringBitmap &a, const RoaringBitmap &b)
+{
+    RoaringBitmap result;
+    auto itB = b.containers.begin();
+    for (const auto &container : a.containers)
+    {
+        while (itB != b.containers.end() && itB->key < container.key)
+            ++itB;
+
+        if (itB == b.containers.end() || itB->key != container.key)
+        {
+            result.containers.push_back(container);
+            continue;
+        }
+
+        auto difference = subtract(container, *itB);
+        if (difference.cardinality > 0)
+            result.containers.push_back(std::move(difference));
+    }
+    return result;
+}
+
+int RoaringBitmap::getIntersectionCardinality(const RoaringBitmap &a, const RoaringBitmap &b)
+{
+    int cardinality = 0;
+    auto itA = a.containers.begin();
+    auto itB = b.containers.begin();
+    while (itA != a.containers.end() && itB != b.containers.end())
+    {
+        if (itA->key < itB->key)
+            ++itA;
+        else if (itB->key < itA->key)
+            ++itB;
+        else
+            cardinality += getIntersectionCardinality(*itA++, *itB++);
+    }
+    return cardinality;
+}
+
+const RoaringBitmap::Container* RoaringBitmap::findContainer(juce::uint16 key) const
+{
+    auto it = std::lower_bound(containers.begin(), containers.end(), key,
+                               [] (const Container &container, juce::uint16 k) { return container.key < k; });
+    return it != containers.end() && it->key == key ? &*it : nullptr;
+}
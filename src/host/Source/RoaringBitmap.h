@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    RoaringBitmap.h
+    Created: 17 Oct 2026 8:08:28pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+// A compressed set of 32-bit integers in the style of Roaring bitmaps. The values are split
+// into chunks of 65536 by their upper 16 bits, a chunk is stored as a sorted array of its lower
+// 16 bits while it has few values and as a plain bitset once the array would be larger than
+// the bitset (4096 values). So a rare descriptor takes a few bytes per preset and a common one
+// a bit per preset, and the set operations work on whole machine words.
+class RoaringBitmap
+{
+public:
+    RoaringBitmap() = default;
+
+    // the values are usually added in increasing order, which appends to the last chunk
+    void add(juce::uint32 value);
+    // adds every value in [begin, end)
+    void addRange(juce::uint32 begin, juce::uint32 end);
+    bool contains(juce::uint32 value) const;
+    void clear();
+
+    int getCardinality() const;
+    bool isEmpty() const;
+    size_t getSizeInBytes() const;
+
+    static RoaringBitmap intersect(const RoaringBitmap &a, const RoaringBitmap &b);
+    static RoaringBitmap unite(const RoaringBitmap &a, const RoaringBitmap &b);
+    // the values of a that are not in b
+    static RoaringBitmap subtract(const RoaringBitmap &a, const RoaringBitmap &b);
+    // the size of the intersection, without building it
+    static int getIntersectionCardinality(const RoaringBitmap &a, const RoaringBitmap &b);
+
+    // calls function with every value in increasing order
+    template <typename Function>
+    void forEach(Function function) const
+    {
+        for (const auto &container : containers)
+        {
+            const juce::uint32 high = static_cast<juce::uint32>(container.key) << 16;
+            if (container.isBitset())
+            {
+                for (size_t i = 0; i < bitsetNumWords; ++i)
+                    for (auto word = container.bitset[i]; word != 0; word &= word - 1)
+                        function(high | static_cast<juce::uint32>(i * 64 + countTrailingZeros(word)));
+            }
+            else
+            {
+                for (auto low : container.array)
+                    function(high | low);
+            }
+        }
+    }
+
+private:
+    static constexpr size_t bitsetNumWords = 65536 / 64;
+    // an array chunk with more values than this takes more space than a bitset
+    static constexpr int maxArraySize = 4096;
+
+    struct Container
+    {
+        juce::uint16 key = 0;
+        int cardinality = 0;
+        std::vector<juce::uint16> array; // sorted, used while the container is not a bitset
+        std::vector<juce::uint64> bitset; // bitsetNumWords words, or empty
+
+        bool isBitset() const { return !bitset.empty(); }
+        bool contains(juce::uint16 low) const;
+        void add(juce::uint16 low);
+        void toBitset();
+        // turns a bitset into an array if that's smaller, the cardinality has to be up to date
+        void shrink();
+    };
+
+    static Container intersect(const Container &a, const Container &b);
+    static Container unite(const Container &a, const Container &b);
+    static Container subtract(const Container &a, const Container &b);
+    static int getIntersectionCardinality(const Container &a, const Container &b);
+
+    // the word must not be 0
+    static int countTrailingZeros(juce::uint64 word)
+    {
+       #if JUCE_MSVC
+        unsigned long index;
+        _BitScanForward64(&index, word);
+        return static_cast<int>(index);
+       #else
+        return __builtin_ctzll(word);
+       #endif
+    }
+
+    const Container* findContainer(juce::uint16 key) const;
+
+    std::vector<Container> containers; // sorted by their keys, none of them is empty
+};
@@ -0,0 +1,696 @@
+/*
+  ==============================================================================
+
+    SelfTests.cpp
+    Created: 17 Oct 2026 8:37:19pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#include "SelfTests.h"
+#include "MelSpectrogram.h"
+#include "DescriptorRegistry.h"
+#include "LatentIndex.h"
+#include "LibraryIndex.h"
+#include "RoaringBitmap.h"
+#include "RenderCache.h"
+#include "Utils.h"
+#include <algorithm>
+#include <iterator>
+#include <cmath>
+
+static const juce::String testCategory = "Ideator";
+
+// ========================================
+// MelSpectrogram
+// ========================================
+
+class MelSpectrogramTest : public juce::UnitTest
+{
+public:
+    explicit MelSpectrogramTest(juce::File referenceFile):
+            juce::UnitTest("MelSpectrogram", testCategory),
+            referenceFile(std::move(referenceFile))
+    {
+    }
+
+    void runTest() override
+    {
+        MelSpectrogram melSpectrogram;
+        const auto signal = makeTestSignal();
+        std::vector<float> features;
+
+        beginTest("Shape and normalisation");
+        expect(melSpectrogram.compute(signal.data(), (int) signal.size(), sampleRate, features));
+        expectEquals((int) features.size(), MelSpectrogram::numFeatures);
+        const auto range = juce::FloatVectorOperations::findMinAndMax(features.data(), (int) features.size());
+        expectGreaterOrEqual(range.getStart(), 0.f);
+        expectWithinAbsoluteError(range.getEnd(), 1.f, 1e-6f);
+
+        beginTest("Audio that doesn't fit the model");
+        expect(!melSpectrogram.compute(signal.data(), (int) signal.size(), 48000., features));
+        expect(!melSpectrogram.compute(signal.data(), (int) signal.size() / 2, sampleRate, features));
+
+        beginTest("Parity with torchaudio");
+        if (referenceFile == juce::File())
+        {
+            logMessage("Skipped, no reference file, see export_mel_reference.py");
+            return;
+        }
+
+        juce::MemoryBlock reference;
+        expect(referenceFile.loadFileAsData(reference), "Cannot read " + referenceFile.getFullPathName());
+        expectEquals((int) reference.getSize(), (int) (MelSpectrogram::numFeatures * sizeof(float)));
+        if (reference.getSize() != MelSpectrogram::numFeatures * sizeof(float))
+            return;
+
+        melSpectrogram.compute(signal.data(), (int) signal.size(), sampleRate, features);
+        const auto* referenceFeatures = static_cast<const float*>(reference.getData());
+        float maxError = 0.f;
+        for (int i = 0; i < MelSpectrogram::numFeatures; ++i)
+            maxError = juce::jmax(maxError, std::abs(features[(size_t) i] - referenceFeatures[i]));
+        logMessage("Largest difference: " + juce::String(maxError));
+        expectLessThan(maxError, 1e-3f);
+    }
+
+private:
+    static constexpr double sampleRate = 44100.;
+
+    // make_test_signal in export_mel_reference.py, two sines, the higher one fading in
+    static std::vector<float> makeTestSignal()
+    {
+        const int numSamples = 3 * (int) sampleRate;
+        const double twoPi = juce::MathConstants<double>::twoPi;
+        std::vector<float> signal((size_t) numSamples);
+        for (int n = 0; n < numSamples; ++n)
+            signal[(size_t) n] = static_cast<float>(0.5 * std::sin(twoPi * 440. * n / sampleRate)
+                                                    + 0.25 * std::sin(twoPi * 3000. * n / sampleRate) * n / numSamples);
+        return signal;
+    }
+
+    const juce::File referenceFile;
+};
+
+// ========================================
+// RenderCache
+// ========================================
+
+// a plugin with a few parameters that renders nothing, for the keys of the RenderCache
+class SilentPluginInstance : public juce::AudioPluginInstance
+{
+public:
+    explicit SilentPluginInstance(juce::String version): version(std::move(version))
+    {
+        for (int i = 0; i < 4; ++i)
+            addParameter(new juce::AudioParameterFloat("p" + juce::String(i), "P" + juce::String(i), 0.f, 1.f, 0.5f));
+    }
+
+    void fillInPluginDescription(juce::PluginDescription &description) const override
+    {
+        description.name = getName();
+        description.version = version;
+    }
+
+    const juce::String getName() const override { return "Silent"; }
+    void prepareToPlay(double, int) override {}
+    void releaseResources() override {}
+    void processBlock(juce::AudioBuffer<float> &buffer, juce::MidiBuffer &) override { buffer.clear(); }
+    double getTailLengthSeconds() const override { return 0.; }
+    bool acceptsMidi() const override { return true; }
+    bool producesMidi() const override { return false; }
+    juce::AudioProcessorEditor* createEditor() override { return nullptr; }
+    bool hasEditor() const override { return false; }
+    int getNumPrograms() override { return 1; }
+    int getCurrentProgram() override { return 0; }
+    void setCurrentProgram(int) override {}
+    const juce::String getProgramName(int) override { return {}; }
+    void changeProgramName(int, const juce::String &) override {}
+    void getStateInformation(juce::MemoryBlock &) override {}
+    void setStateInformation(const void*, int) override {}
+
+private:
+    const juce::String version;
+};
+
+class RenderCacheTest : public juce::UnitTest
+{
+public:
+    RenderCacheTest(): juce::UnitTest("RenderCache", testCategory) {}
+
+    void runTest() override
+    {
+        beginTest("Keys");
+        SilentPluginInstance instance("1.0");
+        const juce::String pluginPath = "/Plugins/Silent.vst3";
+        const RenderSpec spec;
+        const auto key = RenderCache::computeKey(instance, pluginPath, spec);
+        expectEquals(key.length(), 32);
+        expect(key.containsOnly("0123456789abcdef"), key);
+        expectEquals(RenderCache::computeKey(instance, pluginPath, spec), key);
+
+        // everything that changes the sound changes the key
+        expect(RenderCache::computeKey(instance, "/Plugins/Other.vst3", spec) != key, "plugin path");
+        expect(RenderCache::computeKey(SilentPluginInstance("1.1"), pluginPath, spec) != key, "plugin version");
+        auto otherSpec = spec;
+        otherSpec.blockSize /= 2;
+        expect(RenderCache::computeKey(instance, pluginPath, otherSpec) != key, "block size");
+        otherSpec = spec;
+        otherSpec.midiNote += 12;
+        expect(RenderCache::computeKey(instance, pluginPath, otherSpec) != key, "MIDI note");
+        otherSpec = spec;
+        otherSpec.silenceThreshold *= 2.f;
+        expect(RenderCache::computeKey(instance, pluginPath, otherSpec) != key, "silence threshold");
+        instance.getParameters()[2]->setValue(0.25f);
+        expect(RenderCache::computeKey(instance, pluginPath, spec) != key, "parameter value");
+        instance.getParameters()[2]->setValue(0.5f);
+        expectEquals(RenderCache::computeKey(instance, pluginPath, spec), key);
+
+        beginTest("Storing and loading");
+        const auto directory = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                                   .getNonexistentChildFile("IdeatorRenderCache", "", false);
+        RenderCache cache(directory);
+        juce::AudioBuffer<float> audio(2, 1000);
+        for (int channel = 0; channel < audio.getNumChannels(); ++channel)
+            for (int i = 0; i < audio.getNumSamples(); ++i)
+                audio.setSample(channel, i, std::sin(0.01f * (float) i * (float) (channel + 1)));
+        expect(cache.store(key, audio, spec.sampleRate));
+
+        juce::AudioBuffer<float> loadedAudio;
+        expect(cache.load(key, loadedAudio));
+        expectEquals(loadedAudio.getNumChannels(), audio.getNumChannels());
+        expectEquals(loadedAudio.getNumSamples(), audio.getNumSamples());
+        bool isSame = true;
+        for (int channel = 0; channel < audio.getNumChannels(); ++channel)
+            isSame = isSame && std::equal(audio.getReadPointer(channel), audio.getReadPointer(channel) + audio.getNumSamples(),
+                                          loadedAudio.getReadPointer(channel));
+        expect(isSame, "the loaded audio differs");
+        expect(!cache.load(RenderCache::computeKey(instance, "/Plugins/Other.vst3", spec), loadedAudio));
+
+        beginTest("Entries of another version or size");
+        // the version is the second value of the header of an entry
+        const auto entryFile = directory.getChildFile(key + ".render");
+        juce::MemoryBlock content;
+        expect(entryFile.loadFileAsData(content));
+        juce::int32 version;
+        content.copyTo(&version, 4, sizeof(version));
+        ++version;
+        content.copyFrom(&version, 4, sizeof(version));
+        expect(entryFile.replaceWithData(content.getData(), content.getSize()));
+        expect(!cache.load(key, loadedAudio), "an entry of another version has been loaded");
+
+        expect(cache.store(key, audio, spec.sampleRate) && entryFile.loadFileAsData(content));
+        expect(entryFile.replaceWithData(content.getData(), content.getSize() - sizeof(float)));
+        expect(!cache.load(key, loadedAudio), "a truncated entry has been loaded");
+
+        beginTest("Trimming");
+        expect(cache.store(key, audio, spec.sampleRate));
+        cache.trim(entryFile.getSize());
+        expect(entryFile.existsAsFile());
+        cache.trim(0);
+        expect(!entryFile.existsAsFile());
+
+        directory.deleteRecursively();
+    }
+};
+
+// ========================================
+// PresetManager
+// ========================================
+
+class PresetParserTest : public juce::UnitTest
+{
+public:
+    PresetParserTest(): juce::UnitTest("PresetManager::parse", testCategory) {}
+
+    void runTest() override
+    {
+        beginTest("A preset as generate writes it");
+        juce::Random random(1);
+        juce::XmlElement xmlPreset("IdeatorPreset");
+        auto xmlMeta = xmlPreset.createNewChildElement("Meta");
+        xmlMeta->createNewChildElement("PluginPath")->addTextElement("/Plugins/Diva & \"Co\" <x64>.vst3");
+        xmlMeta->createNewChildElement("Descriptors")->addTextElement("Bright, Warm");
+        auto xmlParameters = xmlPreset.createNewChildElement("Parameters");
+        for (int i = 0; i < 300; ++i)
+            xmlParameters->setAttribute("P_" + juce::String(i), random.nextDouble());
+        expectParsersAgree(xmlPreset.toString(), true);
+
+        beginTest("A preset written by hand");
+        expectParsersAgree("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                           "<!-- the parameters come first -->\n"
+                           "<IdeatorPreset>\n"
+                           "  <Parameters P_2 = '0.75' P_0=\"2.5e-1\"\n"
+                           "              P_1=\"1\"/>\n"
+                           "  <Meta><Note>not read</Note><PluginPath>/Plugins/A&amp;B &#x263A;.vst3</PluginPath>"
+                           "<Descriptors><![CDATA[Dark & Soft]]></Descriptors></Meta>\n"
+                           "</IdeatorPreset>\n", true);
+        expectParsersAgree("<IdeatorPreset><Meta><PluginPath>/Plugins/Empty.vst3</PluginPath></Meta>"
+                           "<Parameters/></IdeatorPreset>", true);
+
+        beginTest("Files that are not presets");
+        expectParsersAgree("<IdeatorPreset><Meta><Descriptors>Bright</Descriptors></Meta>"
+                           "<Parameters P_0=\"1\"/></IdeatorPreset>", false);
+        expectParsersAgree("<IdeatorPreset><Meta><PluginPath>/Plugins/Diva.vst3</PluginPath></Meta></IdeatorPreset>", false);
+        expectParsersAgree("<IdeatorPreset><Meta><PluginPath>/Plugins/Diva.vst3</PluginPath></Meta>"
+                           "<Parameters P_0=\"1\"", false);
+        expectParsersAgree("", false);
+    }
+
+private:
+    // the single-pass parser has to give what the XML document gives
+    void expectParsersAgree(const juce::String &content, bool shouldBeParsable)
+    {
+        juce::String domPluginPath, pluginPath;
+        DescriptorSet domDescriptors, descriptors;
+        juce::Array<std::pair<int, float>> domParameters;
+        std::vector<float> parameters;
+
+        auto xmlPreset = juce::XmlDocument::parse(content);
+        const bool isDomParsed = xmlPreset && PresetManager::parse(*xmlPreset, domParameters, domPluginPath, domDescriptors);
+        const bool isParsed = PresetManager::parse(content.toRawUTF8(), content.getNumBytesAsUTF8(),
+                                                   parameters, pluginPath, descriptors);
+        expect(isDomParsed == shouldBeParsable, "the XML document parser gives " + juce::String(isDomParsed ? "true" : "false"));
+        expect(isParsed == shouldBeParsable, "the single-pass parser gives " + juce::String(isParsed ? "true" : "false"));
+        if (!isParsed || !isDomParsed)
+            return;
+
+        expectEquals(pluginPath, domPluginPath);
+        expect(descriptors == domDescriptors, descriptors.toString() + " instead of " + domDescriptors.toString());
+        expectEquals(static_cast<int>(parameters.size()), domParameters.size());
+        for (int i = 0; i < juce::jmin(static_cast<int>(parameters.size()), domParameters.size()); ++i)
+            expectEquals(parameters[(size_t) i], domParameters[i].second, "P_" + juce::String(i));
+    }
+};
+
+// ========================================
+// LibraryIndex
+// ========================================
+
+class LibraryIndexTest : public juce::UnitTest
+{
+public:
+    LibraryIndexTest(): juce::UnitTest("LibraryIndex", testCategory) {}
+
+    void runTest() override
+    {
+        // the index files live in the application data folder, this one is deleted at the end
+        const auto libraryDir = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                                    .getNonexistentChildFile("IdeatorSelfTest", "", false);
+        const auto indexFile = LibraryIndex::getIndexFile(libraryDir);
+
+        std::vector<LibraryIndex::Preset> presets(3);
+        presets[0] = makePreset(libraryDir.getChildFile("Pads/Warm Pad.xml"), "Bright, Warm", { 0.f, 0.5f, 1.f });
+        presets[0].isAnalyzed = true;
+        presets[1] = makePreset(libraryDir.getChildFile("Bass/Deep Bass.xml"), "Deep", { 0.25f });
+        presets[2] = makePreset(libraryDir.getChildFile("Broken.xml"), "", {});
+        presets[2].isParsable = false;
+        presets[2].pluginPath = {};
+
+        beginTest("Writing and opening");
+        expect(LibraryIndex::write(indexFile, libraryDir, presets), "Cannot write " + indexFile.getFullPathName());
+        LibraryIndex index;
+        expect(index.open(libraryDir));
+        expectEquals(index.getNumPresets(), static_cast<int>(presets.size()));
+        expect(index.getLibraryDirectory() == libraryDir);
+
+        beginTest("Every field comes back");
+        for (const auto &preset : presets)
+        {
+            const int i = index.findPreset(preset.presetPath);
+            expect(i >= 0, preset.presetPath + " is not found");
+            if (i < 0)
+                continue;
+
+            const auto readPreset = index.getPreset(i);
+            expectEquals(readPreset.presetPath, preset.presetPath);
+            expectEquals(readPreset.pluginPath, preset.pluginPath);
+            expect(readPreset.descriptors == preset.descriptors, "the descriptors differ");
+            expect(readPreset.parameters == preset.parameters, "the parameters differ");
+            expectEquals(readPreset.fileSize, preset.fileSize);
+            expectEquals(readPreset.modificationTime, preset.modificationTime);
+            expect(readPreset.contentHash == preset.contentHash, "the content hashes differ");
+            expect(readPreset.isParsable == preset.isParsable, "the parsable flags differ");
+            expect(readPreset.isAnalyzed == preset.isAnalyzed, "the analyzed flags differ");
+        }
+
+        beginTest("Lookups");
+        // sorted by the paths relative to the library
+        expectEquals(index.getPresetPath(0), presets[1].presetPath);
+        expectEquals(index.findPreset(libraryDir.getChildFile("Missing.xml").getFullPathName()), -1);
+        int numParameters = -1;
+        expect(index.getParameters(index.getNumPresets(), numParameters) == nullptr);
+        expectEquals(numParameters, 0);
+
+        beginTest("Truncated files");
+        index.close();
+        juce::MemoryBlock content;
+        expect(indexFile.loadFileAsData(content));
+        expect(indexFile.replaceWithData(content.getData(), content.getSize() - 8));
+        expect(!index.open(libraryDir));
+        expect(!index.isOpen());
+
+        indexFile.deleteFile();
+    }
+
+private:
+    static LibraryIndex::Preset makePreset(const juce::File &file, const juce::String &descriptors,
+                                           std::vector<float> parameters)
+    {
+        LibraryIndex::Preset preset;
+        preset.presetPath = file.getFullPathName();
+        preset.pluginPath = "/Plugins/Diva.vst3";
+        preset.descriptors = DescriptorSet::fromString(descriptors);
+        preset.parameters = std::move(parameters);
+        preset.fileSize = 1000 + preset.presetPath.length();
+        preset.modificationTime = 1790000000000 + preset.presetPath.hashCode();
+        preset.contentHash = static_cast<juce::uint64>(preset.presetPath.hashCode64());
+        return preset;
+    }
+};
+
+// ========================================
+// RoaringBitmap
+// ========================================
+
+class RoaringBitmapTest : public juce::UnitTest
+{
+public:
+    RoaringBitmapTest(): juce::UnitTest("RoaringBitmap", testCategory) {}
+
+    void runTest() override
+    {
+        // array chunks, bitset chunks, a chunk that only one of them has, and a range over a chunk boundary
+        juce::Random random(1);
+        std::vector<juce::uint32> valuesA, valuesB;
+        for (int i = 0; i < 1000; ++i)
+            valuesA.push_back(static_cast<juce::uint32>(random.nextInt(65536)));
+        for (int i = 0; i < 20000; ++i)
+            valuesA.push_back(65536 + static_cast<juce::uint32>(random.nextInt(65536)));
+        for (int i = 0; i < 100; ++i)
+            valuesA.push_back(3 * 65536 + static_cast<juce::uint32>(random.nextInt(65536)));
+        for (int i = 0; i < 30000; ++i)
+            valuesB.push_back(static_cast<juce::uint32>(random.nextInt(65536)));
+        for (int i = 0; i < 500; ++i)
+            valuesB.push_back(65536 + static_cast<juce::uint32>(random.nextInt(65536)));
+        for (juce::uint32 value = 2 * 65536 - 100; value < 2 * 65536 + 5000; ++value)
+            valuesB.push_back(value);
+
+        const auto a = makeBitmap(valuesA, false);
+        const auto b = makeBitmap(valuesB, true);
+        sortAndRemoveDuplicates(valuesA);
+        sortAndRemoveDuplicates(valuesB);
+
+        beginTest("Values");
+        expect(getValues(a) == valuesA, "the values of a differ");
+        expect(getValues(b) == valuesB, "the values of b differ");
+        expectEquals(a.getCardinality(), static_cast<int>(valuesA.size()));
+        expect(b.contains(2 * 65536) && !b.contains(3 * 65536));
+
+        beginTest("And, or, and not");
+        std::vector<juce::uint32> expected;
+        std::set_intersection(valuesA.begin(), valuesA.end(), valuesB.begin(), valuesB.end(), std::back_inserter(expected));
+        expect(getValues(RoaringBitmap::intersect(a, b)) == expected, "and");
+        expectEquals(RoaringBitmap::getIntersectionCardinality(a, b), static_cast<int>(expected.size()));
+
+        expected.clear();
+        std::set_union(valuesA.begin(), valuesA.end(), valuesB.begin(), valuesB.end(), std::back_inserter(expected));
+        expect(getValues(RoaringBitmap::unite(a, b)) == expected, "or");
+
+        expected.clear();
+        std::set_difference(valuesA.begin(), valuesA.end(), valuesB.begin(), valuesB.end(), std::back_inserter(expected));
+        expect(getValues(RoaringBitmap::subtract(a, b)) == expected, "and not");
+        expected.clear();
+        std::set_difference(valuesB.begin(), valuesB.end(), valuesA.begin(), valuesA.end(), std::back_inserter(expected));
+        expect(getValues(RoaringBitmap::subtract(b, a)) == expected, "and not, the other way round");
+
+        beginTest("Empty results");
+        expect(RoaringBitmap::subtract(a, a).isEmpty());
+        expect(RoaringBitmap::intersect(a, RoaringBitmap()).isEmpty());
+        expect(getValues(RoaringBitmap::unite(RoaringBitmap(), b)) == valuesB);
+    }
+
+private:
+    static RoaringBitmap makeBitmap(const std::vector<juce::uint32> &values, bool useRanges)
+    {
+        // addRange is used for the runs of consecutive values
+        RoaringBitmap bitmap;
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            size_t end = i + 1;
+            while (useRanges && end < values.size() && values[end] == values[end - 1] + 1)
+                ++end;
+            if (end - i > 1)
+                bitmap.addRange(values[i], values[end - 1] + 1);
+            else
+                bitmap.add(values[i]);
+            i = end - 1;
+        }
+        return bitmap;
+    }
+
+    static void sortAndRemoveDuplicates(std::vector<juce::uint32> &values)
+    {
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+    }
+
+    static std::vector<juce::uint32> getValues(const RoaringBitmap &bitmap)
+    {
+        std::vector<juce::uint32> values;
+        bitmap.forEach([&values] (juce::uint32 value) { values.push_back(value); });
+        return values;
+    }
+};
+
+// ========================================
+// LatentIndex
+// ========================================
+
+class LatentIndexTest : public juce::UnitTest
+{
+public:
+    LatentIndexTest(): juce::UnitTest("LatentIndex", testCategory) {}
+
+    void runTest() override
+    {
+        juce::Random random(1);
+        const auto latents = SelfTests::makeSyntheticLatents(numPresets, dimension, random);
+        LatentIndex index;
+        index.setEncoderId(encoderId);
+        for (int i = 0; i < numPresets; ++i)
+            index.add(getPresetPath(i), latents.data() + (size_t) i * dimension, dimension);
+
+        beginTest("Recall against the brute force");
+        expectEquals(index.getNumPresets(), numPresets);
+        // the patches that are looked up are close to some of the presets
+        std::vector<float> queries((size_t) numQueries * dimension);
+        for (int q = 0; q < numQueries; ++q)
+        {
+            const auto* latent = latents.data() + (size_t) random.nextInt(numPresets) * dimension;
+            for (int j = 0; j < dimension; ++j)
+                queries[(size_t) q * dimension + (size_t) j] = latent[j] + random.nextFloat() - 0.5f;
+        }
+        const auto recall = getRecall(index, latents, queries);
+        logMessage("Recall: " + juce::String(recall, 4));
+        expectGreaterOrEqual(recall, 0.95);
+
+        beginTest("Saving and loading");
+        juce::TemporaryFile file(".latents");
+        expect(index.save(file.getFile()));
+        expect(!index.hasChanged());
+        LatentIndex loadedIndex;
+        expect(loadedIndex.load(file.getFile()));
+        expectEquals(loadedIndex.getNumPresets(), numPresets);
+        expectEquals(loadedIndex.getDimension(), dimension);
+        expect(loadedIndex.getEncoderId() == encoderId);
+        expect(!loadedIndex.hasChanged());
+        for (int q = 0; q < numQueries; ++q)
+            expect(getPaths(loadedIndex.search(queries.data() + (size_t) q * dimension, dimension, numMatches))
+                   == getPaths(index.search(queries.data() + (size_t) q * dimension, dimension, numMatches)),
+                   "the loaded index finds other presets");
+
+        beginTest("Removed presets");
+        const auto* firstLatent = latents.data();
+        expect(loadedIndex.remove(getPresetPath(0)));
+        expect(!loadedIndex.contains(getPresetPath(0)));
+        expect(!getPaths(loadedIndex.search(firstLatent, dimension, numMatches)).contains(getPresetPath(0)));
+
+        // most of the presets are removed, so the graph is built again when it's loaded
+        for (int i = 0; i < numPresets; i += 3)
+            loadedIndex.remove(getPresetPath(i));
+        for (int i = 1; i < numPresets; i += 3)
+            loadedIndex.remove(getPresetPath(i));
+        expect(loadedIndex.save(file.getFile()));
+        expect(loadedIndex.load(file.getFile()));
+        expectEquals(loadedIndex.getNumPresets(), numPresets / 3);
+        expect(loadedIndex.contains(getPresetPath(2)));
+        expectEquals(getPaths(loadedIndex.search(latents.data() + 2 * dimension, dimension, 1))[0], getPresetPath(2));
+
+        beginTest("Another encoder");
+        loadedIndex.setEncoderId(encoderId + 1);
+        expect(loadedIndex.isEmpty());
+
+        beginTest("Corrupt files");
+        // maxNumNeighbours is the fourth value of the header
+        juce::MemoryBlock content;
+        expect(index.save(file.getFile()) && file.getFile().loadFileAsData(content));
+        const juce::uint32 largeValue = 0xffffffff;
+        content.copyFrom(&largeValue, 12, sizeof(largeValue));
+        expect(file.getFile().replaceWithData(content.getData(), content.getSize()));
+        expect(!loadedIndex.load(file.getFile()));
+        expect(loadedIndex.isEmpty());
+        expect(loadedIndex.getEncoderId() == 0);
+
+        expect(index.save(file.getFile()) && file.getFile().loadFileAsData(content));
+        expect(file.getFile().replaceWithData(content.getData(), content.getSize() / 2));
+        expect(!loadedIndex.load(file.getFile()));
+    }
+
+private:
+    static constexpr int numPresets = 2000;
+    static constexpr int dimension = 16;
+    static constexpr int numQueries = 50;
+    static constexpr int numMatches = 10;
+    static constexpr juce::uint64 encoderId = 42;
+
+    static juce::String getPresetPath(int i)
+    {
+        return "/SelfTest/Preset" + juce::String(i) + ".xml";
+    }
+
+    static juce::StringArray getPaths(const std::vector<LatentIndex::Match> &matches)
+    {
+        juce::StringArray paths;
+        for (const auto &match : matches)
+            paths.add(match.presetPath);
+        return paths;
+    }
+
+    // the share of the true closest presets that the index finds
+    static double getRecall(LatentIndex &index, const std::vector<float> &latents, const std::vector<float> &queries)
+    {
+        int numFound = 0;
+        for (int q = 0; q < numQueries; ++q)
+        {
+            const auto* query = queries.data() + (size_t) q * dimension;
+            const auto paths = getPaths(index.search(query, dimension, numMatches));
+            for (int i : SelfTests::findClosestByBruteForce(latents, dimension, query, numMatches))
+                if (paths.contains(getPresetPath(i)))
+                    ++numFound;
+        }
+        return numFound / static_cast<double>(numQueries * numMatches);
+    }
+};
+
+// ========================================
+// DescriptorSet
+// ========================================
+
+class DescriptorSetTest : public juce::UnitTest
+{
+public:
+    DescriptorSetTest(): juce::UnitTest("DescriptorSet", testCategory) {}
+
+    void runTest() override
+    {
+        beginTest("Parsing and writing");
+        const auto descriptors = DescriptorSet::fromString("Bright, Warm &Soft  Bright");
+        expectEquals(descriptors.size(), 3);
+        expect(!descriptors.hasExtraWords());
+        expect(DescriptorSet::fromString(descriptors.toString()) == descriptors);
+        expect(DescriptorSet::fromString("Soft Warm Bright") == descriptors, "the order of the words doesn't matter");
+        expect(DescriptorSet::fromString("").isEmpty());
+
+        // the registry of this process runs out of ids, so this has to be the last test that registers words
+        beginTest("More words than ids");
+        const int numWords = DescriptorRegistry::maxNumWords + 16;
+        juce::StringArray words;
+        for (int i = 0; i < numWords; ++i)
+            words.add("SelfTestWord" + juce::String(i));
+        const auto manyDescriptors = DescriptorSet::fromString(words.joinIntoString(", "));
+        expectEquals(manyDescriptors.size(), numWords);
+        expect(manyDescriptors.hasExtraWords());
+
+        const auto writtenWords = manyDescriptors.toWords();
+        for (const auto &word : words)
+            expect(writtenWords.contains(word), word + " has been lost");
+        expect(DescriptorSet::fromString(manyDescriptors.toString()) == manyDescriptors);
+
+        auto cleared = manyDescriptors;
+        cleared.clear();
+        expect(cleared.isEmpty());
+        expect(cleared != manyDescriptors);
+    }
+};
+
+// ========================================
+// SelfTests
+// ========================================
+
+int SelfTests::run(const Options &options)
+{
+    // the tests run in the order they are created, DescriptorSetTest uses up the descriptor ids
+    MelSpectrogramTest melSpectrogramTest(options.melReferenceFile);
+    RenderCacheTest renderCacheTest;
+    PresetParserTest presetParserTest;
+    LibraryIndexTest libraryIndexTest;
+    RoaringBitmapTest roaringBitmapTest;
+    LatentIndexTest latentIndexTest;
+    DescriptorSetTest descriptorSetTest;
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runTestsInCategory(testCategory);
+
+    int numFailures = 0;
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        numFailures += runner.getResult(i)->failures;
+    return numFailures;
+}
+
+std::vector<float> SelfTests::makeSyntheticLatents(int numPresets, int dimension, juce::Random &random)
+{
+    // a normal distribution around a few centres, Box-Muller from the uniform ones
+    auto nextGaussian = [&random] {
+        const double uniform = 1.0 - random.nextDouble();
+        return static_cast<float>(std::sqrt(-2.0 * std::log(uniform))
+                                  * std::cos(juce::MathConstants<double>::twoPi * random.nextDouble()));
+    };
+
+    const int numClusters = juce::jmax(1, numPresets / 50);
+    std::vector<float> centres((size_t) numClusters * (size_t) dimension);
+    for (auto &value : centres)
+        value = 3.f * nextGaussian();
+
+    std::vector<float> latents((size_t) numPresets * (size_t) dimension);
+    for (int i = 0; i < numPresets; ++i)
+    {
+        const auto* centre = centres.data() + (size_t) random.nextInt(numClusters) * (size_t) dimension;
+        for (int j = 0; j < dimension; ++j)
+            latents[(size_t) i * (size_t) dimension + (size_t) j] = centre[j] + nextGaussian();
+    }
+    return latents;
+}
+
+std::vector<int> SelfTests::findClosestByBruteForce(const std::vector<float> &latents, int dimension,
+                                                    const float* query, int numMatches)
+{
+    const int numPresets = static_cast<int>(latents.size() / (size_t) dimension);
+    std::vector<std::pair<float, int>> distances((size_t) numPresets);
+    for (int i = 0; i < numPresets; ++i)
+    {
+        const auto* latent = latents.data() + (size_t) i * (size_t) dimension;
+        float distance = 0.f;
+        for (int j = 0; j < dimension; ++j)
+            distance += (latent[j] - query[j]) * (latent[j] - query[j]);
+        distances[(size_t) i] = { distance, i };
+    }
+
+    numMatches = juce::jmin(numMatches, numPresets);
+    std::partial_sort(distances.begin(), distances.begin() + numMatches, distances.end());
+    std::vector<int> closest;
+    for (int i = 0; i < numMatches; ++i)
+        closest.push_back(distances[(size_t) i].second);
+    return closest;
+}
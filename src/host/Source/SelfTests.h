@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    SelfTests.h
+    Created: 17 Oct 2026 8:37:19pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+// The checks that Ideator-Cli --self-test runs on the parts of the host that need neither
+// a plugin nor the Python back-end. Every part has a juce::UnitTest in SelfTests.cpp.
+class SelfTests
+{
+public:
+    struct Options
+    {
+        // the log-mel spectrogram torchaudio computes for the test signal, see export_mel_reference.py,
+        // the parity with torchaudio is not checked without it
+        juce::File melReferenceFile;
+    };
+
+    /*!
+     * Runs the tests and prints their results.
+     * @return the number of failed checks
+     */
+    static int run(const Options &options);
+
+    /*!
+     * Makes the latent features of a made-up library, in clusters like the ones of real presets,
+     * for the LatentIndex test and Ideator-Cli --bench-similar.
+     * @param numPresets the number of presets
+     * @param dimension the number of values per preset
+     * @param random the same seed gives the same library
+     * @return numPresets * dimension values, preset by preset
+     */
+    static std::vector<float> makeSyntheticLatents(int numPresets, int dimension, juce::Random &random);
+
+    /*!
+     * Finds the closest presets by comparing the query to every one of them.
+     * @return the indices of the numMatches closest presets, closest first
+     */
+    static std::vector<int> findClosestByBruteForce(const std::vector<float> &latents, int dimension,
+                                                    const float* query, int numMatches);
+};
@@ -0,0 +1,179 @@
+/*
+  ==============================================================================
+
+    SharedMemoryTransport.cpp
+    Created: 17 Oct 2026 7:36:14pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#include "SharedMemoryTransport.h"
+
+#if JUCE_MAC || JUCE_LINUX
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <signal.h>
+ #include <cerrno>
+#endif
+
+// The layout of the shared memory, which must match shared_memory_ring.py.
+// The positions only grow, the offset into the ring is the position modulo the capacity.
+struct SharedMemoryTransport::Header
+{
+    char magic[4];
+    juce::uint32 version;
+    juce::uint64 capacity; // the number of bytes after the header
+    std::atomic<juce::uint64> writePosition; // written by the host
+    std::atomic<juce::uint64> readPosition;  // written by the Python program
+    juce::int64 ownerProcessId;
+    std::atomic<juce::uint32> isOpen;        // cleared by the Python program when it quits
+    char reserved[20];
+};
+
+static_assert(sizeof(std::atomic<juce::uint64>) == sizeof(juce::uint64), "unexpected atomic size");
+
+// the UDP datagram that tells the Python program where a buffer is
+struct SharedMemoryDescriptor
+{
+    char magic[4];
+    juce::int32 id;
+    juce::uint64 position;
+    juce::int32 numSamples;
+    juce::int32 numSkippedBytes; // the end of the ring that has been skipped before the position
+};
+
+static const char sharedMemoryMagic[4] = { 'I', 'D', 'S', 'M' };
+static const juce::uint32 sharedMemoryVersion = 2;
+static const size_t sharedMemoryHeaderSize = 64;
+// records start on cache line boundaries
+static const juce::uint64 sharedMemoryAlignment = 64;
+
+SharedMemoryTransport::SharedMemoryTransport():
+        header(nullptr),
+        data(nullptr),
+        mappedSize(0)
+{
+    static_assert(sizeof(Header) == sharedMemoryHeaderSize, "the header must match the Python side");
+    static_assert(sizeof(SharedMemoryDescriptor) == 24, "the descriptor must match the Python side");
+}
+
+SharedMemoryTransport::~SharedMemoryTransport()
+{
+    disconnect();
+}
+
+bool SharedMemoryTransport::sendBuffer(const float* bufferArray, int size, int id)
+{
+    if (!USE_SHARED_MEMORY || size <= 0 || !isConnected())
+        return false;
+
+    const auto capacity = header->capacity;
+    const auto numBytes = static_cast<juce::uint64>(size) * sizeof(float);
+    if (numBytes > capacity)
+        return false;
+
+    // Reserve the space first, both the app and the plugin might be writing to the ring.
+    const auto startTime = juce::Time::getMillisecondCounter();
+    juce::uint64 position, currentPosition;
+    for (;;)
+    {
+        currentPosition = header->writePosition.load();
+
+        // a buffer is never split, so skip the end of the ring if it doesn't fit there
+        position = currentPosition;
+        if (position % capacity + numBytes > capacity)
+            position += capacity - position % capacity;
+        const auto nextPosition = (position + numBytes + sharedMemoryAlignment - 1) / sharedMemoryAlignment * sharedMemoryAlignment;
+
+        if (position + numBytes - header->readPosition.load(std::memory_order_acquire) <= capacity)
+        {
+            if (header->writePosition.compare_exchange_weak(currentPosition, nextPosition))
+                break;
+            continue;
+        }
+
+        // wait a moment for the Python program to free enough space, otherwise give up
+        if (juce::Time::getMillisecondCounter() - startTime > SHARED_MEMORY_TIMEOUT_MS)
+            return false;
+        juce::Thread::sleep(1);
+    }
+
+    // the datagram below is sent after the copy, so the Python program never reads a partial buffer
+    memcpy(data + position % capacity, bufferArray, numBytes);
+
+    SharedMemoryDescriptor descriptor;
+    memcpy(descriptor.magic, sharedMemoryMagic, sizeof(sharedMemoryMagic));
+    descriptor.id = id;
+    descriptor.position = position;
+    descriptor.numSamples = size;
+    // the Python program frees the space in the order of the reservations, which start at currentPosition,
+    // and gives up a reservation whose descriptor fails to arrive after LOST_RESERVATION_TIMEOUT
+    descriptor.numSkippedBytes = static_cast<juce::int32>(position - currentPosition);
+    return socket.write(LOCAL_ADDRESS, UDP_SEND_PORT, &descriptor, sizeof(descriptor)) == (int) sizeof(descriptor);
+}
+
+bool SharedMemoryTransport::isConnected()
+{
+#if JUCE_MAC || JUCE_LINUX
+    // the Python program might have quit or been restarted since the last buffer
+    if (header != nullptr
+        && (header->isOpen.load() == 0
+            || (kill(static_cast<pid_t>(header->ownerProcessId), 0) != 0 && errno == ESRCH)))
+        disconnect();
+
+    return header != nullptr || connect();
+#else
+    return false;
+#endif
+}
+
+bool SharedMemoryTransport::connect()
+{
+#if JUCE_MAC || JUCE_LINUX
+    const int fd = shm_open(SHARED_MEMORY_NAME.toRawUTF8(), O_RDWR, 0);
+    if (fd == -1)
+        return false;
+
+    struct stat fileInfo;
+    void* address = MAP_FAILED;
+    if (fstat(fd, &fileInfo) == 0 && fileInfo.st_size > (off_t) sharedMemoryHeaderSize)
+        address = mmap(nullptr, (size_t) fileInfo.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // the mapping stays valid after the descriptor has been closed
+    close(fd);
+
+    if (address == MAP_FAILED)
+        return false;
+
+    header = static_cast<Header*>(address);
+    data = static_cast<char*>(address) + sharedMemoryHeaderSize;
+    mappedSize = (size_t) fileInfo.st_size;
+
+    if (memcmp(header->magic, sharedMemoryMagic, sizeof(sharedMemoryMagic)) != 0
+        || header->version != sharedMemoryVersion
+        || header->capacity + sharedMemoryHeaderSize > mappedSize
+        || header->isOpen.load() == 0)
+    {
+        disconnect();
+        return false;
+    }
+
+    DBG("SharedMemoryTransport: connected to " << SHARED_MEMORY_NAME);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SharedMemoryTransport::disconnect()
+{
+#if JUCE_MAC || JUCE_LINUX
+    if (header != nullptr)
+        munmap(header, mappedSize);
+#endif
+    header = nullptr;
+    data = nullptr;
+    mappedSize = 0;
+}
@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+
+    SharedMemoryTransport.h
+    Created: 17 Oct 2026 7:36:14pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "Config.h"
+
+// Sends audio buffers to the Python program through a ring buffer in shared memory.
+// The Python program creates the shared memory when it starts. The host copies a buffer
+// into the ring and sends one small UDP datagram with its position to the port the
+// UDP messages are sent to, so the Python program can tell both kinds of messages apart.
+// Only available on macOS and Linux.
+class SharedMemoryTransport
+{
+public:
+    SharedMemoryTransport();
+    ~SharedMemoryTransport();
+
+    /*!
+     * Copies a buffer into the shared memory and notifies the Python program.
+     * @param bufferArray the samples
+     * @param size the number of samples
+     * @param id the id of the buffer, the receiver uses it to tell the buffers apart
+     * @return false if the shared memory is not available or full, the buffer should be sent in another way
+     */
+    bool sendBuffer(const float* bufferArray, int size, int id);
+
+private:
+    bool isConnected();
+    bool connect();
+    void disconnect();
+
+    struct Header;
+    Header* header;
+    char* data;
+    size_t mappedSize;
+
+    juce::DatagramSocket socket;
+
+    JUCE_DECLARE_NON_COPYABLE (SharedMemoryTransport)
+};
@@ -0,0 +1,242 @@
+/*
+  ==============================================================================
+
+    StreamTransport.cpp
+    Created: 17 Oct 2026 7:38:20pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#include "StreamTransport.h"
+#include <array>
+
+// The layouts must match receive_audio_stream.py
+struct StreamFrameHeader
+{
+    char magic[4];
+    juce::int32 id;
+    juce::uint32 numBytes;
+    juce::uint32 checksum;
+};
+
+struct StreamAcknowledgement
+{
+    char magic[4];
+    juce::int32 id;
+    juce::int32 status; // 0 means the frame is intact
+};
+
+static const char streamFrameMagic[4] = { 'I', 'D', 'S', 'T' };
+static const char streamAcknowledgementMagic[4] = { 'I', 'D', 'S', 'A' };
+
+// ========================================
+// Writer
+// ========================================
+
+class StreamTransport::Writer : public juce::Thread
+{
+public:
+    explicit Writer(StreamTransport &transport):
+            juce::Thread("Ideator Stream Writer"),
+            transport(transport)
+    {
+    }
+
+    ~Writer() override
+    {
+        stopThread(1000);
+    }
+
+    void run() override
+    {
+        // A write blocks while the Python program doesn't read, until the acknowledgement
+        // thread gives up on it and the socket is closed, which makes the write fail.
+        juce::MemoryBlock frame;
+        while (!threadShouldExit())
+        {
+            if (!transport.popFrame(frame))
+            {
+                transport.frameQueued.wait(100);
+                continue;
+            }
+
+            if (transport.socket.write(frame.getData(), (int) frame.getSize()) != (int) frame.getSize())
+            {
+                DBG("StreamTransport: the connection has been lost.");
+                transport.isBroken = true;
+                return;
+            }
+        }
+    }
+
+private:
+    StreamTransport &transport;
+};
+
+// ========================================
+// StreamTransport
+// ========================================
+
+StreamTransport::StreamTransport(juce::String address, int port):
+        juce::Thread("Ideator Stream Acknowledgements"),
+        address(std::move(address)),
+        port(port),
+        writer(std::make_unique<Writer>(*this)),
+        numUnacknowledged(0),
+        lastProgressTime(0),
+        isBroken(false),
+        lastConnectionAttempt(0)
+{
+    static_assert(sizeof(StreamFrameHeader) == 16, "the header must match the Python side");
+    static_assert(sizeof(StreamAcknowledgement) == 12, "the acknowledgement must match the Python side");
+}
+
+StreamTransport::~StreamTransport()
+{
+    disconnect();
+}
+
+bool StreamTransport::sendBuffer(const float* bufferArray, int size, int id)
+{
+    // the thread has stopped reading, the connection is closed here, on the thread that writes to it
+    if (isBroken)
+        disconnect();
+
+    if (!socket.isConnected() && !connect())
+        return false;
+
+    // The buffer goes another way instead of waiting for a free slot, this is called on the
+    // message thread, which must not be blocked until the Python program catches up.
+    if (numUnacknowledged >= STREAM_WINDOW_SIZE)
+        return false;
+
+    StreamFrameHeader header;
+    memcpy(header.magic, streamFrameMagic, sizeof(streamFrameMagic));
+    header.id = id;
+    header.numBytes = static_cast<juce::uint32>(size * sizeof(float));
+    header.checksum = computeChecksum(bufferArray, header.numBytes);
+
+    // the caller's buffer may change once this returns, so the frame is copied for the writer
+    juce::MemoryBlock frame(sizeof(header) + header.numBytes);
+    frame.copyFrom(&header, 0, sizeof(header));
+    frame.copyFrom(bufferArray, (int) sizeof(header), header.numBytes);
+
+    // counted before queueing, the acknowledgement might arrive before this returns
+    if (numUnacknowledged++ == 0)
+        lastProgressTime = juce::Time::getMillisecondCounter();
+
+    {
+        const juce::ScopedLock sl(framesLock);
+        frames.push_back(std::move(frame));
+    }
+    frameQueued.signal();
+    return true;
+}
+
+bool StreamTransport::popFrame(juce::MemoryBlock &frame)
+{
+    const juce::ScopedLock sl(framesLock);
+    if (frames.empty())
+        return false;
+
+    frame = std::move(frames.front());
+    frames.pop_front();
+    return true;
+}
+
+bool StreamTransport::connect()
+{
+    // don't try on every buffer when the Python program doesn't listen
+    const auto now = juce::Time::getMillisecondCounter();
+    if (lastConnectionAttempt != 0 && now - lastConnectionAttempt < 1000)
+        return false;
+    lastConnectionAttempt = now;
+
+    numUnacknowledged = 0;
+    isBroken = false;
+    if (!socket.connect(address, port, 1000))
+        return false;
+
+    startThread();
+    writer->startThread();
+    DBG("StreamTransport: connected to " << address << ":" << port);
+    return true;
+}
+
+void StreamTransport::disconnect()
+{
+    // Closing the socket first makes a write that blocks fail, so the writer is never killed.
+    // Both threads wake up at least every 100 ms otherwise.
+    signalThreadShouldExit();
+    writer->signalThreadShouldExit();
+    socket.close();
+    stopThread(1000);
+    writer->stopThread(1000);
+
+    {
+        const juce::ScopedLock sl(framesLock);
+        frames.clear();
+    }
+    numUnacknowledged = 0;
+    isBroken = false;
+}
+
+void StreamTransport::run()
+{
+    while (!threadShouldExit())
+    {
+        const int ready = socket.waitUntilReady(true, 100);
+        if (ready == 0)
+        {
+            // nothing to read, which is only an error if a frame has been waiting for too long
+            if (numUnacknowledged > 0
+                && juce::Time::getMillisecondCounter() - lastProgressTime > (juce::uint32) STREAM_TIMEOUT_MS)
+            {
+                DBG("StreamTransport: no acknowledgement for " << STREAM_TIMEOUT_MS << " ms, disconnecting.");
+                isBroken = true;
+                return;
+            }
+            continue;
+        }
+
+        StreamAcknowledgement acknowledgement;
+        if (ready < 0 || socket.read(&acknowledgement, sizeof(acknowledgement), true) != (int) sizeof(acknowledgement)
+            || memcmp(acknowledgement.magic, streamAcknowledgementMagic, sizeof(streamAcknowledgementMagic)) != 0)
+        {
+            DBG("StreamTransport: the connection has been lost.");
+            isBroken = true;
+            return;
+        }
+
+        // A damaged frame is not sent again, the Python program reports the buffer as lost
+        // to whoever is waiting for it, so the analysis skips the preset.
+        if (acknowledgement.status != 0)
+            DBG("StreamTransport: the buffer " << acknowledgement.id << " arrived damaged.");
+
+        lastProgressTime = juce::Time::getMillisecondCounter();
+        --numUnacknowledged;
+    }
+}
+
+juce::uint32 StreamTransport::computeChecksum(const void* data, size_t numBytes)
+{
+    static const auto table = []
+    {
+        std::array<juce::uint32, 256> t;
+        for (juce::uint32 i = 0; i < 256; ++i)
+        {
+            auto c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    juce::uint32 crc = 0xffffffffu;
+    auto bytes = static_cast<const juce::uint8*>(data);
+    for (size_t i = 0; i < numBytes; ++i)
+        crc = table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    return crc ^ 0xffffffffu;
+}
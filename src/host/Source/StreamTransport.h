@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+    StreamTransport.h
+    Created: 17 Oct 2026 7:38:20pm
+    Author:  Yilin Zhang
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <deque>
+#include "Config.h"
+
+// Sends audio buffers to the Python program over a TCP connection. Every buffer is sent in
+// a frame with its id, its length and a CRC-32 of the samples, and the Python program
+// acknowledges every frame. At most STREAM_WINDOW_SIZE frames can be unacknowledged, so the
+// host never runs too far ahead of the Python program, and a Python program that stops
+// responding is detected by a timeout instead of stalling the host.
+// The acknowledgements are read on a thread of their own, so sending never waits for them.
+// The frames are written by another thread as well, a socket whose buffer is full would
+// otherwise block the message thread until the Python program reads again.
+class StreamTransport : private juce::Thread
+{
+public:
+    StreamTransport(juce::String address, int port);
+    ~StreamTransport();
+
+    /*!
+     * Sends a buffer in a frame, connecting to the Python program first if needed.
+     * @param bufferArray the samples
+     * @param size the number of samples
+     * @param id the id of the buffer, the receiver uses it to tell the buffers apart
+     * @return false if the buffer could not be sent or the window is full, it should be sent in another way
+     */
+    bool sendBuffer(const float* bufferArray, int size, int id);
+
+    /*!
+     * Computes the CRC-32 (the one of zlib) of a block of memory.
+     */
+    static juce::uint32 computeChecksum(const void* data, size_t numBytes);
+
+private:
+    class Writer;
+
+    bool connect();
+    void disconnect();
+    // reads the acknowledgements until the connection is lost or times out
+    void run() override;
+    // takes the next frame out of the queue, false if there is none
+    bool popFrame(juce::MemoryBlock &frame);
+
+    const juce::String address;
+    const int port;
+    juce::StreamingSocket socket;
+    std::unique_ptr<Writer> writer;
+    // the frames that haven't been written yet, each one is a header followed by the samples
+    juce::CriticalSection framesLock;
+    std::deque<juce::MemoryBlock> frames;
+    juce::WaitableEvent frameQueued;
+    // including the frames in the queue, so there are never more than STREAM_WINDOW_SIZE of them
+    std::atomic<int> numUnacknowledged;
+    // when the last frame was acknowledged, or sent if none was unacknowledged
+    std::atomic<juce::uint32> lastProgressTime;
+    // set by the threads, the connection is closed by the next sendBuffer
+    std::atomic<bool> isBroken;
+    juce::uint32 lastConnectionAttempt;
+
+    JUCE_DECLARE_NON_COPYABLE (StreamTransport)
+};
@@ -10,6 +10,14 @@
 
 #include "Utils.h"
 #include "PluginManager.h"
+#include <cstring>
+#include <string>
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <sys/socket.h>
+ #include <netinet/in.h>
+ #include <arpa/inet.h>
+#endif
 
 // ========================================
 // PresetManager
@@ -17,7 +25,7 @@
 
 juce::XmlElement PresetManager::generate(const juce::Array<juce::AudioProcessorParameter*> &parameters,
                                          const juce::String &pluginPath,
-                                         const std::unordered_set<juce::String> &descriptors)
+                                         const DescriptorSet &descriptors)
 {
     // IdeatorPlugin
     //  |- Meta
@@ -40,17 +48,7 @@ juce::XmlElement PresetManager::generate(const juce::Array<juce::AudioProcessorP
     xmlPluginPath->addTextElement(pluginPath);
 
     auto xmlDescriptors = new juce::XmlElement("Descriptors");
-    juce::String descriptorString;
-    bool isFirst = true;
-    for (auto &descriptor : descriptors)
-    {
-        if (!isFirst)
-            descriptorString.append(", ", 2);
-        else
-            isFirst = false;
-        descriptorString.append(descriptor, descriptor.length());
-    }
-    xmlDescriptors->addTextElement(descriptorString);
+    xmlDescriptors->addTextElement(descriptors.toString());
 
     // construct the XML structure
     xmlMeta->addChildElement(xmlPluginPath);
@@ -63,125 +61,436 @@ juce::XmlElement PresetManager::generate(const juce::Array<juce::AudioProcessorP
 bool PresetManager::parse(const juce::XmlElement &preset,
                           juce::Array<std::pair<int, float>> &parameters,
                           juce::String &pluginPath,
-                          std::unordered_set<juce::String> &descriptors)
+                          DescriptorSet &descriptors)
 {
     // parse the plugin path
     auto xmlMeta = preset.getChildByName("Meta");
-    auto xmlPluginPath = xmlMeta->getChildByName("PluginPath");
+    auto xmlPluginPath = xmlMeta ? xmlMeta->getChildByName("PluginPath") : nullptr;
+    auto xmlParametersPointer = preset.getChildByName("Parameters");
+    if (!xmlPluginPath || !xmlParametersPointer)
+        return false;
     pluginPath = xmlPluginPath->getAllSubText();
 
     // parse plugin parameters
-    auto xmlParameters = *preset.getChildByName("Parameters");
+    auto xmlParameters = *xmlParametersPointer;
     for (int i=0; i<xmlParameters.getNumAttributes(); ++i)
         // add the prefix "P_"
         parameters.add({i, xmlParameters.getDoubleAttribute("P_" + juce::String(i))});
 
     // set meta data
     auto xmlDescriptors = xmlMeta->getChildByName("Descriptors");
-    juce::StringArray descriptorArray;
-    descriptorArray.addTokens(xmlDescriptors->getAllSubText(), ", &", "\"");
-    descriptorArray.removeEmptyStrings(true);
-    descriptors.clear();
-    for (auto &descriptor : descriptorArray)
-        descriptors.insert(descriptor);
+    descriptors = xmlDescriptors ? DescriptorSet::fromString(xmlDescriptors->getAllSubText()) : DescriptorSet();
 
     // true means parse successfully
     return true;
 }
 
+// the elements of an IdeatorPreset that the single-pass parser looks at
+enum class PresetElement
+{
+    other,
+    preset,
+    meta,
+    pluginPath,
+    descriptors,
+    parameters
+};
+
+static const int maxPresetDepth = 16;
+// a P_ index beyond this means the file is corrupted rather than a preset of a huge plugin
+static const int maxPresetParameters = 1 << 16;
+
+static bool isXmlWhitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool isXmlNameCharacter(char c)
+{
+    return !isXmlWhitespace(c) && c != '>' && c != '/' && c != '=';
+}
+
+static bool matches(const char* begin, const char* end, const char* name)
+{
+    const auto length = std::strlen(name);
+    return static_cast<size_t>(end - begin) == length && std::memcmp(begin, name, length) == 0;
+}
+
+static bool startsWith(const char* begin, const char* end, const char* prefix)
+{
+    const auto length = std::strlen(prefix);
+    return static_cast<size_t>(end - begin) >= length && std::memcmp(begin, prefix, length) == 0;
+}
+
+// moves text past the next occurrence of pattern, returns false if there is none
+static bool skipPast(const char* &text, const char* end, const char* pattern)
+{
+    const auto length = std::strlen(pattern);
+    for (; static_cast<size_t>(end - text) >= length; ++text)
+    {
+        if (std::memcmp(text, pattern, length) == 0)
+        {
+            text += length;
+            return true;
+        }
+    }
+    text = end;
+    return false;
+}
 
-juce::String PresetManager::descriptorsToString(const std::unordered_set<juce::String>& descriptors)
+// appends the text with its entities (&amp; etc.) replaced by the characters
+static void appendXmlText(const char* begin, const char* end, std::string &text)
 {
-    // form a string of descriptors, use "," as the separator
-    juce::String descriptorString;
-    int idx = 0;
-    for (const auto& descriptor : descriptors)
+    while (begin < end)
     {
-        descriptorString.append(descriptor, descriptor.length());
-        if (idx != descriptors.size() - 1)
-            descriptorString.append(", ", 2);
-        ++idx;
+        if (*begin != '&')
+        {
+            text += *begin++;
+            continue;
+        }
+
+        auto semicolon = static_cast<const char*>(std::memchr(begin, ';', static_cast<size_t>(end - begin)));
+        if (semicolon == nullptr)
+        {
+            text.append(begin, end);
+            return;
+        }
+
+        const char* entity = begin + 1;
+        if (matches(entity, semicolon, "amp"))
+            text += '&';
+        else if (matches(entity, semicolon, "lt"))
+            text += '<';
+        else if (matches(entity, semicolon, "gt"))
+            text += '>';
+        else if (matches(entity, semicolon, "quot"))
+            text += '"';
+        else if (matches(entity, semicolon, "apos"))
+            text += '\'';
+        else if (*entity == '#' && semicolon - entity > 1)
+        {
+            const bool isHex = entity[1] == 'x' || entity[1] == 'X';
+            juce::uint32 code = 0;
+            for (const char* digit = entity + (isHex ? 2 : 1); digit < semicolon && code < 0x110000; ++digit)
+            {
+                const int value = isHex ? juce::CharacterFunctions::getHexDigitValue(static_cast<juce::juce_wchar>(*digit))
+                                        : *digit - '0';
+                code = code * (isHex ? 16 : 10) + static_cast<juce::uint32>(juce::jlimit(0, 15, value));
+            }
+            text += juce::String::charToString(static_cast<juce::juce_wchar>(code)).toRawUTF8();
+        }
+        else
+            text.append(begin, semicolon + 1);
+
+        begin = semicolon + 1;
+    }
+}
+
+bool PresetManager::parse(const char* data,
+                          size_t size,
+                          std::vector<float> &parameters,
+                          juce::String &pluginPath,
+                          DescriptorSet &descriptors)
+{
+    // IdeatorPreset
+    //  |- Meta
+    //  |   |- PluginPath
+    //  |   |- Descriptors
+    //  |- Parameters P_0="..." P_1="..." ...
+    parameters.clear();
+    std::string pluginPathText, descriptorText;
+    bool hasPluginPath = false, hasParameters = false;
+
+    PresetElement elements[maxPresetDepth];
+    int depth = 0;
+    bool hasRoot = false;
+
+    const char* text = data;
+    const char* end = data + size;
+    while (text < end)
+    {
+        auto tagStart = static_cast<const char*>(std::memchr(text, '<', static_cast<size_t>(end - text)));
+        if (tagStart == nullptr)
+            break;
+
+        // the text of the element that is open
+        if (depth > 0 && elements[depth - 1] == PresetElement::pluginPath)
+            appendXmlText(text, tagStart, pluginPathText);
+        else if (depth > 0 && elements[depth - 1] == PresetElement::descriptors)
+            appendXmlText(text, tagStart, descriptorText);
+        text = tagStart + 1;
+
+        // the declaration, comments, CDATA and DOCTYPE
+        if (startsWith(text, end, "?"))
+        {
+            skipPast(text, end, "?>");
+            continue;
+        }
+        if (startsWith(text, end, "!--"))
+        {
+            skipPast(text, end, "-->");
+            continue;
+        }
+        if (startsWith(text, end, "![CDATA["))
+        {
+            const char* cdataStart = text + 8;
+            if (!skipPast(text, end, "]]>"))
+                return false;
+            if (depth > 0 && elements[depth - 1] == PresetElement::pluginPath)
+                pluginPathText.append(cdataStart, text - 3);
+            else if (depth > 0 && elements[depth - 1] == PresetElement::descriptors)
+                descriptorText.append(cdataStart, text - 3);
+            continue;
+        }
+        if (startsWith(text, end, "!"))
+        {
+            skipPast(text, end, ">");
+            continue;
+        }
+
+        // a closing tag, the parser trusts that it matches the element that is open
+        if (startsWith(text, end, "/"))
+        {
+            if (!skipPast(text, end, ">") || depth == 0)
+                return false;
+            --depth;
+            continue;
+        }
+
+        // an opening tag, only the elements at their expected places count
+        const char* nameStart = text;
+        while (text < end && isXmlNameCharacter(*text))
+            ++text;
+        const auto parent = depth > 0 ? elements[depth - 1] : PresetElement::other;
+        auto element = PresetElement::other;
+        if (depth == 0)
+        {
+            if (hasRoot || !matches(nameStart, text, "IdeatorPreset"))
+                return false;
+            element = PresetElement::preset;
+            hasRoot = true;
+        }
+        else if (parent == PresetElement::preset && matches(nameStart, text, "Meta"))
+            element = PresetElement::meta;
+        else if (parent == PresetElement::preset && matches(nameStart, text, "Parameters"))
+            element = PresetElement::parameters;
+        else if (parent == PresetElement::meta && matches(nameStart, text, "PluginPath"))
+            element = PresetElement::pluginPath;
+        else if (parent == PresetElement::meta && matches(nameStart, text, "Descriptors"))
+            element = PresetElement::descriptors;
+
+        hasPluginPath = hasPluginPath || element == PresetElement::pluginPath;
+        hasParameters = hasParameters || element == PresetElement::parameters;
+
+        // the attributes, only the ones of Parameters are read
+        bool isSelfClosing = false;
+        while (true)
+        {
+            while (text < end && isXmlWhitespace(*text))
+                ++text;
+            if (text >= end)
+                return false;
+            if (*text == '>')
+            {
+                ++text;
+                break;
+            }
+            if (startsWith(text, end, "/>"))
+            {
+                text += 2;
+                isSelfClosing = true;
+                break;
+            }
+
+            const char* attributeStart = text;
+            while (text < end && isXmlNameCharacter(*text))
+                ++text;
+            const char* attributeEnd = text;
+            while (text < end && isXmlWhitespace(*text))
+                ++text;
+            if (text >= end || *text != '=' || attributeStart == attributeEnd)
+                return false;
+            ++text;
+            while (text < end && isXmlWhitespace(*text))
+                ++text;
+            if (text >= end || (*text != '"' && *text != '\''))
+                return false;
+            const char quote = *text++;
+            const char* valueStart = text;
+            auto valueEnd = static_cast<const char*>(std::memchr(text, quote, static_cast<size_t>(end - text)));
+            if (valueEnd == nullptr)
+                return false;
+            text = valueEnd + 1;
+
+            // the index comes straight from the digits after "P_"
+            if (element != PresetElement::parameters || !startsWith(attributeStart, attributeEnd, "P_"))
+                continue;
+            int index = 0;
+            const char* digit = attributeStart + 2;
+            for (; digit < attributeEnd && *digit >= '0' && *digit <= '9'; ++digit)
+            {
+                index = index * 10 + (*digit - '0');
+                if (index >= maxPresetParameters)
+                    return false;
+            }
+            if (digit != attributeEnd || digit == attributeStart + 2)
+                continue;
+
+            if (static_cast<size_t>(index) >= parameters.size())
+                parameters.resize(static_cast<size_t>(index) + 1, 0.f);
+            // the same conversion as getDoubleAttribute, which stops at the closing quote
+            juce::CharPointer_ASCII value(valueStart);
+            parameters[static_cast<size_t>(index)] = static_cast<float>(juce::CharacterFunctions::readDoubleValue(value));
+        }
+
+        if (!isSelfClosing)
+        {
+            if (depth == maxPresetDepth)
+                return false;
+            elements[depth++] = element;
+        }
     }
 
-    return descriptorString;
+    if (!hasRoot || depth != 0 || !hasPluginPath || !hasParameters)
+        return false;
+
+    pluginPath = juce::String::fromUTF8(pluginPathText.data(), static_cast<int>(pluginPathText.size()));
+    descriptors = DescriptorSet::fromString(descriptorText.data(), descriptorText.size());
+    return true;
 }
 
-std::unordered_set<juce::String> PresetManager::stringToDescriptors(const juce::String& descriptorString)
+bool PresetManager::parse(const juce::File &file,
+                          std::vector<float> &parameters,
+                          juce::String &pluginPath,
+                          DescriptorSet &descriptors)
 {
-    juce::StringArray descriptorArray;
-    std::unordered_set<juce::String> descriptors;
-    descriptorArray.addTokens(descriptorString, ", &", "\"");
-    descriptorArray.removeEmptyStrings(true);
-    descriptors.clear();
-    for (auto &descriptor : descriptorArray)
-        descriptors.insert(descriptor);
-    return descriptors;
+    juce::MemoryBlock content;
+    if (!file.loadFileAsData(content))
+        return false;
+    return parse(static_cast<const char*>(content.getData()), content.getSize(), parameters, pluginPath, descriptors);
 }
+
 // ========================================
 // UdpManager
 // ========================================
 
-UdpManager::UdpManager(juce::String address, int port):
+UdpManager::UdpManager(juce::String address, int port, int messageSize):
         address(std::move(address)), port(port),
-        bufferSize((UDP_MESSAGE_SIZE - INT_SIZE*3 - BOOL_SIZE) / FLOAT_SIZE)
+        bufferSize((juce::jlimit((int) sizeof(UdpMessageHeader) + 4, 65507, messageSize)
+                    - (int) sizeof(UdpMessageHeader)) / (int) sizeof(float))
 {
-    resetMessageStruct();
 }
 
-int UdpManager::sendBuffer(const float* bufferArray, int size)
+int UdpManager::sendBuffer(const float* bufferArray, int size, int id)
 {
-    // calculate how many message it should send and the size of the last buffer
-    int numMessages = size / bufferSize;
-    int lastNumSamples;
-    if (size % bufferSize != 0)
+    // calculate how many message it should send and the size of the last buffer,
+    // set id, the receiver uses it to tell the buffers apart
+    const int numMessages = juce::jmax(1, (size + bufferSize - 1) / bufferSize);
+    std::vector<UdpMessageHeader> headers((size_t) numMessages);
+    for (int i=0; i<numMessages; ++i)
     {
-        ++numMessages;
-        lastNumSamples = size % bufferSize;
+        auto &header = headers[(size_t) i];
+        header.id = id;
+        header.index = i;
+        header.isLast = i == numMessages - 1;
+        header.numSamples = juce::jmin(bufferSize, size - i*bufferSize);
     }
-    else
-        lastNumSamples = bufferSize;
 
-    // set id
-    udpMessage.id = rand.nextInt();
+    return sendMessages(headers, bufferArray);
+}
+
+int UdpManager::sendMessages(const std::vector<UdpMessageHeader> &headers, const float* bufferArray)
+{
     int byteCounter = 0;
 
-    // send messages
-    for (int i=0; i<numMessages; ++i)
+    // a burst larger than the receive buffer of the Python program would be dropped by the OS
+    const int messageSize = (int) (sizeof(UdpMessageHeader) + sizeof(float) * (size_t) bufferSize);
+    const int numMessagesPerBurst = juce::jlimit(1, UDP_BATCH_SIZE, UDP_BURST_MAX_BYTES / messageSize);
+    auto pauseAfter = [&headers, numMessagesPerBurst] (size_t numSent)
+    {
+        if (numSent < headers.size() && numSent % (size_t) numMessagesPerBurst == 0)
+            juce::Thread::sleep(UDP_BURST_PAUSE_MS);
+    };
+
+#if JUCE_LINUX || JUCE_MAC
+    sockaddr_in destination {};
+    destination.sin_family = AF_INET;
+    destination.sin_port = htons((uint16_t) port);
+    const bool hasDestination = inet_pton(AF_INET, address.toRawUTF8(), &destination.sin_addr) == 1;
+    const int handle = socket.getRawSocketHandle();
+
+    if (hasDestination && handle >= 0)
     {
-        // check if it's the last message
-        if (i == numMessages - 1)
+        // The header and the samples are gathered by the OS, so nothing is copied here.
+        std::vector<iovec> iovecs(headers.size() * 2);
+        std::vector<msghdr> messages(headers.size());
+        for (size_t i=0; i<headers.size(); ++i)
         {
-            udpMessage.isLast = true;
-            udpMessage.numSamples = lastNumSamples;
+            iovecs[i*2].iov_base = const_cast<UdpMessageHeader*>(&headers[i]);
+            iovecs[i*2].iov_len = sizeof(UdpMessageHeader);
+            iovecs[i*2 + 1].iov_base = const_cast<float*>(bufferArray + headers[i].index * bufferSize);
+            iovecs[i*2 + 1].iov_len = sizeof(float) * (size_t) headers[i].numSamples;
+
+            messages[i] = {};
+            messages[i].msg_name = &destination;
+            messages[i].msg_namelen = sizeof(destination);
+            messages[i].msg_iov = &iovecs[i*2];
+            messages[i].msg_iovlen = 2;
         }
-        else
-            udpMessage.numSamples = bufferSize;
 
-        udpMessage.index = i;
-        memcpy(udpMessage.buffer, bufferArray + i*bufferSize, sizeof(float) * udpMessage.numSamples);
+       #if JUCE_LINUX
+        std::vector<mmsghdr> batch(headers.size());
+        for (size_t i=0; i<headers.size(); ++i)
+            batch[i].msg_hdr = messages[i];
+
+        for (size_t sent=0; sent<batch.size();)
+        {
+            // a burst ends at a multiple of numMessagesPerBurst, even after a partial send
+            const auto numToSend = (unsigned int) juce::jmin((size_t) numMessagesPerBurst - sent % (size_t) numMessagesPerBurst,
+                                                             batch.size() - sent);
+            const int numSent = sendmmsg(handle, &batch[sent], numToSend, 0);
+            if (numSent <= 0)
+                return -1;
+
+            for (int i=0; i<numSent; ++i)
+                byteCounter += (int) batch[sent + (size_t) i].msg_len;
+            sent += (size_t) numSent;
+            pauseAfter(sent);
+        }
+       #else
+        for (size_t i=0; i<messages.size(); ++i)
+        {
+            const auto writtenBytes = sendmsg(handle, &messages[i], 0);
+            if (writtenBytes == -1)
+                return -1;
+            byteCounter += (int) writtenBytes;
+            pauseAfter(i + 1);
+        }
+       #endif
+
+        return byteCounter;
+    }
+#endif
+
+    // one message at a time through a copy
+    juce::HeapBlock<char> message(sizeof(UdpMessageHeader) + sizeof(float) * (size_t) bufferSize);
+    for (const auto &header : headers)
+    {
+        const auto numBytes = sizeof(float) * (size_t) header.numSamples;
+        memcpy(message.get(), &header, sizeof(UdpMessageHeader));
+        memcpy(message.get() + sizeof(UdpMessageHeader), bufferArray + header.index * bufferSize, numBytes);
 
-        int writtenBytes = socket.write(address, port, &udpMessage, sizeof(UdpMessage));
+        int writtenBytes = socket.write(address, port, message.get(), (int) (sizeof(UdpMessageHeader) + numBytes));
         if (writtenBytes == -1)
             return -1;
         else
             byteCounter += writtenBytes;
+        pauseAfter((size_t) header.index + 1);
     }
 
-    // clean up
-    resetMessageStruct();
-
     return byteCounter;
 }
 
-void UdpManager::resetMessageStruct()
-{
-    udpMessage.id = 0;
-    udpMessage.index = 0;
-    udpMessage.isLast = false;
-    udpMessage.numSamples = 0;
-    memset(udpMessage.buffer, 0.f, bufferSize);
-}
-
 // ========================================
 // OSC Manager
 // ========================================
@@ -197,10 +506,14 @@ OSCManager::OSCManager():presetCounter(0)
                                     juce::String(OSC_RECEIVE_PORT) + ".");
 
     addListener(this, OSC_RECEIVE_PATTERN + "analyze_library");
+    addListener(this, OSC_RECEIVE_PATTERN + "analyze_batch");
     addListener(this, OSC_RECEIVE_PATTERN + "retrieve_presets/start");
     addListener(this, OSC_RECEIVE_PATTERN + "retrieve_presets/send");
     addListener(this, OSC_RECEIVE_PATTERN + "retrieve_presets/end");
     addListener(this, OSC_RECEIVE_PATTERN + "auto_tag");
+    addListener(this, OSC_RECEIVE_PATTERN + "stored_presets/start");
+    addListener(this, OSC_RECEIVE_PATTERN + "stored_presets/send");
+    addListener(this, OSC_RECEIVE_PATTERN + "stored_presets/end");
 
     // for parsing JSON dataset
     addListener(this, OSC_RECEIVE_PATTERN + "json_patch");
@@ -219,29 +532,61 @@ void OSCManager::sendRequestForPresetRetrieval(const juce::String &inputString)
     oscSender.send(msg);
 }
 
-void OSCManager::prepareToAnalyzeAudio(const juce::String& presetPath,
-                                       const std::unordered_set<juce::String>& descriptors)
+void OSCManager::requestStoredPresets(const juce::File &libraryDir)
+{
+    // the paths come back in several messages, which are kept under OSC_MAX_MESSAGE_SIZE
+    juce::OSCMessage msg(OSC_SEND_PATTERN + "stored_presets", libraryDir.getFullPathName());
+    oscSender.send(msg);
+}
+
+void OSCManager::analyzeSilentPreset(const juce::String& presetPath,
+                                     const DescriptorSet& descriptors,
+                                     int sequenceNumber,
+                                     double sampleRate,
+                                     int numSamples)
 {
-    juce::String descriptorString = PresetManager::descriptorsToString(descriptors);
-    juce::OSCMessage msg(OSC_SEND_PATTERN + "analyze_library", 1, presetPath, descriptorString);
+    // No audio buffer follows this message, the Python program stores the features of
+    // silence for the preset and replies with the sequence number as usual. The silence
+    // is as long as the rendered audio, so its features have the shape of the others.
+    juce::String descriptorString = descriptors.toString();
+    juce::OSCMessage msg(OSC_SEND_PATTERN + "analyze_library", 3, presetPath, descriptorString, sequenceNumber);
+    msg.addFloat32(static_cast<float>(sampleRate));
+    msg.addInt32(numSamples);
+    oscSender.send(msg);
+}
+
+void OSCManager::analyzeBatch(int batchId,
+                              BufferContent content,
+                              const juce::StringArray& presetPaths,
+                              const juce::StringArray& descriptorStrings)
+{
+    // The buffers of the presets follow this message in one buffer, whose id is the batch id.
+    // The Python program encodes them in one pass and replies with the batch id and every
+    // preset path with its status.
+    juce::OSCMessage msg(OSC_SEND_PATTERN + "analyze_batch", batchId, static_cast<juce::int32>(content));
+    for (int i = 0; i < presetPaths.size(); ++i)
+    {
+        msg.addString(presetPaths[i]);
+        msg.addString(descriptorStrings[i]);
+    }
     oscSender.send(msg);
 }
 
 void OSCManager::finishAnalyzeAudio()
 {
-    juce::OSCMessage msg(OSC_SEND_PATTERN + "analyze_library", 2, juce::String(""), juce::String(""));
+    juce::OSCMessage msg(OSC_SEND_PATTERN + "analyze_library", 2, juce::String(""), juce::String(""), -1);
     oscSender.send(msg);
 }
 
-void OSCManager::prepareToFindSimilar()
+void OSCManager::prepareToFindSimilar(BufferContent content, int bufferId)
 {
-    juce::OSCMessage msg(OSC_SEND_PATTERN + "find_similar", 1);
+    juce::OSCMessage msg(OSC_SEND_PATTERN + "find_similar", 1, static_cast<juce::int32>(content), bufferId);
     oscSender.send(msg);
 }
 
-void OSCManager::prepareToAutoTag()
+void OSCManager::prepareToAutoTag(BufferContent content, int bufferId)
 {
-    juce::OSCMessage msg(OSC_SEND_PATTERN + "auto_tag", 1);
+    juce::OSCMessage msg(OSC_SEND_PATTERN + "auto_tag", 1, static_cast<juce::int32>(content), bufferId);
     oscSender.send(msg);
 }
 
@@ -255,20 +600,45 @@ const juce::StringArray& OSCManager::getAutoTags()
     return autoTags;
 }
 
+const juce::StringArray& OSCManager::getStoredPresetPaths()
+{
+    return storedPresetPaths;
+}
+
+juce::Array<int> OSCManager::popAnalyzedSequenceNumbers()
+{
+    // The change messages of a broadcaster are coalesced, so the sequence numbers are
+    // collected here until the PluginManager takes them.
+    juce::Array<int> sequenceNumbers;
+    sequenceNumbers.swapWith(analyzedSequenceNumbers);
+    return sequenceNumbers;
+}
+
+juce::Array<AnalyzedPreset> OSCManager::popAnalyzedPresets()
+{
+    juce::Array<AnalyzedPreset> presets;
+    presets.swapWith(analyzedPresets);
+    return presets;
+}
+
 void OSCManager::changeDescriptors(const juce::String& presetPath,
-                                   const std::unordered_set<juce::String>& descriptors)
+                                   const DescriptorSet& descriptors)
 {
-    juce::String descriptorString = PresetManager::descriptorsToString(descriptors);
+    juce::String descriptorString = descriptors.toString();
     juce::OSCMessage msg(OSC_SEND_PATTERN + "change_descriptors", presetPath, descriptorString);
     oscSender.send(msg);
 }
 
 void OSCManager::showConnectionErrorMessage (const juce::String& messageText)
 {
+#ifdef IDEATOR_CLI
+    std::cerr << "Connection error: " << messageText << std::endl;
+#else
     juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::WarningIcon,
                                             "Connection error",
                                             messageText,
                                             "OK");
+#endif
 }
 
 void OSCManager::oscMessageReceived (const juce::OSCMessage& message)
@@ -276,12 +646,30 @@ void OSCManager::oscMessageReceived (const juce::OSCMessage& message)
     if (!pluginManager)
         return;
 
-    // The Python program send to address `analyze_library` with number 1 that
-    // indicates the audio feature has been added
+    // The Python program send to address `analyze_library` with number 1 and the sequence
+    // number of the preset that indicates the audio feature has been added
     if (juce::OSCAddressPattern(OSC_RECEIVE_PATTERN + "analyze_library")
             .matches(juce::OSCAddress(message.getAddressPattern().toString())))
     {
-        // inform other parts that the last audio buffer has been processed
+        if (message.size() < 2 || !message[1].isInt32())
+            return;
+
+        // inform other parts that an audio buffer has been processed, the acknowledgements
+        // can arrive in any order
+        analyzedSequenceNumbers.add(message[1].getInt32());
+        analysisFinishedBroadcaster.sendChangeMessage();
+    }
+
+    // The reply to a batch is the batch id followed by the path and the status of every preset in it
+    else if (juce::OSCAddressPattern(OSC_RECEIVE_PATTERN + "analyze_batch")
+            .matches(juce::OSCAddress(message.getAddressPattern().toString())))
+    {
+        for (int i = 1; i + 1 < message.size(); i += 2)
+        {
+            if (!message[i].isString() || !message[i + 1].isInt32())
+                break;
+            analyzedPresets.add({message[i].getString(), message[i + 1].getInt32() == 1});
+        }
         analysisFinishedBroadcaster.sendChangeMessage();
     }
 
@@ -296,6 +684,21 @@ void OSCManager::oscMessageReceived (const juce::OSCMessage& message)
             .matches(juce::OSCAddress(message.getAddressPattern().toString())))
         selectedPresetsReadyBroadcaster.sendChangeMessage();
 
+    // The presets of a library that the Python program has stored, many paths per message
+    else if (juce::OSCAddressPattern(OSC_RECEIVE_PATTERN + "stored_presets/start")
+            .matches(juce::OSCAddress(message.getAddressPattern().toString())))
+        storedPresetPaths.clear();
+    else if (juce::OSCAddressPattern(OSC_RECEIVE_PATTERN + "stored_presets/send")
+            .matches(juce::OSCAddress(message.getAddressPattern().toString())))
+    {
+        for (const auto &argument : message)
+            if (argument.isString())
+                storedPresetPaths.add(argument.getString());
+    }
+    else if (juce::OSCAddressPattern(OSC_RECEIVE_PATTERN + "stored_presets/end")
+            .matches(juce::OSCAddress(message.getAddressPattern().toString())))
+        storedPresetsReadyBroadcaster.sendChangeMessage();
+
     // This section is for auto-tagging
     else if (juce::OSCAddressPattern(OSC_RECEIVE_PATTERN + "auto_tag")
             .matches(juce::OSCAddress(message.getAddressPattern().toString())))
@@ -326,7 +729,7 @@ void OSCManager::oscMessageReceived (const juce::OSCMessage& message)
         for (int i=2; i<numParamsToSet*2+2; i+=2)
             pluginManager->setPluginParameter(message[i].getInt32(), message[i + 1].getFloat32());
 
-        std::unordered_set<juce::String> descriptors = PresetManager::stringToDescriptors(concatTimbreDescriptors);
+        auto descriptors = DescriptorSet::fromString(concatTimbreDescriptors);
         pluginManager->setTimbreDescriptors(descriptors);
 
         // when it comes to this stage, all the states of the preset have been set,
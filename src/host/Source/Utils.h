@@ -11,9 +11,10 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include <unordered_set>
 #include <utility>
+#include <vector>
 #include "Config.h"
+#include "DescriptorRegistry.h"
 #include <stack>
 
 // ========================================
@@ -25,49 +26,79 @@ class PresetManager
 public:
     static juce::XmlElement generate(const juce::Array<juce::AudioProcessorParameter*> &parameters,
                                      const juce::String &pluginPath,
-                                     const std::unordered_set<juce::String> &descriptors);
+                                     const DescriptorSet &descriptors);
 
     static bool parse(const juce::XmlElement &preset,
                       juce::Array<std::pair<int, float>> &parameters,
                       juce::String &pluginPath,
-                      std::unordered_set<juce::String> &descriptors);
-
-    static juce::String descriptorsToString(const std::unordered_set<juce::String>& descriptors);
+                      DescriptorSet &descriptors);
+
+    /*!
+     * Parses a preset in a single pass over the content of its file, without building an XML
+     * document or a string for every parameter. The array keeps its capacity, so reusing it
+     * for many presets doesn't allocate.
+     * @param data the content of the preset file, in UTF-8
+     * @param size the size of the content in bytes
+     * @param parameters receives the value of P_i at index i, the missing ones are 0
+     * @param pluginPath receives the path to the plugin
+     * @param descriptors receives the descriptors
+     * @return false if the content is not a complete IdeatorPreset
+     */
+    static bool parse(const char* data,
+                      size_t size,
+                      std::vector<float> &parameters,
+                      juce::String &pluginPath,
+                      DescriptorSet &descriptors);
+
+    /*!
+     * Reads a preset file and parses it with the single-pass parser.
+     * @return false if the file cannot be read or is not a complete IdeatorPreset
+     */
+    static bool parse(const juce::File &file,
+                      std::vector<float> &parameters,
+                      juce::String &pluginPath,
+                      DescriptorSet &descriptors);
 
-    static std::unordered_set<juce::String> stringToDescriptors(const juce::String& descriptorString);
 };
 
 // ========================================
 // UdpManager
 // ========================================
 
-const int FLOAT_SIZE = sizeof (float);
-const int INT_SIZE = sizeof (int);
-const int BOOL_SIZE = sizeof (bool);
-
+// Sends a buffer in UDP messages. Every message starts with a header and carries up to
+// (messageSize - header size) / 4 samples, the last one only carries the samples it has.
+// The messages are handed to the OS in batches where possible (sendmmsg on Linux), and a large
+// buffer is paced in bursts of UDP_BURST_MAX_BYTES, so the receiver's socket buffer doesn't overflow.
 class UdpManager
 {
 public:
-    UdpManager(juce::String address, int port);
-    int sendBuffer(const float* bufferArray, int size);
+    /*!
+     * @param address the address of the receiver
+     * @param port the port of the receiver
+     * @param messageSize the maximum size of a message including its header, at most 65507 bytes
+     */
+    UdpManager(juce::String address, int port, int messageSize = UDP_MESSAGE_SIZE);
+
+    /*!
+     * @return the number of bytes sent, or -1 if an error occurred
+     */
+    int sendBuffer(const float* bufferArray, int size, int id);
 
 private:
-    const juce::String address;
-    const int port;
-    const int bufferSize;
-    juce::Random rand;
-    juce::DatagramSocket socket;
-
-    struct UdpMessage
+    struct UdpMessageHeader
     {
         int id;
         int index;
         bool isLast;
         int numSamples;
-        float buffer[(UDP_MESSAGE_SIZE - INT_SIZE*3 - BOOL_SIZE) / FLOAT_SIZE];
-    } udpMessage;
+    };
 
-    void resetMessageStruct();
+    int sendMessages(const std::vector<UdpMessageHeader> &headers, const float* bufferArray);
+
+    const juce::String address;
+    const int port;
+    const int bufferSize; // the maximum number of samples in a message
+    juce::DatagramSocket socket;
 };
 
 // ========================================
@@ -75,6 +106,21 @@ private:
 // ========================================
 class PluginManager;
 
+// what a buffer sent to the Python program holds, the value is the last argument of the OSC message before it
+enum class BufferContent
+{
+    audio = 0,          // the rendered audio
+    melSpectrogram = 1, // the output of MelSpectrogram
+    latent = 2          // the output of LatentEncoder, the Python program doesn't need to encode it
+};
+
+// the reply of the Python program for a preset of a batch
+struct AnalyzedPreset
+{
+    juce::String presetPath;
+    bool isAnalyzed = false; // false if the buffer of the batch has been lost
+};
+
 class OSCManager: private juce::OSCReceiver,
                   private juce::OSCReceiver::ListenerWithOSCAddress<juce::OSCReceiver::MessageLoopCallback>
 {
@@ -84,30 +130,49 @@ public:
 
     // The following methods should only be called in the interface
     void sendRequestForPresetRetrieval(const juce::String &tags);
+    // asks the Python program which presets of a library it has stored, see getStoredPresetPaths
+    void requestStoredPresets(const juce::File &libraryDir);
 
     // The following methods should only be called in PluginManager
-    void prepareToAnalyzeAudio(const juce::String& presetPath,
-                               const std::unordered_set<juce::String>& descriptors);
+    void analyzeSilentPreset(const juce::String& presetPath,
+                             const DescriptorSet& descriptors,
+                             int sequenceNumber,
+                             double sampleRate,
+                             int numSamples);
+    void analyzeBatch(int batchId,
+                      BufferContent content,
+                      const juce::StringArray& presetPaths,
+                      const juce::StringArray& descriptorStrings);
     void finishAnalyzeAudio();
-    void prepareToFindSimilar();
-    void prepareToAutoTag();
+    void prepareToFindSimilar(BufferContent content, int bufferId);
+    void prepareToAutoTag(BufferContent content, int bufferId);
     void changeDescriptors(const juce::String& presetPath,
-                           const std::unordered_set<juce::String>& descriptors);
+                           const DescriptorSet& descriptors);
 
     // the following methods should only be called in Interface
     const juce::StringArray& getSelectedPresetPaths();
     const juce::StringArray& getAutoTags();
+    // the presets of the library that are in the cache of the Python program, a path lost on the way is left out
+    const juce::StringArray& getStoredPresetPaths();
+
+    // the following methods should only be called in PluginManager
+    juce::Array<int> popAnalyzedSequenceNumbers();
+    juce::Array<AnalyzedPreset> popAnalyzedPresets();
 
     // other class should NOT call any method of the broadcasters other than addListener
     juce::ChangeBroadcaster analysisFinishedBroadcaster;
     juce::ChangeBroadcaster selectedPresetsReadyBroadcaster;
     juce::ChangeBroadcaster autoTagsReadyBroadcaster;
+    juce::ChangeBroadcaster storedPresetsReadyBroadcaster;
 private:
     PluginManager *pluginManager;
     int presetCounter;
     juce::OSCSender oscSender;
     juce::StringArray selectedPresetPaths;
     juce::StringArray autoTags;
+    juce::StringArray storedPresetPaths;
+    juce::Array<int> analyzedSequenceNumbers;
+    juce::Array<AnalyzedPreset> analyzedPresets;
 
     static void showConnectionErrorMessage (const juce::String& messageText);
     void oscMessageReceived (const juce::OSCMessage& message) override;